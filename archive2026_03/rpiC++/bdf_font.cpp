@@ -0,0 +1,126 @@
+// bdf_font.cpp - BDF parser
+
+#include "bdf_font.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+
+bool BdfFont::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    size_t slash = path.find_last_of('/');
+    name_ = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    if (name_.size() > 4 && name_.compare(name_.size() - 4, 4, ".bdf") == 0) {
+        name_.resize(name_.size() - 4);
+    }
+
+    int bbox_h = 0, bbox_y = 0;
+    bool have_ascent = false, have_descent = false;
+    int code = -1;
+    BdfGlyph g;
+    int bbx_h = 0;
+    int bitmap_rows = -1;  // Rows still to read, -1 outside BITMAP
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (bitmap_rows > 0) {
+            // Hex row, left-aligned; the first 32 pixels are all we keep
+            std::string hex = line.substr(0, 8);
+            uint32_t bits = (uint32_t)strtoul(hex.c_str(), nullptr, 16);
+            g.rows.push_back(hex.empty() ? 0 : bits << (32 - 4 * hex.size()));
+            bitmap_rows--;
+            continue;
+        }
+
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        if (key == "FONTBOUNDINGBOX") {
+            int w;
+            in >> w >> bbox_h >> w >> bbox_y;
+        } else if (key == "FONT_ASCENT") {
+            in >> ascent_;
+            have_ascent = true;
+        } else if (key == "FONT_DESCENT") {
+            in >> descent_;
+            have_descent = true;
+        } else if (key == "STARTCHAR") {
+            code = -1;
+            g = BdfGlyph();
+            bbx_h = 0;
+        } else if (key == "ENCODING") {
+            in >> code;
+        } else if (key == "DWIDTH") {
+            in >> g.advance;
+        } else if (key == "BBX") {
+            int y_off;
+            in >> g.width >> bbx_h >> g.left >> y_off;
+            g.top = bbx_h + y_off;
+        } else if (key == "BITMAP") {
+            bitmap_rows = bbx_h;
+        } else if (key == "ENDCHAR") {
+            bitmap_rows = -1;
+            if (code >= 0 && code < 256 && g.width <= 32 && (int)g.rows.size() == bbx_h) {
+                g.defined = true;
+                glyphs_[code] = std::move(g);
+            }
+        }
+    }
+
+    if (!have_ascent) ascent_ = bbox_h + bbox_y;
+    if (!have_descent) descent_ = -bbox_y;
+    return height() > 0 && std::any_of(std::begin(glyphs_), std::end(glyphs_),
+                                       [](const BdfGlyph& g) { return g.defined; });
+}
+
+bool BdfFont::covers(const std::string& text) const {
+    for (char c : text) {
+        if (!glyph(c)) return false;
+    }
+    return true;
+}
+
+int BdfFont::textWidth(const std::string& text) const {
+    int width = 0;
+    for (char c : text) {
+        const BdfGlyph* g = glyph(c);
+        if (g) width += g->advance;
+    }
+    return width;
+}
+
+std::vector<BdfFont> loadBdfFonts(const std::string& dir) {
+    std::vector<BdfFont> fonts;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return fonts;
+
+    std::vector<std::string> paths;
+    while (struct dirent* e = readdir(d)) {
+        size_t len = strlen(e->d_name);
+        if (len > 4 && strcmp(e->d_name + len - 4, ".bdf") == 0) {
+            paths.push_back(dir + "/" + e->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(paths.begin(), paths.end());  // Same pick among equal heights on every run
+
+    for (const auto& path : paths) {
+        BdfFont font;
+        if (font.load(path)) {
+            fonts.push_back(std::move(font));
+        } else {
+            std::cerr << "[RENDER] Skipping unreadable BDF font " << path << std::endl;
+        }
+    }
+    std::stable_sort(fonts.begin(), fonts.end(),
+                     [](const BdfFont& a, const BdfFont& b) { return a.height() > b.height(); });
+    return fonts;
+}
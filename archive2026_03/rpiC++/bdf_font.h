@@ -0,0 +1,55 @@
+// bdf_font.h - BDF bitmap fonts, pre-packed as one bitmask per glyph row
+//
+// Below about 10 px an outline font turns to mush, while a bitmap font
+// drawn at its own size stays pixel-exact. Glyphs are kept as a 32-bit
+// mask per row (leftmost pixel in bit 31), so drawing one is a handful of
+// shifts per row. The rpi-rgb-led-matrix checkout ships a set of BDF fonts
+// (install.sh copies them to BDF_FONT_DIR).
+//
+// Only encodings 0-255 are kept (segment text is drawn byte by byte) and
+// glyphs wider than 32 pixels are skipped.
+
+#ifndef BDF_FONT_H
+#define BDF_FONT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BdfGlyph {
+    bool defined = false;
+    int advance = 0;              // DWIDTH
+    int left = 0;                 // BBX x offset
+    int top = 0;                  // Rows above the baseline (BBX height + y offset)
+    int width = 0;
+    std::vector<uint32_t> rows;   // One mask per row, top first
+};
+
+class BdfFont {
+public:
+    bool load(const std::string& path);
+
+    const std::string& name() const { return name_; }
+    int ascent() const { return ascent_; }
+    int height() const { return ascent_ + descent_; }
+
+    const BdfGlyph* glyph(char c) const {
+        const BdfGlyph& g = glyphs_[(uint8_t)c];
+        return g.defined ? &g : nullptr;
+    }
+
+    // Whether every character of `text` has a glyph
+    bool covers(const std::string& text) const;
+    int textWidth(const std::string& text) const;
+
+private:
+    std::string name_;
+    int ascent_ = 0;
+    int descent_ = 0;
+    BdfGlyph glyphs_[256];
+};
+
+// Every *.bdf in `dir`, tallest first
+std::vector<BdfFont> loadBdfFonts(const std::string& dir);
+
+#endif // BDF_FONT_H
@@ -0,0 +1,479 @@
+// bench.cpp - Microbenchmarks for the text, segment and dispatch hot paths
+//
+//   make bench                      build, run, write bench-results/<rev>-<host>.{csv,json}
+//   ./led-matrix-bench [--filter text/] [--csv FILE] [--json FILE]
+//
+// Each case runs in batches sized to about BENCH_BATCH_MS; the median and
+// the best batch are reported in nanoseconds per operation. Results carry
+// the git revision and board model so runs can be compared across commits
+// and hardware. Renders go to a HeadlessBackend, so no panel is needed.
+//
+// brightness / rotation / orientation / group are not dispatched: they
+// rewrite config.json and ask the daemon to restart.
+
+#include "text_renderer.h"
+#include "segment_manager.h"
+#include "udp_handler.h"
+#include "headless_backend.h"
+#include "kernels.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <sys/utsname.h>
+
+#ifndef BENCH_GIT_REV
+#define BENCH_GIT_REV "unknown"
+#endif
+
+#define BENCH_BATCH_MS  10   // Target duration of one timed batch
+#define BENCH_BATCHES   15   // Batches per case (median / min reported)
+
+using json = nlohmann::json;
+
+UDPHandler* g_udp_handler = nullptr;  // text_renderer.cpp expects it (main.cpp defines it in the daemon)
+
+// Private TextRenderer paths the daemon only reaches through renderAll()
+struct BenchAccess {
+    static void measureText(TextRenderer& r, const std::string& text, int size) {
+        r.measureText(text, "arial", size);
+    }
+    static void fitText(TextRenderer& r, const std::string& text, int w, int h) {
+        r.fitText(text, "arial", w, h);
+    }
+    static void clearMeasureCache(TextRenderer& r) {
+        r.text_measurement_cache_.clear();
+    }
+    static void renderSegment(TextRenderer& r, const Segment& seg) {
+        r.renderSegment(seg);
+    }
+};
+
+namespace {
+
+struct Result {
+    std::string group;
+    std::string name;
+    std::string params;
+    uint64_t batch_ops;
+    double ns_median;
+    double ns_min;
+};
+
+std::vector<Result> g_results;
+std::string g_filter;
+std::ostream* g_out;  // Real stdout; std::cout is muted while cases run
+
+// Keep the optimiser from discarding a result
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+template <typename Fn>
+double timeBatch(uint64_t ops, Fn& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < ops; i++) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+template <typename Fn>
+void run(const std::string& group, const std::string& name, const std::string& params, Fn fn) {
+    std::string id = group + "/" + name + " " + params;
+    if (!g_filter.empty() && id.find(g_filter) == std::string::npos) return;
+
+    // Grow the batch until it takes long enough to time (also warms caches)
+    uint64_t ops = 1;
+    while (timeBatch(ops, fn) < BENCH_BATCH_MS * 1e6 && ops < (1ull << 30)) {
+        ops *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < BENCH_BATCHES; i++) {
+        samples.push_back(timeBatch(ops, fn) / ops);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result r = {group, name, params, ops, samples[samples.size() / 2], samples[0]};
+    g_results.push_back(r);
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %-18s %-30s %12.0f ns %12.0f ns\n",
+             group.c_str(), name.c_str(), params.c_str(), r.ns_median, r.ns_min);
+    *g_out << line << std::flush;
+}
+
+// Runs `fn` on `count` threads until the returned guard goes out of scope
+class Background {
+public:
+    template <typename Fn>
+    Background(int count, Fn fn) : stop_(false) {
+        for (int i = 0; i < count; i++) {
+            threads_.emplace_back([this, fn, i]() {
+                uint64_t n = 0;
+                while (!stop_.load(std::memory_order_relaxed)) {
+                    fn(i, n++);
+                }
+            });
+        }
+    }
+    ~Background() {
+        stop_ = true;
+        for (auto& t : threads_) t.join();
+    }
+
+private:
+    std::atomic<bool> stop_;
+    std::vector<std::thread> threads_;
+};
+
+std::string textOfLength(int length) {
+    static const char sample[] = "The quick brown fox jumps over the lazy dog 0123456789 ";
+    std::string text;
+    for (int i = 0; i < length; i++) {
+        text += sample[i % (sizeof(sample) - 1)];
+    }
+    return text;
+}
+
+std::string boardModel() {
+    std::ifstream model("/proc/device-tree/model");
+    std::string line;
+    if (model && std::getline(model, line, '\0') && !line.empty()) return line;
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(colon + 2);
+        }
+    }
+    struct utsname uts;
+    return uname(&uts) == 0 ? uts.machine : "unknown";
+}
+
+// ─── Cases ───────────────────────────────────────────────────────────────────
+
+const int LENGTHS[] = {4, 16, 64, 128};
+
+struct Size { int w, h; };
+const Size SIZES[] = {{64, 32}, {32, 32}, {32, 16}};  // Full, half, quarter panel
+
+std::string sizeName(const Size& s) {
+    return std::to_string(s.w) + "x" + std::to_string(s.h);
+}
+
+void benchText(TextRenderer& renderer) {
+    for (int length : LENGTHS) {
+        std::string text = textOfLength(length);
+        std::string params = "len=" + std::to_string(length);
+        run("text", "measure_cached", params, [&]() {
+            BenchAccess::measureText(renderer, text, 16);
+        });
+        run("text", "measure_uncached", params, [&]() {
+            BenchAccess::clearMeasureCache(renderer);
+            BenchAccess::measureText(renderer, text, 16);
+        });
+    }
+    for (const Size& size : SIZES) {
+        for (int length : LENGTHS) {
+            std::string text = textOfLength(length);
+            std::string params = "len=" + std::to_string(length) + " seg=" + sizeName(size);
+            run("text", "fit_cached", params, [&]() {
+                BenchAccess::fitText(renderer, text, size.w - 2, size.h - 2);
+            });
+            run("text", "fit_uncached", params, [&]() {
+                BenchAccess::clearMeasureCache(renderer);
+                BenchAccess::fitText(renderer, text, size.w - 2, size.h - 2);
+            });
+        }
+    }
+}
+
+void benchRender(TextRenderer& renderer) {
+    const struct { Effect effect; const char* name; } effects[] = {
+        {EFFECT_NONE, "none"}, {EFFECT_SCROLL, "scroll"}, {EFFECT_BLINK, "blink"}, {EFFECT_FADE, "fade"}
+    };
+    for (const Size& size : SIZES) {
+        for (const auto& e : effects) {
+            Segment seg(0, 0, 0, size.w, size.h);
+            seg.text = "Gate 12 Boarding";
+            seg.effect = e.effect;
+            seg.is_active = true;
+            std::string params = std::string("effect=") + e.name + " seg=" + sizeName(size);
+            run("render", "segment", params, [&]() {
+                // Scroll moves a pixel per frame; blink alternates drawn / blank;
+                // fade steps through the partial alphas (always blended)
+                seg.scroll_offset++;
+                seg.blink_state = !seg.blink_state;
+                seg.fade_alpha = (uint8_t)(seg.fade_alpha % 254 + 1);
+                BenchAccess::renderSegment(renderer, seg);
+            });
+        }
+        Segment framed(0, 0, 0, size.w, size.h);
+        framed.text = "Gate 12 Boarding";
+        framed.is_active = true;
+        framed.frame_enabled = true;
+        run("render", "segment", "effect=none frame=2 seg=" + sizeName(size), [&]() {
+            BenchAccess::renderSegment(renderer, framed);
+        });
+        Segment smooth(0, 0, 0, size.w, size.h);
+        smooth.text = "Gate 12 Boarding";
+        smooth.is_active = true;
+        smooth.antialias = true;
+        run("render", "segment", "effect=none aa=1 seg=" + sizeName(size), [&]() {
+            BenchAccess::renderSegment(renderer, smooth);
+        });
+        // Small text in a bitmap font (the golden fixtures) against the same text in TrueType
+        Segment clock(0, 0, 0, size.w, size.h);
+        clock.text = "10:45:30";
+        clock.is_active = true;
+        run("render", "segment", "effect=none font=arial text=clock seg=" + sizeName(size), [&]() {
+            BenchAccess::renderSegment(renderer, clock);
+        });
+        clock.font_name = "bitmap";
+        run("render", "segment", "effect=none font=bitmap text=clock seg=" + sizeName(size), [&]() {
+            BenchAccess::renderSegment(renderer, clock);
+        });
+    }
+}
+
+// Stands in for the rgbmatrix canvas: a bounds-checked SetPixel
+struct BenchCanvas {
+    Framebuffer fb;
+    void SetPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) { fb.setPixel(x, y, r, g, b); }
+};
+
+// Specialized against generic kernels for one panel geometry
+template <int W, int H>
+void benchKernelGeometry() {
+    std::string geometry = std::to_string(W) + "x" + std::to_string(H);
+    Framebuffer fb(W, H);
+    const RowBand all = {0, H};
+    BenchCanvas canvas;
+    canvas.fb.resize(W, H);
+    const struct { const RenderKernels* kernels; const char* name; } variants[] = {
+        {&genericKernels(), "generic"}, {&selectKernels(W, H), "specialized"}
+    };
+    for (const auto& v : variants) {
+        std::string params = std::string("kernel=") + v.name + " canvas=" + geometry;
+        run("kernel", "fill/canvas", params, [&]() {
+            v.kernels->fill_rect(fb, all, 0, 0, W, H, 10, 20, 30);
+            keep(fb.pixels[0]);
+        });
+        run("kernel", "fill/segment", params, [&]() {
+            v.kernels->fill_rect(fb, all, W / 2, 0, W / 2, H / 2, 10, 20, 30);
+            keep(fb.pixels[0]);
+        });
+        run("kernel", "frame", params + " width=2", [&]() {
+            v.kernels->frame_rect(fb, all, 0, 0, W, H, 2, 255, 255, 255);
+            keep(fb.pixels[0]);
+        });
+    }
+    run("kernel", "blit", "kernel=specialized canvas=" + geometry, [&]() {
+        blitPixels<W, H>(fb, &canvas);
+        keep(canvas.fb.pixels[0]);
+    });
+    run("kernel", "blit", "kernel=generic canvas=" + geometry, [&]() {
+        blitPixels<0, 0>(fb, &canvas);
+        keep(canvas.fb.pixels[0]);
+    });
+}
+
+void benchKernels() {
+    benchKernelGeometry<64, 32>();
+    benchKernelGeometry<64, 64>();
+    benchKernelGeometry<128, 32>();
+}
+
+// Whole frames of four quads on a panel wall, composed in 1 ... 4 bands
+void benchWall(int width, int height) {
+    std::string canvas = std::to_string(width) + "x" + std::to_string(height);
+    const char* texts[MAX_SEGMENTS] = {"Platform 4", "Departs 12:05", "Gate 12 Boarding", "On time"};
+    for (int tiles : {1, 2, 4}) {
+        SegmentManager sm;
+        sm.resetLayout(width, height);
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            sm.configure(i, (i % 2) * width / 2, (i / 2) * height / 2, width / 2, height / 2);
+            sm.activate(i, true);
+            sm.updateText(i, texts[i], "FFFFFF", "000040", "C", "none", 255, "arial", 0, "", i % 2);
+        }
+        sm.setFrame(3, true, "FF0000", 2);
+        HeadlessBackend display(width, height);
+        TextRenderer renderer(&display, &sm);
+        renderer.setRenderTiles(tiles);
+        run("render", "frame", "canvas=" + canvas + " tiles=" + std::to_string(tiles), [&]() {
+            sm.markAllDirty();
+            renderer.renderAll();
+        });
+    }
+}
+
+void benchSegments() {
+    SegmentManager sm;
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        sm.activate(i, true);
+        sm.updateText(i, textOfLength(16));
+    }
+    const char* texts[2] = {"Platform 1", "Platform 2"};
+
+    for (int writers : {0, 1, 3}) {
+        Background load(writers, [&](int id, uint64_t n) {
+            sm.updateText(id % MAX_SEGMENTS, texts[n & 1]);
+        });
+        run("segment", "snapshot", "writers=" + std::to_string(writers), [&]() {
+            bool any_dirty;
+            std::vector<Segment> snapshot = sm.getRenderSnapshot(any_dirty);
+            keep(snapshot);
+        });
+    }
+    for (int readers : {0, 1}) {
+        Background load(readers, [&](int, uint64_t) {
+            bool any_dirty;
+            std::vector<Segment> snapshot = sm.getRenderSnapshot(any_dirty);
+            keep(snapshot);
+        });
+        uint64_t n = 0;
+        run("segment", "update_text", "readers=" + std::to_string(readers), [&]() {
+            sm.updateText(0, texts[n++ & 1]);
+        });
+    }
+}
+
+void benchDispatch() {
+    SegmentManager sm;
+    UDPHandler handler(&sm);
+
+    // Two variants per command so repeated dispatches are not all no-ops
+    const struct { const char* name; const char* a; const char* b; } commands[] = {
+        {"text",      R"({"cmd":"text","seg":0,"text":"Platform 1","color":"FFFFFF","align":"C"})",
+                      R"({"cmd":"text","seg":0,"text":"Platform 2","color":"FFFF00","align":"C"})"},
+        {"layout",    R"({"cmd":"layout","preset":1})", R"({"cmd":"layout","preset":2})"},
+        {"clear",     R"({"cmd":"clear","seg":0})", R"({"cmd":"clear","seg":2})"},
+        {"clear_all", R"({"cmd":"clear_all"})", R"({"cmd":"clear_all"})"},
+        {"config",    R"({"cmd":"config","seg":0,"x":0,"y":0,"w":64,"h":32})",
+                      R"({"cmd":"config","seg":0,"x":0,"y":0,"w":32,"h":32})"},
+        {"frame",     R"({"cmd":"frame","seg":0,"enabled":true,"color":"FF0000","width":1})",
+                      R"({"cmd":"frame","seg":0,"enabled":false})"},
+        {"prepare",   R"({"cmd":"text","seg":0,"text":"Staged 1","prepare":true})",
+                      R"({"cmd":"text","seg":0,"text":"Staged 2","prepare":true})"},
+        {"commit",    R"({"cmd":"commit"})", R"({"cmd":"commit"})"},
+        {"clock",     R"({"cmd":"clock","t":1000})", R"({"cmd":"clock","t":2000})"},
+        {"other_group", R"({"cmd":"text","seg":0,"text":"x","group":9})",
+                        R"({"cmd":"text","seg":0,"text":"y","group":9})"},
+        {"invalid",   R"({"cmd":"text",)", R"(not json)"},
+    };
+    for (const auto& c : commands) {
+        std::string a = c.a, b = c.b;
+        uint64_t n = 0;
+        run("dispatch", c.name, "", [&]() {
+            handler.dispatch((n++ & 1) ? b : a);
+        });
+        sm.discardStaged();
+        bool any_dirty;
+        sm.getRenderSnapshot(any_dirty);
+    }
+}
+
+// ─── Output ──────────────────────────────────────────────────────────────────
+
+bool writeCsv(const std::string& path, const std::string& board) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "group,name,params,batch_ops,ns_per_op_median,ns_per_op_min,commit,board\n";
+    for (const Result& r : g_results) {
+        out << r.group << "," << r.name << "," << r.params << "," << r.batch_ops << ","
+            << r.ns_median << "," << r.ns_min << "," << BENCH_GIT_REV << ",\"" << board << "\"\n";
+    }
+    return (bool)out;
+}
+
+bool writeJson(const std::string& path, const std::string& board) {
+    struct utsname uts;
+    uname(&uts);
+    json doc;
+    doc["commit"] = BENCH_GIT_REV;
+    doc["board"] = board;
+    doc["host"] = uts.nodename;
+    doc["kernel"] = uts.release;
+    doc["timestamp"] = (uint64_t)time(nullptr);
+    doc["batch_ms"] = BENCH_BATCH_MS;
+    doc["batches"] = BENCH_BATCHES;
+    doc["results"] = json::array();
+    for (const Result& r : g_results) {
+        doc["results"].push_back({
+            {"group", r.group}, {"name", r.name}, {"params", r.params},
+            {"batch_ops", r.batch_ops}, {"ns_per_op_median", r.ns_median}, {"ns_per_op_min", r.ns_min}
+        });
+    }
+    std::ofstream out(path);
+    out << doc.dump(2) << "\n";
+    return (bool)out;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string csv_path, json_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            g_filter = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter SUBSTRING] [--csv FILE] [--json FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    // The daemon's own logging would dominate some cases
+    std::ostream out(std::cout.rdbuf());
+    std::streambuf* err_buf = std::cerr.rdbuf();
+    g_out = &out;
+    std::cout.rdbuf(nullptr);
+    std::cerr.rdbuf(nullptr);
+
+    std::string board = boardModel();
+    out << "led-matrix bench @ " << BENCH_GIT_REV << " on " << board << std::endl;
+    char header[160];
+    snprintf(header, sizeof(header), "%-10s %-18s %-30s %15s %15s\n", "group", "case", "params", "median/op", "best/op");
+    out << header;
+
+    {
+        SegmentManager sm;
+        HeadlessBackend display(MATRIX_WIDTH, MATRIX_HEIGHT);
+        TextRenderer renderer(&display, &sm);
+        renderer.loadBitmapFonts("golden/fonts");
+        benchText(renderer);
+        benchRender(renderer);
+    }
+    benchKernels();
+    benchWall(128, 64);
+    benchWall(256, 64);
+    benchSegments();
+    benchDispatch();
+    std::cerr.rdbuf(err_buf);
+    std::cerr.clear();
+
+    if (!csv_path.empty() && !writeCsv(csv_path, board)) {
+        std::cerr << "Cannot write " << csv_path << std::endl;
+        return 1;
+    }
+    if (!json_path.empty() && !writeJson(json_path, board)) {
+        std::cerr << "Cannot write " << json_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
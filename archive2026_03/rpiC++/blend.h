@@ -0,0 +1,50 @@
+// blend.h - 8-bit alpha blending
+//
+// AlphaLut: mul[a][v] = round(v * a / 255), for scaling values that are
+// fixed per segment (colours, alpha tables). The 64 KB table is built on
+// first use.
+//
+// blendSpan: the per-pixel blend of a run of pixels towards one colour,
+// in plain integer arithmetic so -O3 vectorizes it (NEON on the Pi).
+
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <cstdint>
+
+struct AlphaLut {
+    uint8_t mul[256][256];
+
+    AlphaLut() {
+        for (int a = 0; a < 256; a++) {
+            for (int v = 0; v < 256; v++) {
+                mul[a][v] = (uint8_t)((v * a + 127) / 255);
+            }
+        }
+    }
+};
+
+inline const AlphaLut& alphaLut() {
+    static const AlphaLut lut;
+    return lut;
+}
+
+// round(v / 255) for 0 <= v <= 255 * 255
+inline uint8_t div255(unsigned v) {
+    v += 128;
+    return (uint8_t)((v + (v >> 8)) >> 8);
+}
+
+// dst[i] = colour * alpha[i] + dst[i] * (255 - alpha[i]), for n RGB pixels
+inline void blendSpan(uint8_t* dst, const uint8_t* alpha, int n, uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < n; i++) {
+        unsigned a = alpha[i];
+        unsigned na = 255 - a;
+        uint8_t* p = dst + i * 3;
+        p[0] = div255(r * a + p[0] * na);
+        p[1] = div255(g * a + p[1] * na);
+        p[2] = div255(b * a + p[2] * na);
+    }
+}
+
+#endif // BLEND_H
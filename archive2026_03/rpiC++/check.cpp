@@ -0,0 +1,657 @@
+// check.cpp - Unit checks for the wire-format and protocol code
+//
+//   make check                      build and run every check
+//   ./led-matrix-check [--filter SUBSTRING]
+//
+// The golden suite covers what reaches the panel; these cover input that
+// must be refused before it gets that far: hostile sizes, truncated data,
+// out-of-range coordinates - and protocol rules that frames alone can't show,
+// such as what is visible before a staged commit. Each failed CHECK prints
+// its line.
+
+#include "http_parser.h"
+#include "frame_codec.h"
+#include "glyph_cache.h"
+#include "pixel_stream.h"
+#include "udp_handler.h"
+#include "text_renderer.h"
+#include "headless_backend.h"
+#include "web_server.h"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+UDPHandler* g_udp_handler = nullptr;  // text_renderer.cpp reads orientation / layout through it
+
+namespace {
+
+// Collected while a check runs, printed after (the code under test logs)
+std::vector<std::string> g_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            g_failures.push_back(std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": CHECK(" #cond ") failed"); \
+        } \
+    } while (0)
+
+// ─── HTTP Parser ─────────────────────────────────────────────────────────────
+
+// Feeds the whole request at once; the parser leaves pipelined bytes behind
+HttpParser::State parse(HttpParser& parser, std::string data) {
+    return parser.feed(data);
+}
+
+const std::string CHUNKED_HEAD = "POST /api/text HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n";
+
+void checkHttpChunked() {
+    HttpParser parser;
+    CHECK(parse(parser, CHUNKED_HEAD + "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\n\r\n") == HttpParser::COMPLETE);
+    CHECK(parser.request().body == "hello world");
+
+    // Fed a byte at a time, the same request completes on its last byte
+    HttpParser slow;
+    std::string buffer;
+    std::string request = CHUNKED_HEAD + "3\r\nabc\r\n0\r\nX-Trailer: 1\r\n\r\n";
+    HttpParser::State state = HttpParser::READING;
+    for (char c : request) {
+        CHECK(state == HttpParser::READING);
+        buffer += c;
+        state = slow.feed(buffer);
+    }
+    CHECK(state == HttpParser::COMPLETE);
+    CHECK(slow.request().body == "abc");
+}
+
+void checkHttpChunkSizeOverflow() {
+    // A saturated chunk size after one byte of body used to wrap the limit check
+    HttpParser parser;
+    CHECK(parse(parser, CHUNKED_HEAD + "1\r\na\r\nFFFFFFFFFFFFFFFF\r\n") == HttpParser::ERROR);
+    CHECK(parser.errorStatus() == 413);
+
+    HttpParser range;
+    CHECK(parse(range, CHUNKED_HEAD + "1FFFFFFFFFFFFFFFFFF\r\n") == HttpParser::ERROR);
+    CHECK(range.errorStatus() == 413);
+
+    HttpParser over;
+    CHECK(parse(over, CHUNKED_HEAD + "1\r\na\r\n40000\r\n") == HttpParser::ERROR);
+    CHECK(over.errorStatus() == 413);
+
+    HttpParser garbage;
+    CHECK(parse(garbage, CHUNKED_HEAD + "zz\r\n") == HttpParser::ERROR);
+    CHECK(garbage.errorStatus() == 400);
+}
+
+void checkHttpBodyLimits() {
+    HttpParser parser;
+    CHECK(parse(parser, "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n") == HttpParser::ERROR);
+    CHECK(parser.errorStatus() == 413);
+
+    HttpParser head;
+    CHECK(parse(head, "GET / HTTP/1.1\r\nX: " + std::string(HTTP_MAX_HEADER_BYTES, 'a')) == HttpParser::ERROR);
+    CHECK(head.errorStatus() == 431);
+}
+
+void checkHttpTrailerLimits() {
+    // One endless trailer line
+    HttpParser line;
+    CHECK(parse(line, CHUNKED_HEAD + "0\r\nX: " + std::string(HTTP_MAX_HEADER_BYTES, 'a')) == HttpParser::ERROR);
+    CHECK(line.errorStatus() == 431);
+
+    // Many short ones
+    std::string many = CHUNKED_HEAD + "0\r\n";
+    while (many.size() < CHUNKED_HEAD.size() + HTTP_MAX_HEADER_BYTES + 16) many += "X: 1\r\n";
+    HttpParser lines;
+    CHECK(parse(lines, many) == HttpParser::ERROR);
+    CHECK(lines.errorStatus() == 431);
+
+    // The allowance is per request, not per connection
+    HttpParser reused;
+    std::string small = CHUNKED_HEAD + "0\r\n" + std::string("X: 1\r\n") + "\r\n";
+    for (int i = 0; i < 2000; i++) {
+        CHECK(parse(reused, small) == HttpParser::COMPLETE);
+        reused.reset();
+    }
+}
+
+// ─── Frame Codec ─────────────────────────────────────────────────────────────
+
+// Pixels with long runs, short runs and noise, reproducible per seed
+std::vector<uint8_t> testPixels(size_t count, unsigned seed) {
+    srand(seed);
+    std::vector<uint8_t> px;
+    while (px.size() < count * 3) {
+        uint8_t r = rand() & 0xff, g = rand() & 0xff, b = rand() & 0xff;
+        size_t run = (rand() % 4 == 0) ? 1 + rand() % 300 : 1;
+        for (size_t i = 0; i < run && px.size() < count * 3; i++) {
+            px.push_back(r);
+            px.push_back(g);
+            px.push_back(b);
+        }
+    }
+    return px;
+}
+
+bool decodes(const std::vector<uint8_t>& rle, std::vector<uint8_t>& dst, int width, int rows,
+             RleMode mode = RLE_COPY) {
+    return rleDecode(rle.data(), rle.size(), dst.data(), width, rows, (size_t)width * 3, mode);
+}
+
+void checkRleRoundTrip() {
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        std::vector<uint8_t> px = testPixels(64 * 32, seed);
+        std::vector<uint8_t> rle;
+        rleEncode(px.data(), 64 * 32, rle);
+        std::vector<uint8_t> out(px.size(), 0x55);
+        CHECK(decodes(rle, out, 64, 32));
+        CHECK(out == px);
+    }
+
+    // Runs longer than one control byte holds, literals of exactly 128
+    std::vector<uint8_t> solid(1000 * 3, 7);
+    std::vector<uint8_t> rle;
+    rleEncode(solid.data(), 1000, rle);
+    std::vector<uint8_t> out(solid.size());
+    CHECK(decodes(rle, out, 100, 10));
+    CHECK(out == solid);
+
+    std::vector<uint8_t> ramp;
+    for (int i = 0; i < 128; i++) {
+        ramp.push_back(i);
+        ramp.push_back(0);
+        ramp.push_back(0);
+    }
+    rle.clear();
+    rleEncode(ramp.data(), 128, rle);
+    CHECK(rle.size() == 1 + 128 * 3 && rle[0] == 127);
+    out.assign(ramp.size(), 0);
+    CHECK(decodes(rle, out, 128, 1));
+    CHECK(out == ramp);
+}
+
+void checkRleXor() {
+    // A frame XOR its successor, decoded onto the first, gives the second
+    std::vector<uint8_t> a = testPixels(64 * 32, 3);
+    std::vector<uint8_t> b = a;
+    for (size_t i = 300; i < 900; i++) b[i] ^= 0x5a;
+    std::vector<uint8_t> delta(a.size());
+    for (size_t i = 0; i < a.size(); i++) delta[i] = a[i] ^ b[i];
+    std::vector<uint8_t> rle;
+    rleEncode(delta.data(), 64 * 32, rle);
+    CHECK(rle.size() < 700);
+    CHECK(decodes(rle, a, 64, 32, RLE_XOR));
+    CHECK(a == b);
+}
+
+void checkRleMalformed() {
+    std::vector<uint8_t> px = testPixels(16 * 4, 5);
+    std::vector<uint8_t> rle;
+    rleEncode(px.data(), 16 * 4, rle);
+    std::vector<uint8_t> out(px.size());
+
+    // Every truncation of a valid payload is refused
+    for (size_t len = 0; len < rle.size(); len++) {
+        std::vector<uint8_t> cut(rle.begin(), rle.begin() + len);
+        CHECK(!decodes(cut, out, 16, 4));
+    }
+
+    // Literal run missing its pixels, repeat run missing its pixel
+    CHECK(!decodes({2, 1, 2, 3, 4, 5, 6}, out, 3, 1));
+    CHECK(!decodes({130, 1, 2}, out, 4, 1));
+
+    // Runs past the end of the region, and bytes after it is covered
+    CHECK(!decodes({130, 1, 2, 3}, out, 3, 1));
+    CHECK(!decodes({0, 1, 2, 3, 0, 4, 5, 6}, out, 1, 1));
+    CHECK(decodes({130, 1, 2, 3}, out, 2, 2));
+
+    // Nothing outside the region is written, whatever the payload claims
+    std::vector<uint8_t> guarded(8 * 3 * 3, 0xee);
+    std::vector<uint8_t> flood = {255, 9, 9, 9, 255, 9, 9, 9};
+    CHECK(!rleDecode(flood.data(), flood.size(), guarded.data() + 8 * 3 + 3, 4, 1, 8 * 3, RLE_COPY));
+    for (size_t i = 0; i < guarded.size(); i++) {
+        bool inside = i >= 8 * 3 + 3 && i < 8 * 3 + 3 + 4 * 3;
+        if (!inside) CHECK(guarded[i] == 0xee);
+    }
+}
+
+// ─── Pixel Stream ────────────────────────────────────────────────────────────
+
+std::vector<uint8_t> streamPacket(uint8_t type, uint32_t seq, uint32_t base, int width, int height,
+                                  const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> p = {'L', 'M', STREAM_VERSION, type};
+    for (uint32_t v : {seq, base}) {
+        for (int i = 0; i < 4; i++) p.push_back((uint8_t)(v >> (8 * i)));
+    }
+    for (int v : {width, height}) {
+        p.push_back((uint8_t)v);
+        p.push_back((uint8_t)(v >> 8));
+    }
+    p.insert(p.end(), body.begin(), body.end());
+    return p;
+}
+
+std::vector<uint8_t> rectBody(int x, int y, int w, int h, const std::vector<uint8_t>& rle) {
+    std::vector<uint8_t> body;
+    for (int v : {x, y, w, h}) {
+        body.push_back((uint8_t)v);
+        body.push_back((uint8_t)(v >> 8));
+    }
+    body.insert(body.end(), rle.begin(), rle.end());
+    return body;
+}
+
+uint8_t send(PixelStream& stream, const std::vector<uint8_t>& packet) {
+    std::vector<uint8_t> reply;
+    stream.handlePacket(packet.data(), packet.size(), reply);
+    return reply.size() == 9 ? reply[8] : 0xff;
+}
+
+std::vector<uint8_t> rle(const std::vector<uint8_t>& pixels) {
+    std::vector<uint8_t> out;
+    rleEncode(pixels.data(), pixels.size() / 3, out);
+    return out;
+}
+
+void checkStreamDeltas() {
+    PixelStream stream;
+    std::vector<uint8_t> key = testPixels(8 * 4, 11);
+    CHECK(send(stream, streamPacket(STREAM_KEY, 1, 0, 8, 4, rle(key))) == STREAM_OK);
+
+    std::vector<uint8_t> next = key;
+    for (size_t i = 30; i < 45; i++) next[i] ^= 0xff;
+    std::vector<uint8_t> delta(key.size());
+    for (size_t i = 0; i < key.size(); i++) delta[i] = key[i] ^ next[i];
+    CHECK(send(stream, streamPacket(STREAM_XOR, 2, 1, 8, 4, rle(delta))) == STREAM_OK);
+    // A retransmission is acknowledged, not applied twice
+    CHECK(send(stream, streamPacket(STREAM_XOR, 2, 1, 8, 4, rle(delta))) == STREAM_OK);
+
+    // 2×2 rectangle at (6, 2): the frame's bottom-right corner
+    std::vector<uint8_t> patch(2 * 2 * 3, 0x42);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 3, 2, 8, 4, rectBody(6, 2, 2, 2, rle(patch)))) == STREAM_OK);
+    for (int y = 2; y < 4; y++) {
+        for (int x = 6; x < 8; x++) {
+            for (int c = 0; c < 3; c++) next[(y * 8 + x) * 3 + c] = 0x42;
+        }
+    }
+
+    Framebuffer out(8, 4);
+    CHECK(stream.copyViewport(out, 0, 0));
+    CHECK(out.pixels == next);
+
+    // A delta against a frame the receiver doesn't hold asks for a keyframe
+    CHECK(send(stream, streamPacket(STREAM_XOR, 5, 4, 8, 4, rle(delta))) == STREAM_NEED_KEYFRAME);
+    CHECK(send(stream, streamPacket(STREAM_XOR, 5, 3, 16, 4, rle(delta))) == STREAM_NEED_KEYFRAME);
+}
+
+void checkStreamMalformed() {
+    PixelStream stream;
+    std::vector<uint8_t> key = testPixels(8 * 4, 12);
+    CHECK(send(stream, streamPacket(STREAM_KEY, 1, 0, 8, 4, rle(key))) == STREAM_OK);
+
+    // Rectangles running past the right or bottom edge, or with a short header
+    std::vector<uint8_t> patch = rle(std::vector<uint8_t>(2 * 2 * 3, 1));
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, rectBody(7, 0, 2, 2, patch))) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, rectBody(0, 3, 2, 2, patch))) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, rectBody(65535, 65535, 2, 2, patch))) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, {0, 0, 2, 0})) == STREAM_MALFORMED);
+
+    // Refused rectangles leave the frame as it was
+    Framebuffer out(8, 4);
+    CHECK(stream.copyViewport(out, 0, 0));
+    CHECK(out.pixels == key);
+
+    // A truncated rectangle payload drops the frame: later deltas need a keyframe
+    std::vector<uint8_t> cut(patch.begin(), patch.end() - 1);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, rectBody(0, 0, 2, 2, cut))) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(STREAM_RECT, 2, 1, 8, 4, rectBody(0, 0, 2, 2, patch))) == STREAM_NEED_KEYFRAME);
+
+    // Truncated keyframes, absurd sizes, unknown types, short headers
+    std::vector<uint8_t> short_key = rle(key);
+    short_key.pop_back();
+    CHECK(send(stream, streamPacket(STREAM_KEY, 3, 0, 8, 4, short_key)) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(STREAM_KEY, 3, 0, 4096, 4, rle(key))) == STREAM_MALFORMED);
+    CHECK(send(stream, streamPacket(9, 3, 0, 8, 4, rle(key))) == STREAM_MALFORMED);
+    std::vector<uint8_t> header = streamPacket(STREAM_KEY, 3, 0, 8, 4, {});
+    header.resize(10);
+    CHECK(send(stream, header) == STREAM_MALFORMED);
+}
+
+void checkStreamViewport() {
+    PixelStream stream;
+    Framebuffer out(4, 2);
+    out.fill(9, 9, 9);
+    CHECK(!stream.copyViewport(out, 0, 0));
+    CHECK(out.pixels == std::vector<uint8_t>(4 * 2 * 3, 9));
+
+    std::vector<uint8_t> key = testPixels(6 * 3, 13);
+    CHECK(send(stream, streamPacket(STREAM_KEY, 1, 0, 6, 3, rle(key))) == STREAM_OK);
+
+    // Viewport at (3, 2) of the 6×3 frame: 3×1 of it, the rest black
+    CHECK(stream.copyViewport(out, 3, 2));
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 4; x++) {
+            bool inside = x < 3 && y < 1;
+            for (int c = 0; c < 3; c++) {
+                uint8_t want = inside ? key[((y + 2) * 6 + x + 3) * 3 + c] : 0;
+                CHECK(out.row(y)[x * 3 + c] == want);
+            }
+        }
+    }
+
+    // Entirely outside the frame: all black
+    out.fill(9, 9, 9);
+    CHECK(stream.copyViewport(out, 10, 10));
+    CHECK(out.pixels == std::vector<uint8_t>(4 * 2 * 3, 0));
+}
+
+// ─── Glyph Cache ─────────────────────────────────────────────────────────────
+
+const uint64_t FONT = 0x1234567890abcdefull;
+
+// A glyph's coverage is a function of its code, so a reload can be checked
+std::vector<uint8_t> coverageOf(uint32_t code, int width, int rows) {
+    std::vector<uint8_t> c((size_t)width * rows);
+    for (size_t i = 0; i < c.size(); i++) c[i] = (uint8_t)(code * 31 + i);
+    return c;
+}
+
+void insertGlyph(GlyphCache& cache, uint32_t code) {
+    std::vector<uint8_t> c = coverageOf(code, 5, 7);
+    cache.insert(FONT, 12, code, 6, 0, 7, 5, 7, c.data(), 5);
+}
+
+bool hasGlyph(const GlyphCache& cache, uint32_t code) {
+    const Glyph* g = cache.find(FONT, 12, code);
+    return g && g->width == 5 && g->rows == 7 && g->advance == 6 &&
+           std::vector<uint8_t>(g->coverage, g->coverage + 35) == coverageOf(code, 5, 7);
+}
+
+off_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+// Cache file with glyphs 'A', 'B', 'C' (a space too: no coverage at all)
+std::string glyphFile() {
+    char path[] = "/tmp/led-check-glyphs.XXXXXX";
+    ::close(mkstemp(path));
+    GlyphCache cache;
+    cache.open(path);
+    insertGlyph(cache, 'A');
+    insertGlyph(cache, 'B');
+    insertGlyph(cache, 'C');
+    cache.insert(FONT, 12, ' ', 3, 0, 0, 0, 0, nullptr, 0);
+    return path;
+}
+
+void checkGlyphReload() {
+    std::string path = glyphFile();
+    off_t size = fileSize(path);
+    {
+        GlyphCache cache;
+        CHECK(cache.open(path));
+        CHECK(cache.size() == 4);
+        CHECK(hasGlyph(cache, 'A') && hasGlyph(cache, 'B') && hasGlyph(cache, 'C'));
+        const Glyph* space = cache.find(FONT, 12, ' ');
+        CHECK(space && space->advance == 3 && space->width == 0);
+    }
+    CHECK(fileSize(path) == size);
+    unlink(path.c_str());
+}
+
+void checkGlyphGarbageTail() {
+    // A file extended with zeros before a power loss: nothing is indexed
+    // from the zeros, and they are trimmed so new records follow the good ones
+    std::string path = glyphFile();
+    off_t size = fileSize(path);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << std::string(4096, '\0');
+    }
+    {
+        GlyphCache cache;
+        CHECK(cache.open(path));
+        CHECK(cache.size() == 4);
+        CHECK(!cache.find(0, 0, 0));
+        CHECK(fileSize(path) == size);
+        insertGlyph(cache, 'D');
+    }
+    GlyphCache cache;
+    CHECK(cache.open(path));
+    CHECK(cache.size() == 5 && hasGlyph(cache, 'D'));
+    unlink(path.c_str());
+}
+
+void checkGlyphCorruptRecord() {
+    // One flipped coverage byte in the second record: the first survives,
+    // everything from the bad record on is dropped
+    std::string path = glyphFile();
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(GLYPH_CACHE_HEADER + (sizeof(GlyphRecord) + 35) + sizeof(GlyphRecord) + 10);
+        f.put((char)0xff);
+    }
+    {
+        GlyphCache cache;
+        CHECK(cache.open(path));
+        CHECK(cache.size() == 1 && hasGlyph(cache, 'A'));
+        CHECK(fileSize(path) == (off_t)(GLYPH_CACHE_HEADER + sizeof(GlyphRecord) + 35));
+    }
+
+    // So is a record whose size fields were overwritten
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(GLYPH_CACHE_HEADER + offsetof(GlyphRecord, width));
+        uint16_t width = 3;
+        f.write((const char*)&width, 2);
+    }
+    GlyphCache cache;
+    CHECK(cache.open(path));
+    CHECK(cache.size() == 0);
+    CHECK(fileSize(path) == GLYPH_CACHE_HEADER);
+    unlink(path.c_str());
+}
+
+// ─── Staged Presentation ─────────────────────────────────────────────────────
+
+// A handler on a 64×32 canvas with no saved settings, showing "A" on layout 1
+struct StagingRig {
+    SegmentManager sm;
+    UDPHandler handler;
+    HeadlessBackend display;
+    TextRenderer renderer;
+
+    StagingRig()
+        : handler(&sm, nullptr, nullptr, nullptr, "/nonexistent/config.json"),
+          display(64, 32), renderer(&display, &sm) {
+        handler.setPersistConfig(false);
+        g_udp_handler = &handler;
+        handler.dispatch(R"({"cmd":"text","seg":0,"text":"A"})");
+        renderer.renderAll();
+    }
+    ~StagingRig() { g_udp_handler = nullptr; }
+
+    std::vector<uint8_t> frame() {
+        renderer.renderAll();
+        return display.frontBuffer().pixels;
+    }
+    std::string text(int seg) { return sm.snapshot()[seg].text; }
+};
+
+void checkStagedLayout() {
+    StagingRig rig;
+    std::vector<uint8_t> before = rig.frame();
+
+    // Nothing of a prepared layout shows, and the canvas isn't cleared for it
+    rig.handler.dispatch(R"({"cmd":"layout","preset":2,"prepare":true})");
+    rig.handler.dispatch(R"({"cmd":"text","seg":0,"text":"Top","prepare":true})");
+    rig.handler.dispatch(R"({"cmd":"text","seg":1,"text":"Bottom","prepare":true})");
+    CHECK(rig.handler.getCurrentLayout() == 1);
+    CHECK(rig.frame() == before);
+    CHECK(rig.text(0) == "A");
+
+    rig.handler.dispatch(R"({"cmd":"commit"})");
+    CHECK(rig.handler.getCurrentLayout() == 2);
+    CHECK(rig.text(0) == "Top");
+    CHECK(rig.text(1) == "Bottom");
+    CHECK(rig.frame() != before);
+
+    // A prepared layout that is discarded never becomes current
+    rig.handler.dispatch(R"({"cmd":"layout","preset":3,"prepare":true})");
+    rig.handler.dispatch(R"({"cmd":"discard"})");
+    rig.handler.dispatch(R"({"cmd":"commit"})");
+    CHECK(rig.handler.getCurrentLayout() == 2);
+}
+
+void checkLiveWritesWhileStaged() {
+    StagingRig rig;
+    rig.handler.dispatch(R"({"cmd":"layout","preset":2})");
+    rig.handler.dispatch(R"({"cmd":"text","seg":0,"text":"Old","prepare":true})");
+
+    // Live writes show at once and survive the commit; the later write wins
+    rig.handler.dispatch(R"({"cmd":"text","seg":1,"text":"Live"})");
+    rig.handler.dispatch(R"({"cmd":"text","seg":0,"text":"New"})");
+    CHECK(rig.text(1) == "Live");
+    CHECK(rig.text(0) == "New");
+    rig.handler.dispatch(R"({"cmd":"text","seg":1,"text":"Staged","prepare":true})");
+    CHECK(rig.text(1) == "Live");
+
+    rig.handler.dispatch(R"({"cmd":"commit"})");
+    CHECK(rig.text(0) == "New");
+    CHECK(rig.text(1) == "Staged");
+
+    // A live layout change while content is staged is kept by the commit too
+    rig.handler.dispatch(R"({"cmd":"text","seg":0,"text":"Next","prepare":true})");
+    rig.handler.dispatch(R"({"cmd":"layout","preset":3})");
+    CHECK(rig.handler.getCurrentLayout() == 3);
+    rig.handler.dispatch(R"({"cmd":"commit"})");
+    CHECK(rig.handler.getCurrentLayout() == 3);
+    CHECK(rig.text(0) == "Next");
+    std::vector<Segment> segs = rig.sm.snapshot();
+    CHECK(segs[0].width == 32 && segs[1].x == 32);
+}
+
+// ─── Web Server ──────────────────────────────────────────────────────────────
+
+const int CHECK_WEB_PORT = 18080;
+
+// Send a request, shut down the write side and read until the server closes
+std::string halfCloseExchange(const std::string& request) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(CHECK_WEB_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval timeout{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string reply;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        shutdown(fd, SHUT_WR);
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) reply.append(buf, n);
+        if (n < 0) reply += "<timeout>";
+    } else {
+        reply = "<no connection>";
+    }
+    close(fd);
+    return reply;
+}
+
+void checkHalfClose() {
+    WebServer server(CHECK_WEB_PORT);
+    server.start();
+
+    // A complete request is answered, then the connection closes
+    std::string reply = halfCloseExchange("GET /api/config HTTP/1.1\r\nHost: x\r\n\r\n");
+    CHECK(reply.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(reply.find("Connection: keep-alive") != std::string::npos);
+
+    // Pipelined requests are all answered before the close
+    reply = halfCloseExchange("GET /api/config HTTP/1.1\r\n\r\n"
+                              "GET /missing HTTP/1.1\r\n\r\n");
+    size_t second = reply.find("HTTP/1.1 404");
+    CHECK(reply.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(second != std::string::npos);
+
+    // A request cut short by the half-close gets no answer
+    CHECK(halfCloseExchange("GET /api/config HTTP/1.1\r\nHost:").empty());
+    CHECK(halfCloseExchange("").empty());
+
+    server.stop();
+}
+
+struct Check {
+    const char* name;
+    std::function<void()> run;
+};
+
+const std::vector<Check> CHECKS = {
+    {"http/chunked", checkHttpChunked},
+    {"http/chunk-size-overflow", checkHttpChunkSizeOverflow},
+    {"http/body-limits", checkHttpBodyLimits},
+    {"http/trailer-limits", checkHttpTrailerLimits},
+    {"rle/round-trip", checkRleRoundTrip},
+    {"rle/xor", checkRleXor},
+    {"rle/malformed", checkRleMalformed},
+    {"stream/deltas", checkStreamDeltas},
+    {"stream/malformed", checkStreamMalformed},
+    {"stream/viewport", checkStreamViewport},
+    {"glyph-cache/reload", checkGlyphReload},
+    {"glyph-cache/garbage-tail", checkGlyphGarbageTail},
+    {"glyph-cache/corrupt-record", checkGlyphCorruptRecord},
+    {"staging/layout", checkStagedLayout},
+    {"staging/live-writes", checkLiveWritesWhileStaged},
+    {"web/half-close", checkHalfClose},
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter SUBSTRING]" << std::endl;
+            return 1;
+        }
+    }
+
+    int run = 0;
+    int failed = 0;
+    for (const Check& check : CHECKS) {
+        if (!filter.empty() && std::string(check.name).find(filter) == std::string::npos) continue;
+        g_failures.clear();
+        std::streambuf* out_buf = std::cout.rdbuf(nullptr);
+        std::streambuf* err_buf = std::cerr.rdbuf(nullptr);
+        check.run();
+        std::cout.rdbuf(out_buf);
+        std::cerr.rdbuf(err_buf);
+        std::cout.clear();
+        std::cerr.clear();
+        run++;
+        for (const std::string& failure : g_failures) {
+            std::cout << "  " << failure << std::endl;
+        }
+        if (!g_failures.empty()) {
+            std::cout << "FAIL     " << check.name << std::endl;
+            failed++;
+        }
+    }
+
+    std::cout << run << " checks, " << failed << " failed" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -10,11 +10,24 @@
 #include <vector>
 
 // ─── Matrix Hardware ─────────────────────────────────────────────────────────
-#define MATRIX_WIDTH   64
+// Defaults; config.json "panel" sets the geometry at startup (PanelGeometry)
+#define MATRIX_WIDTH   64       // One panel
 #define MATRIX_HEIGHT  32
 #define MATRIX_CHAIN   1        // Number of panels chained
 #define MATRIX_PARALLEL 1       // Parallel chains
 
+//   "panel": {"width": 64, "height": 32, "chain": 4, "parallel": 2}
+struct PanelGeometry {
+    int width = MATRIX_WIDTH;
+    int height = MATRIX_HEIGHT;
+    int chain = MATRIX_CHAIN;
+    int parallel = MATRIX_PARALLEL;
+
+    // Canvas before rotation
+    int canvasWidth() const { return width * chain; }
+    int canvasHeight() const { return height * parallel; }
+};
+
 // GPIO Configuration
 #define HARDWARE_MAPPING "regular"  // "regular", "adafruit-hat", "adafruit-hat-pwm"
 #define GPIO_SLOWDOWN   3           // Match Python version
@@ -35,6 +48,7 @@
 #define UDP_PORT       21324
 #define UDP_BIND_ADDR  "0.0.0.0"
 #define WEB_PORT       8080
+#define UDP_MAX_DATAGRAM 65507  // Largest UDP payload (pixel stream keyframes)
 
 // Fallback static IP (applied if DHCP fails)
 #define FALLBACK_IP      "10.20.30.40"
@@ -43,10 +57,46 @@
 #define FALLBACK_IFACE   "eth1"
 #define DHCP_TIMEOUT_S   15
 
+// ─── Multi-panel Sync ────────────────────────────────────────────────────────
+#define CLOCK_BEACON_ADDR        "255.255.255.255"  // Where a clock master sends beacons
+#define CLOCK_BEACON_INTERVAL_MS 1000
+#define CLOCK_WINDOW             8       // Beacons kept for the offset estimate
+#define CLOCK_RESYNC_MS          1000    // Offset jump that restarts synchronisation
+#define CLOCK_ELECTION_TIMEOUT_MS (3 * CLOCK_BEACON_INTERVAL_MS)  // Silence before a candidate takes over
+
+// ─── Video Wall ──────────────────────────────────────────────────────────────
+// Several nodes, each showing its own viewport of one virtual canvas. They
+// all take the same commands from a multicast group, and the wall master
+// beacons the frame number there so every node renders the same frame.
+//   "wall": {"width": 256, "height": 32, "x": 64, "y": 0, "master": false,
+//            "group": "239.255.21.1", "interface": "0.0.0.0"}
+#define WALL_GROUP_ADDR         "239.255.21.1"
+#define WALL_BEACON_TIMEOUT_MS  500   // Followers pace themselves when the master is silent this long
+
+struct WallConfig {
+    bool enabled = false;
+    int width = 0;           // Virtual canvas
+    int height = 0;
+    int x = 0;               // This node's viewport (the size of its own canvas)
+    int y = 0;
+    bool master = false;     // Beacons the frame number
+    std::string group = WALL_GROUP_ADDR;
+    std::string interface = "0.0.0.0";  // Address of the interface to join the group on
+};
+
 // ─── Display ─────────────────────────────────────────────────────────────────
 #define MAX_SEGMENTS      4
 #define MAX_TEXT_LENGTH   128
 #define EFFECT_INTERVAL   50    // milliseconds between effect updates (20 fps, matches Python)
+#define SCROLL_SPEED      20    // Default scroll speed in pixels per second (one pixel per frame)
+#define FADE_DURATION_MS  1000  // Default time for one fade in (or out)
+#define AA_GAMMA          2.2f  // Panel response the anti-aliased coverage is corrected for
+#define STREAM_TIMEOUT_MS 5000  // Pixel stream hands the display back to segments after this much silence
+
+// Canvases at least this big compose in horizontal bands on several threads
+// (config.json "render_tiles": band count, 0 = one per core up to the max)
+#define RENDER_TILE_MIN_PIXELS (128 * 64)
+#define RENDER_TILES_MAX       4
 
 // Rotation: 0=normal, 90=clockwise, 180=upside-down, 270=counter-clockwise
 enum Rotation {
@@ -71,6 +121,14 @@ enum Effect {
     EFFECT_FADE
 };
 
+// Fade curve: alpha against the fraction of the fade that has elapsed
+enum Easing {
+    EASING_LINEAR = 0,
+    EASING_IN,        // Slow start (t²)
+    EASING_OUT,       // Slow end
+    EASING_IN_OUT     // Slow at both ends (smoothstep)
+};
+
 // ─── Text Alignment ──────────────────────────────────────────────────────────
 enum Align {
     ALIGN_LEFT = 0,
@@ -82,6 +140,8 @@ enum Align {
 #define FONT_PATH          "/usr/share/fonts/truetype/msttcorefonts/Arial_Bold.ttf"
 #define FONT_PATH_FALLBACK "/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf"
 #define FONT_MONO_PATH     "/usr/share/fonts/truetype/dejavu/DejaVuSansMono-Bold.ttf"
+#define BDF_FONT_DIR       "/usr/share/fonts/led-matrix"  // Bitmap fonts (*.bdf)
+#define BDF_AUTO_BELOW_PX  10    // fitText prefers a bitmap font over TrueType below this size
 
 // Font size search range (tries largest first)
 const int FONT_SIZES[] = {32, 30, 28, 26, 24, 22, 20, 18, 16, 14, 13, 12, 11, 10, 9, 8, 7, 6};
@@ -90,6 +150,7 @@ const int FONT_SIZES_COUNT = sizeof(FONT_SIZES) / sizeof(FONT_SIZES[0]);
 // ─── Persistence ─────────────────────────────────────────────────────────────
 #define CONFIG_FILE   "/var/lib/led-matrix/config.json"
 #define SEGMENT_FILE  "/var/lib/led-matrix/segments.json"
+#define GLYPH_CACHE_FILE "/var/lib/led-matrix/glyphs.cache"  // Rendered glyphs, mmap'ed at startup
 
 // ─── Group Configuration ─────────────────────────────────────────────────────
 struct GroupColor {
@@ -111,47 +172,68 @@ const GroupColor GROUP_COLORS[9] = {
 #define GROUP_INDICATOR_SIZE 2  // Size of group indicator square (2×2 pixels)
 
 // ─── Layout Presets ──────────────────────────────────────────────────────────
-// Each layout is a vector of rectangles: {x, y, width, height}
+// Layouts are relative to the canvas, so one table serves every panel
+// geometry: each rectangle is given by its edges {x0, y0, x1, y1} in sixths
+// of the canvas (halves and thirds) and scaled by layoutRect()
+#define LAYOUT_GRID 6
+
+struct LayoutCell {
+    int x0, y0, x1, y1;
+};
+
 struct LayoutRect {
     int x, y, w, h;
 };
 
-// Landscape layouts (64×32)
-const std::vector<LayoutRect> LAYOUT_LANDSCAPE[15] = {
+// Pixels of a cell on a width × height canvas. Edges round down, so
+// neighbours share them; an empty cell is a 1×1 placeholder (never drawn).
+inline LayoutRect layoutRect(const LayoutCell& c, int width, int height) {
+    int x0 = c.x0 * width / LAYOUT_GRID;
+    int y0 = c.y0 * height / LAYOUT_GRID;
+    int x1 = c.x1 * width / LAYOUT_GRID;
+    int y1 = c.y1 * height / LAYOUT_GRID;
+    if (x1 <= x0 || y1 <= y0) {
+        return {x0, y0, 1, 1};
+    }
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Landscape layouts (canvas wider than tall, e.g. 64×32)
+const std::vector<LayoutCell> LAYOUT_LANDSCAPE[15] = {
     {},  // 0: Invalid
-    {{0, 0, 64, 32}},  // 1: Fullscreen
-    {{0, 0, 64, 16}, {0, 16, 64, 16}},  // 2: Top/Bottom halves
-    {{0, 0, 32, 32}, {32, 0, 32, 32}},  // 3: Left/Right halves
-    {{0, 0, 32, 32}, {32, 0, 32, 16}, {32, 16, 32, 16}},  // 4: Triple left
-    {{0, 0, 32, 16}, {0, 16, 32, 16}, {32, 0, 32, 32}},   // 5: Triple right
-    {{0, 0, 21, 32}, {21, 0, 21, 32}, {42, 0, 22, 32}},   // 6: Thirds vertical
-    {{0, 0, 32, 16}, {32, 0, 32, 16}, {0, 16, 32, 16}, {32, 16, 32, 16}},  // 7: Quad
+    {{0, 0, 6, 6}},  // 1: Fullscreen
+    {{0, 0, 6, 3}, {0, 3, 6, 6}},  // 2: Top/Bottom halves
+    {{0, 0, 3, 6}, {3, 0, 6, 6}},  // 3: Left/Right halves
+    {{0, 0, 3, 6}, {3, 0, 6, 3}, {3, 3, 6, 6}},  // 4: Triple left
+    {{0, 0, 3, 3}, {0, 3, 3, 6}, {3, 0, 6, 6}},  // 5: Triple right
+    {{0, 0, 2, 6}, {2, 0, 4, 6}, {4, 0, 6, 6}},  // 6: Thirds vertical
+    {{0, 0, 3, 3}, {3, 0, 6, 3}, {0, 3, 3, 6}, {3, 3, 6, 6}},  // 7: Quad
     {},  // 8-10: Reserved
     {},
     {},
-    {{0, 0, 64, 32}},  // 11: Seg 0 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 64, 32}},  // 12: Seg 1 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 64, 32}},  // 13: Seg 2 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 64, 32}}  // 14: Seg 3 fullscreen
+    {{0, 0, 6, 6}},  // 11: Seg 0 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 6, 6}},  // 12: Seg 1 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 6, 6}},  // 13: Seg 2 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 6, 6}}  // 14: Seg 3 fullscreen
 };
 
-// Portrait layouts (32×64)
-const std::vector<LayoutRect> LAYOUT_PORTRAIT[15] = {
+// Portrait layouts (canvas taller than wide, e.g. 32×64)
+const std::vector<LayoutCell> LAYOUT_PORTRAIT[15] = {
     {},  // 0: Invalid
-    {{0, 0, 32, 64}},  // 1: Fullscreen
-    {{0, 0, 32, 32}, {0, 32, 32, 32}},  // 2: Top/Bottom halves
-    {{0, 0, 16, 64}, {16, 0, 16, 64}},  // 3: Left/Right halves
-    {{0, 0, 32, 32}, {0, 32, 16, 32}, {16, 32, 16, 32}},  // 4: Triple top
-    {{0, 0, 16, 32}, {16, 0, 16, 32}, {0, 32, 32, 32}},   // 5: Triple bottom
-    {{0, 0, 32, 21}, {0, 21, 32, 21}, {0, 42, 32, 22}},   // 6: Thirds horizontal
-    {{0, 0, 16, 32}, {16, 0, 16, 32}, {0, 32, 16, 32}, {16, 32, 16, 32}},  // 7: Quad
+    {{0, 0, 6, 6}},  // 1: Fullscreen
+    {{0, 0, 6, 3}, {0, 3, 6, 6}},  // 2: Top/Bottom halves
+    {{0, 0, 3, 6}, {3, 0, 6, 6}},  // 3: Left/Right halves
+    {{0, 0, 6, 3}, {0, 3, 3, 6}, {3, 3, 6, 6}},  // 4: Triple top
+    {{0, 0, 3, 3}, {3, 0, 6, 3}, {0, 3, 6, 6}},  // 5: Triple bottom
+    {{0, 0, 6, 2}, {0, 2, 6, 4}, {0, 4, 6, 6}},  // 6: Thirds horizontal
+    {{0, 0, 3, 3}, {3, 0, 6, 3}, {0, 3, 3, 6}, {3, 3, 6, 6}},  // 7: Quad
     {},  // 8-10: Reserved
     {},
     {},
-    {{0, 0, 32, 64}},  // 11: Seg 0 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 32, 64}},  // 12: Seg 1 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 32, 64}},  // 13: Seg 2 fullscreen
-    {{0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 1, 1}, {0, 0, 32, 64}}  // 14: Seg 3 fullscreen
+    {{0, 0, 6, 6}},  // 11: Seg 0 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 6, 6}},  // 12: Seg 1 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 6, 6}},  // 13: Seg 2 fullscreen
+    {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 6, 6}}  // 14: Seg 3 fullscreen
 };
 
 #endif // CONFIG_H
@@ -0,0 +1,33 @@
+// display_backend.h - Where rendered frames are presented
+//
+// TextRenderer composes every frame in its own Framebuffer, then blits it
+// into the backend and presents once per frame. The rgbmatrix backend drives
+// the HUB75 panel; the headless backend keeps frames in memory so the
+// daemon can run on a build server or laptop without GPIO.
+
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#include <cstdint>
+#include "framebuffer.h"
+
+class DisplayBackend {
+public:
+    virtual ~DisplayBackend() {}
+
+    virtual const char* name() const = 0;
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+
+    // Copy a whole frame into the back buffer
+    virtual void blit(const Framebuffer& frame) = 0;
+
+    // Make the back buffer visible (on vsync for the panel). `frame` is the
+    // renderer's copy of the same pixels, for backends that keep frames.
+    virtual void present(const Framebuffer& frame) = 0;
+
+    // Blank whatever is currently displayed, outside of the frame cycle
+    virtual void clear() = 0;
+};
+
+#endif // DISPLAY_BACKEND_H
@@ -0,0 +1,66 @@
+#!/bin/bash
+# embed-assets.sh - Generate web_assets.cpp from the files in web/
+#
+# Each asset is embedded twice: as-is and pre-compressed with gzip -9, plus an
+# ETag derived from its contents, so the web server never builds or
+# compresses pages at runtime.
+#
+# Usage: ./embed-assets.sh web > web_assets.cpp
+
+set -e
+
+DIR="${1:-web}"
+
+emit_bytes() {
+    od -An -v -tx1 | sed -e 's/ \([0-9a-f][0-9a-f]\)/0x\1,/g' -e 's/^/    /'
+}
+
+content_type() {
+    case "$1" in
+        *.html) echo "text/html; charset=utf-8" ;;
+        *.css)  echo "text/css; charset=utf-8" ;;
+        *.js)   echo "application/javascript; charset=utf-8" ;;
+        *.svg)  echo "image/svg+xml" ;;
+        *.json) echo "application/json" ;;
+        *.png)  echo "image/png" ;;
+        *)      echo "application/octet-stream" ;;
+    esac
+}
+
+echo "// web_assets.cpp - GENERATED by embed-assets.sh from $DIR/ - do not edit"
+echo
+echo '#include "web_assets.h"'
+echo
+
+files=$(cd "$DIR" && find . -type f | sed 's|^\./||' | LC_ALL=C sort)
+i=0
+for f in $files; do
+    echo "static const unsigned char asset${i}_raw[] = {"
+    emit_bytes < "$DIR/$f"
+    echo "};"
+    echo "static const unsigned char asset${i}_gz[] = {"
+    gzip -9 -n -c "$DIR/$f" | emit_bytes
+    echo "};"
+    echo
+    i=$((i + 1))
+done
+
+echo "static const WebAsset ASSETS[] = {"
+i=0
+for f in $files; do
+    etag=$(sha1sum "$DIR/$f" | cut -c1-16)
+    echo "    {\"/$f\", \"$(content_type "$f")\", \"\\\"$etag\\\"\", \"\\\"$etag-gz\\\"\","
+    echo "     asset${i}_raw, sizeof(asset${i}_raw), asset${i}_gz, sizeof(asset${i}_gz)},"
+    i=$((i + 1))
+done
+echo "};"
+echo
+cat <<'CPP'
+const WebAsset* findWebAsset(const std::string& path) {
+    std::string p = (path == "/") ? "/index.html" : path;
+    for (const WebAsset& asset : ASSETS) {
+        if (p == asset.path) return &asset;
+    }
+    return nullptr;
+}
+CPP
@@ -0,0 +1,130 @@
+// frame_codec.cpp - Run-length coding for RGB pixel frames
+
+#include "frame_codec.h"
+#include <cstring>
+
+static inline bool samePixel(const uint8_t* a, const uint8_t* b) {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+// ─── Encoder ─────────────────────────────────────────────────────────────────
+
+void rleEncode(const uint8_t* pixels, size_t pixel_count, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < pixel_count) {
+        const uint8_t* p = pixels + i * 3;
+
+        // Measure the repeat run starting here
+        size_t run = 1;
+        while (i + run < pixel_count && run < 129 && samePixel(p, p + run * 3)) {
+            run++;
+        }
+
+        if (run >= 2) {
+            out.push_back((uint8_t)(run + 126));
+            out.insert(out.end(), p, p + 3);
+            i += run;
+            continue;
+        }
+
+        // Literal run: stop before the next pair of identical pixels
+        size_t lit = 1;
+        while (i + lit < pixel_count && lit < 128) {
+            const uint8_t* q = pixels + (i + lit) * 3;
+            if (i + lit + 1 < pixel_count && samePixel(q, q + 3)) break;
+            lit++;
+        }
+        out.push_back((uint8_t)(lit - 1));
+        out.insert(out.end(), p, p + lit * 3);
+        i += lit;
+    }
+}
+
+// ─── Decoder ─────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Walks a rectangular pixel region row by row
+struct RegionCursor {
+    uint8_t* row_start;
+    uint8_t* pos;
+    int width;
+    int col;
+    int rows_left;
+    size_t stride;
+
+    RegionCursor(uint8_t* dst, int w, int rows, size_t s)
+        : row_start(dst), pos(dst), width(w), col(0), rows_left(rows), stride(s) {}
+
+    bool done() const { return rows_left <= 0; }
+
+    // Pixels remaining on the current row
+    int span() const { return width - col; }
+
+    void advance(int n) {
+        col += n;
+        pos += n * 3;
+        if (col == width) {
+            col = 0;
+            rows_left--;
+            row_start += stride;
+            pos = row_start;
+        }
+    }
+};
+
+}  // namespace
+
+bool rleDecode(const uint8_t* src, size_t len,
+               uint8_t* dst, int width, int rows, size_t stride, RleMode mode) {
+    if (width <= 0 || rows <= 0) return len == 0;
+
+    RegionCursor cur(dst, width, rows, stride);
+    const uint8_t* end = src + len;
+
+    while (src < end) {
+        if (cur.done()) return false;
+        uint8_t ctrl = *src++;
+
+        if (ctrl < 128) {
+            int count = ctrl + 1;
+            if ((size_t)(end - src) < (size_t)count * 3) return false;
+            while (count > 0) {
+                if (cur.done()) return false;
+                int n = count < cur.span() ? count : cur.span();
+                if (mode == RLE_COPY) {
+                    memcpy(cur.pos, src, (size_t)n * 3);
+                } else {
+                    for (int k = 0; k < n * 3; k++) cur.pos[k] ^= src[k];
+                }
+                src += n * 3;
+                count -= n;
+                cur.advance(n);
+            }
+        } else {
+            int count = ctrl - 126;
+            if (end - src < 3) return false;
+            const uint8_t r = src[0], g = src[1], b = src[2];
+            src += 3;
+            bool skip = (mode == RLE_XOR && r == 0 && g == 0 && b == 0);
+            while (count > 0) {
+                if (cur.done()) return false;
+                int n = count < cur.span() ? count : cur.span();
+                if (!skip) {
+                    uint8_t* p = cur.pos;
+                    for (int k = 0; k < n; k++, p += 3) {
+                        if (mode == RLE_COPY) {
+                            p[0] = r; p[1] = g; p[2] = b;
+                        } else {
+                            p[0] ^= r; p[1] ^= g; p[2] ^= b;
+                        }
+                    }
+                }
+                count -= n;
+                cur.advance(n);
+            }
+        }
+    }
+
+    return cur.done();
+}
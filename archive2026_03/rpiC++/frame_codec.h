@@ -0,0 +1,30 @@
+// frame_codec.h - Run-length coding for RGB pixel frames
+//
+// PackBits-style RLE over 3-byte pixels. Each run starts with a control byte:
+//   0..127   literal run, (c + 1) pixels follow
+//   128..255 repeat run, the next pixel is repeated (c - 126) times
+// XOR deltas are mostly zero pixels, so they collapse into a handful of
+// repeat runs, and the decoder skips zero runs without touching memory.
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum RleMode {
+    RLE_COPY = 0,  // Decoded pixels replace the destination
+    RLE_XOR        // Decoded pixels are XORed into the destination
+};
+
+// Append the RLE encoding of `pixel_count` RGB pixels to `out`.
+void rleEncode(const uint8_t* pixels, size_t pixel_count, std::vector<uint8_t>& out);
+
+// Decode `len` bytes into a `width`×`rows` pixel region whose rows are
+// `stride` bytes apart. Returns false if the payload is malformed or does
+// not cover the region exactly; the region may be partially written then.
+bool rleDecode(const uint8_t* src, size_t len,
+               uint8_t* dst, int width, int rows, size_t stride, RleMode mode);
+
+#endif // FRAME_CODEC_H
@@ -0,0 +1,47 @@
+// frame_mailbox.h - Lock-free single-slot handoff of finished frames
+//
+// The renderer publishes every frame it presents; a single reader (the web
+// preview) picks up whichever frame is newest when it gets round to it.
+// Three buffers rotate through an atomic index so neither side ever blocks
+// or waits on the other: the writer always has a private back buffer, the
+// reader a private front buffer, and the middle slot holds the latest frame.
+
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <atomic>
+#include "framebuffer.h"
+
+class FrameMailbox {
+public:
+    FrameMailbox() : middle_(1), back_(0), front_(2) {}
+
+    // Writer side (render thread): copy the frame in and make it the newest
+    void publish(const Framebuffer& frame) {
+        Framebuffer& slot = slots_[back_];
+        if (slot.width != frame.width || slot.height != frame.height) {
+            slot.resize(frame.width, frame.height);
+        }
+        memcpy(slot.pixels.data(), frame.pixels.data(), frame.byteCount());
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: newest frame since the last call, or nullptr if none.
+    // The pointer stays valid until the next take().
+    const Framebuffer* take() {
+        if (!(middle_.load(std::memory_order_acquire) & FRESH)) return nullptr;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return &slots_[front_];
+    }
+
+private:
+    static const int INDEX = 0x3;
+    static const int FRESH = 0x4;  // Middle slot holds a frame the reader hasn't seen
+
+    Framebuffer slots_[3];
+    std::atomic<int> middle_;
+    int back_;   // Writer only
+    int front_;  // Reader only
+};
+
+#endif // FRAME_MAILBOX_H
@@ -0,0 +1,51 @@
+// framebuffer.h - Plain in-memory RGB888 framebuffer
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct Framebuffer {
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;  // Row-major, 3 bytes per pixel (R, G, B)
+
+    Framebuffer() : width(0), height(0) {}
+    Framebuffer(int w, int h) : width(0), height(0) { resize(w, h); }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.assign((size_t)w * h * 3, 0);
+    }
+
+    size_t pixelCount() const { return (size_t)width * height; }
+    size_t byteCount() const { return pixels.size(); }
+
+    uint8_t* row(int y) { return pixels.data() + (size_t)y * width * 3; }
+    const uint8_t* row(int y) const { return pixels.data() + (size_t)y * width * 3; }
+
+    void fill(uint8_t r, uint8_t g, uint8_t b) {
+        if (r == g && g == b) {
+            memset(pixels.data(), r, pixels.size());
+            return;
+        }
+        for (size_t i = 0; i < pixels.size(); i += 3) {
+            pixels[i] = r;
+            pixels[i + 1] = g;
+            pixels[i + 2] = b;
+        }
+    }
+
+    void setPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+        if (x < 0 || y < 0 || x >= width || y >= height) return;
+        uint8_t* p = row(y) + x * 3;
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+};
+
+#endif // FRAMEBUFFER_H
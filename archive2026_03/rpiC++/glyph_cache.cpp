@@ -0,0 +1,183 @@
+// glyph_cache.cpp - Persistent glyph cache
+
+#include "glyph_cache.h"
+#include <iostream>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+static_assert(sizeof(GlyphRecord) == 32, "GlyphRecord is the on-disk record header");
+
+static uint32_t freetypeVersion() {
+    return (FREETYPE_MAJOR << 16) | (FREETYPE_MINOR << 8) | FREETYPE_PATCH;
+}
+
+// 32-bit FNV-1a over the record up to `check`, then the coverage
+static uint32_t recordCheck(const GlyphRecord& rec, const uint8_t* coverage, size_t bytes) {
+    uint32_t h = 0x811c9dc5u;
+    const uint8_t* p = (const uint8_t*)&rec;
+    for (size_t i = 0; i < offsetof(GlyphRecord, check); i++) {
+        h = (h ^ p[i]) * 0x01000193u;
+    }
+    for (size_t i = 0; i < bytes; i++) {
+        h = (h ^ coverage[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+GlyphCache::GlyphCache() : fd_(-1), map_(nullptr), map_size_(0), file_size_(0) {
+}
+
+GlyphCache::~GlyphCache() {
+    close();
+}
+
+void GlyphCache::close() {
+    if (map_) {
+        // Glyphs in the mapping go with it
+        for (auto it = glyphs_.begin(); it != glyphs_.end();) {
+            if (it->second.coverage >= map_ && it->second.coverage < map_ + map_size_) {
+                it = glyphs_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        munmap((void*)map_, map_size_);
+        map_ = nullptr;
+        map_size_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool GlyphCache::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[GLYPH] Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd_, &st);
+    file_size_ = (size_t)st.st_size;
+
+    uint8_t header[GLYPH_CACHE_HEADER] = {};
+    bool valid = file_size_ >= GLYPH_CACHE_HEADER &&
+                 pread(fd_, header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    uint32_t version = 0, freetype = 0;
+    memcpy(&version, header + 8, 4);
+    memcpy(&freetype, header + 12, 4);
+    valid = valid && memcmp(header, GLYPH_CACHE_MAGIC, 8) == 0 &&
+            version == GLYPH_CACHE_VERSION && freetype == freetypeVersion();
+
+    if (!valid) {
+        // New file, or rendered by another version: start over
+        memset(header, 0, sizeof(header));
+        memcpy(header, GLYPH_CACHE_MAGIC, 8);
+        version = GLYPH_CACHE_VERSION;
+        freetype = freetypeVersion();
+        memcpy(header + 8, &version, 4);
+        memcpy(header + 12, &freetype, 4);
+        if (ftruncate(fd_, 0) < 0 || pwrite(fd_, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            std::cerr << "[GLYPH] Cannot write " << path << ": " << strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+        file_size_ = GLYPH_CACHE_HEADER;
+        std::cout << "[GLYPH] New glyph cache " << path << std::endl;
+        return true;
+    }
+
+    void* mem = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[GLYPH] mmap " << path << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    map_ = (const uint8_t*)mem;
+    map_size_ = file_size_;
+
+    size_t end = indexMapping();
+    if (end < file_size_) {
+        // Torn or garbage tail (power loss during an append): later appends
+        // must follow the last good record
+        std::cout << "[GLYPH] Trimming " << (file_size_ - end) << " bytes after the last good record" << std::endl;
+        if (ftruncate(fd_, (off_t)end) == 0) {
+            file_size_ = end;
+        }
+    }
+    std::cout << "[GLYPH] Mapped " << glyphs_.size() << " glyphs (" << (end >> 10)
+             << " KB) from " << path << std::endl;
+    return true;
+}
+
+// Index records in the mapping up to the first one that is cut short or
+// fails its checksum; returns the end of the last good one
+size_t GlyphCache::indexMapping() {
+    size_t pos = GLYPH_CACHE_HEADER;
+    while (pos + sizeof(GlyphRecord) <= map_size_) {
+        GlyphRecord rec;
+        memcpy(&rec, map_ + pos, sizeof(rec));
+        size_t bytes = (size_t)rec.width * rec.rows;
+        if (pos + sizeof(rec) + bytes > map_size_) break;
+        if (rec.check != recordCheck(rec, map_ + pos + sizeof(rec), bytes)) break;
+
+        Glyph g = {rec.advance, rec.left, rec.top, rec.width, rec.rows, map_ + pos + sizeof(rec)};
+        glyphs_[Key{rec.font_hash, rec.code, rec.size}] = g;
+        pos += sizeof(rec) + bytes;
+    }
+    return pos;
+}
+
+const Glyph* GlyphCache::find(uint64_t font_hash, int size, uint32_t code) const {
+    auto it = glyphs_.find(Key{font_hash, code, (uint16_t)size});
+    return it == glyphs_.end() ? nullptr : &it->second;
+}
+
+const Glyph* GlyphCache::insert(uint64_t font_hash, int size, uint32_t code, int advance, int left, int top,
+                                int width, int rows, const uint8_t* coverage, int pitch) {
+    GlyphRecord rec = {font_hash, code, (uint16_t)size, (int16_t)advance, (int16_t)left, (int16_t)top,
+                       (uint16_t)width, (uint16_t)rows, 0, 0};
+
+    // Record header and coverage in one buffer, so the append is a single write
+    std::vector<uint8_t> bytes(sizeof(rec) + (size_t)width * rows);
+    for (int y = 0; y < rows; y++) {
+        memcpy(bytes.data() + sizeof(rec) + (size_t)y * width, coverage + (ptrdiff_t)y * pitch, width);
+    }
+    rec.check = recordCheck(rec, bytes.data() + sizeof(rec), (size_t)width * rows);
+    memcpy(bytes.data(), &rec, sizeof(rec));
+
+    if (fd_ >= 0 && file_size_ + bytes.size() <= GLYPH_CACHE_MAX_BYTES) {
+        if (pwrite(fd_, bytes.data(), bytes.size(), (off_t)file_size_) == (ssize_t)bytes.size()) {
+            file_size_ += bytes.size();
+        }
+    }
+
+    owned_.push_back(std::move(bytes));
+    Glyph g = {advance, left, top, width, rows, owned_.back().data() + sizeof(rec)};
+    return &(glyphs_[Key{font_hash, code, (uint16_t)size}] = g);
+}
+
+uint64_t hashFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    uint64_t h = 0xcbf29ce484222325ull;
+    uint8_t buf[64 * 1024];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            h = (h ^ buf[i]) * 0x100000001b3ull;
+        }
+    }
+    ::close(fd);
+    return h;
+}
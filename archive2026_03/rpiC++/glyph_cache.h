@@ -0,0 +1,108 @@
+// glyph_cache.h - Rasterized glyphs, persisted to a file mapped at startup
+//
+// Every glyph FreeType renders is kept here, keyed by font file hash, pixel
+// size and character code. With a file attached, the glyphs rendered by
+// earlier runs are mmap'ed read-only when the renderer starts and new ones
+// are appended, so after a restart text is drawn from the mapping and
+// FreeType only sees characters it has never rendered before.
+//
+// File layout (native byte order - the file never leaves the device):
+//   header  8  "LMGLYPH\0"
+//           4  u32 GLYPH_CACHE_VERSION
+//           4  u32 FreeType version (major << 16 | minor << 8 | patch)
+//           16 reserved
+//   record  32 GlyphRecord
+//           n  width × rows 8-bit coverage, row-major
+//
+// A file with another version or FreeType build is started over. Each
+// record carries a checksum of itself and its coverage; from the first
+// record that is cut short or fails it (a power loss during an append, a
+// zero-filled tail) the file is trimmed on the next open.
+//
+// Not thread-safe: the render thread owns it.
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLYPH_CACHE_MAGIC      "LMGLYPH\0"
+#define GLYPH_CACHE_VERSION    2
+#define GLYPH_CACHE_HEADER     32
+#define GLYPH_CACHE_MAX_BYTES  (8 * 1024 * 1024)  // Stop appending past this size
+
+struct GlyphRecord {
+    uint64_t font_hash;
+    uint32_t code;
+    uint16_t size;
+    int16_t advance;  // Pixels
+    int16_t left;     // bitmap_left
+    int16_t top;      // bitmap_top
+    uint16_t width;
+    uint16_t rows;
+    uint32_t check;     // FNV-1a of the fields above and the coverage
+    uint32_t reserved;
+};
+
+struct Glyph {
+    int advance;
+    int left;
+    int top;
+    int width;
+    int rows;
+    const uint8_t* coverage;  // width × rows, row-major
+};
+
+class GlyphCache {
+public:
+    GlyphCache();
+    ~GlyphCache();
+
+    // Attach the on-disk cache (created if missing). Without a file the
+    // cache still works, in memory only.
+    bool open(const std::string& path);
+
+    const Glyph* find(uint64_t font_hash, int size, uint32_t code) const;
+
+    // Copies `coverage` (rows `pitch` bytes apart); appended to the file too
+    const Glyph* insert(uint64_t font_hash, int size, uint32_t code, int advance, int left, int top,
+                        int width, int rows, const uint8_t* coverage, int pitch);
+
+    size_t size() const { return glyphs_.size(); }
+
+private:
+    struct Key {
+        uint64_t font_hash;
+        uint32_t code;
+        uint16_t size;
+        bool operator==(const Key& o) const {
+            return font_hash == o.font_hash && code == o.code && size == o.size;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            return (size_t)(k.font_hash ^ ((uint64_t)k.code << 16) ^ k.size);
+        }
+    };
+
+    std::unordered_map<Key, Glyph, KeyHash> glyphs_;
+    std::deque<std::vector<uint8_t>> owned_;  // Coverage of glyphs rendered this run
+
+    int fd_;
+    const uint8_t* map_;
+    size_t map_size_;
+    size_t file_size_;
+
+    void close();
+    size_t indexMapping();
+};
+
+// FNV-1a of a file's contents (0 if unreadable)
+uint64_t hashFile(const std::string& path);
+
+#endif // GLYPH_CACHE_H
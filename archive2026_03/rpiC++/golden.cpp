@@ -0,0 +1,442 @@
+// golden.cpp - Golden-frame rendering regression suite
+//
+//   make golden                     build, render the corpus, compare with the goldens
+//   make golden-update              re-render and rewrite golden/frames.golden
+//   ./led-matrix-golden [--filter SUBSTRING] [--update] [--cases FILE] [--goldens FILE]
+//                       [--diff-dir DIR]
+//
+// Each case in golden/cases.json replays UDP commands into a fresh
+// SegmentManager / TextRenderer pair on a HeadlessBackend, then renders one
+// frame at every listed effect time (ms after the first frame, ascending).
+// Frames are compared by FNV-1a hash; a mismatch writes
+// <diff-dir>/<case>@<t>.ppm with expected | actual | difference side by side.
+// The goldens carry the frames themselves (RLE, base64), so a diff needs no
+// second checkout.
+//
+// A case with "wall" renders the whole virtual canvas as its golden, then
+// renders each listed node's viewport on a canvas of its own and checks it
+// against that part of the whole; a node that differs fails the case.
+//
+// Glyph shapes depend on the font files and the FreeType build. Both are
+// recorded in the goldens; on a machine where they differ the suite reports
+// "not applicable" instead of failing every text case.
+
+#include "text_renderer.h"
+#include "segment_manager.h"
+#include "udp_handler.h"
+#include "headless_backend.h"
+#include "frame_codec.h"
+#include "nlohmann/json.hpp"
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define GOLDEN_T0_MS  1000000  // Presentation time of a case's first frame
+
+using json = nlohmann::json;
+
+UDPHandler* g_udp_handler = nullptr;  // text_renderer.cpp reads orientation / layout / group through it
+
+namespace {
+
+struct GoldenFrame {
+    uint64_t hash;
+    int width;
+    int height;
+    std::string rle;  // base64
+};
+
+uint64_t fnv1a(const std::vector<uint8_t>& data) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint8_t b : data) {
+        h = (h ^ b) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// ─── Base64 ──────────────────────────────────────────────────────────────────
+
+const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string base64Encode(const std::vector<uint8_t>& in) {
+    std::string out;
+    for (size_t i = 0; i < in.size(); i += 3) {
+        uint32_t v = in[i] << 16;
+        if (i + 1 < in.size()) v |= in[i + 1] << 8;
+        if (i + 2 < in.size()) v |= in[i + 2];
+        out += B64[(v >> 18) & 63];
+        out += B64[(v >> 12) & 63];
+        out += (i + 1 < in.size()) ? B64[(v >> 6) & 63] : '=';
+        out += (i + 2 < in.size()) ? B64[v & 63] : '=';
+    }
+    return out;
+}
+
+std::vector<uint8_t> base64Decode(const std::string& in) {
+    std::vector<uint8_t> out;
+    uint32_t v = 0;
+    int bits = 0;
+    for (char c : in) {
+        const char* p = (c == '=' || c == '\0') ? nullptr : strchr(B64, c);
+        if (!p) break;
+        v = (v << 6) | (uint32_t)(p - B64);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((uint8_t)(v >> bits));
+        }
+    }
+    return out;
+}
+
+// ─── Environment ─────────────────────────────────────────────────────────────
+
+std::string fontId(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return "";
+    return std::string(path) + ":" + std::to_string(st.st_size);
+}
+
+// Font files TextRenderer will actually load, plus the FreeType version
+std::string environment() {
+    std::string arial = fontId(FONT_PATH);
+    if (arial.empty()) arial = fontId(FONT_PATH_FALLBACK);
+    char freetype[32];
+    snprintf(freetype, sizeof(freetype), "%d.%d.%d", FREETYPE_MAJOR, FREETYPE_MINOR, FREETYPE_PATCH);
+    return "arial=" + arial + " monospace=" + fontId(FONT_MONO_PATH) + " freetype=" + freetype;
+}
+
+// ─── Goldens File ────────────────────────────────────────────────────────────
+//
+//   # env <environment()>
+//   <case>@<t> <hash hex> <width> <height> <base64 RLE>
+
+bool loadGoldens(const std::string& path, std::string& env, std::map<std::string, GoldenFrame>& frames) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 6, "# env ") == 0) {
+            env = line.substr(6);
+            continue;
+        }
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string key, hash;
+        GoldenFrame frame;
+        if (in >> key >> hash >> frame.width >> frame.height >> frame.rle) {
+            frame.hash = strtoull(hash.c_str(), nullptr, 16);
+            frames[key] = frame;
+        }
+    }
+    return true;
+}
+
+bool saveGoldens(const std::string& path, const std::string& env,
+                 const std::vector<std::pair<std::string, GoldenFrame>>& frames) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    file << "# Golden frames for led-matrix-golden - regenerate with: make golden-update\n";
+    file << "# env " << env << "\n";
+    for (const auto& entry : frames) {
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)entry.second.hash);
+        file << entry.first << " " << hash << " " << entry.second.width << " "
+             << entry.second.height << " " << entry.second.rle << "\n";
+    }
+    return file.good();
+}
+
+// ─── Diff Image ──────────────────────────────────────────────────────────────
+
+// expected | actual | difference (differing pixels red on a dimmed actual)
+void writeDiff(const std::string& path, const GoldenFrame& expected, const Framebuffer& actual) {
+    Framebuffer want(actual.width, actual.height);
+    if (expected.width == actual.width && expected.height == actual.height) {
+        std::vector<uint8_t> rle = base64Decode(expected.rle);
+        rleDecode(rle.data(), rle.size(), want.pixels.data(), want.width, want.height,
+                  (size_t)want.width * 3, RLE_COPY);
+    }
+
+    int w = actual.width;
+    Framebuffer out(w * 3 + 2, actual.height);
+    out.fill(64, 64, 64);  // Grey separators
+    for (int y = 0; y < actual.height; y++) {
+        const uint8_t* e = want.row(y);
+        const uint8_t* a = actual.row(y);
+        uint8_t* o = out.row(y);
+        for (int x = 0; x < w; x++) {
+            const uint8_t* ep = e + x * 3;
+            const uint8_t* ap = a + x * 3;
+            memcpy(o + x * 3, ep, 3);
+            memcpy(o + (w + 1 + x) * 3, ap, 3);
+            uint8_t* dp = o + (2 * w + 2 + x) * 3;
+            if (memcmp(ep, ap, 3) != 0) {
+                dp[0] = 255;
+                dp[1] = 0;
+                dp[2] = 0;
+            } else {
+                dp[0] = ap[0] / 4;
+                dp[1] = ap[1] / 4;
+                dp[2] = ap[2] / 4;
+            }
+        }
+    }
+    writePPM(out, path);
+}
+
+// ─── Cases ───────────────────────────────────────────────────────────────────
+
+// One display's frames of a case: the case's commands replayed into a
+// fresh handler, rendered on a width × height canvas at every listed time
+std::vector<Framebuffer> renderFrames(const json& c, const PanelGeometry& panel, const WallConfig& wall,
+                                      int width, int height, const std::string& bitmap_font_dir) {
+    SegmentManager sm;
+    sm.setWallTime(wall.enabled);
+    UDPHandler handler(&sm);
+    handler.setPersistConfig(false);
+    handler.setPanel(panel);
+    handler.setWall(wall);
+    g_udp_handler = &handler;
+
+    // loadConfig() may have picked up a deployed panel's settings
+    handler.dispatch("{\"cmd\":\"group\",\"value\":0}");
+    handler.dispatch("{\"cmd\":\"rotation\",\"value\":0}");
+    handler.dispatch("{\"cmd\":\"orientation\",\"value\":\"landscape\"}");
+    // applyLayout() ignores the current preset, so step off it first
+    handler.dispatch(handler.getCurrentLayout() == 1 ? "{\"cmd\":\"layout\",\"preset\":2}"
+                                                     : "{\"cmd\":\"layout\",\"preset\":1}");
+    handler.dispatch("{\"cmd\":\"layout\",\"preset\":1}");
+
+    for (const auto& cmd : c["commands"]) {
+        handler.dispatch(cmd.dump());
+    }
+
+    HeadlessBackend display(width, height);
+    TextRenderer renderer(&display, &sm);
+    renderer.setRenderTiles(c.value("render_tiles", 1));
+    renderer.setViewport(wall.x, wall.y);
+    if (c.value("bitmap_fonts", false)) {
+        renderer.loadBitmapFonts(bitmap_font_dir);
+    }
+
+    std::vector<Framebuffer> out;
+    std::vector<uint64_t> times = c.value("times", std::vector<uint64_t>{0});
+    for (uint64_t t : times) {
+        sm.updateEffects(GOLDEN_T0_MS + t);
+        renderer.renderAll();
+        out.push_back(display.frontBuffer());
+    }
+    g_udp_handler = nullptr;
+    return out;
+}
+
+bool sameAsCrop(const Framebuffer& whole, const Framebuffer& part, int x, int y) {
+    if (x < 0 || y < 0 || x + part.width > whole.width || y + part.height > whole.height) {
+        return false;
+    }
+    for (int row = 0; row < part.height; row++) {
+        if (memcmp(whole.row(y + row) + x * 3, part.row(row), (size_t)part.width * 3) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Renders one case; every frame is appended to `frames` as "<case>@<t>",
+// and every wall node that disagrees with it to `viewport_failures`
+void runCase(const json& c, const std::string& bitmap_font_dir,
+             std::vector<std::pair<std::string, GoldenFrame>>& frames, std::vector<Framebuffer>& images,
+             std::vector<std::string>& viewport_failures) {
+    std::string name = c.value("name", "");
+
+    // "panel" as in config.json; "size" is the canvas as rotated (default:
+    // the panel's own)
+    PanelGeometry panel;
+    if (c.contains("panel")) {
+        const json& p = c["panel"];
+        panel.width = p.value("width", panel.width);
+        panel.height = p.value("height", panel.height);
+        panel.chain = p.value("chain", panel.chain);
+        panel.parallel = p.value("parallel", panel.parallel);
+    }
+    int width = panel.canvasWidth();
+    int height = panel.canvasHeight();
+    if (c.contains("size")) {
+        width = c["size"][0].get<int>();
+        height = c["size"][1].get<int>();
+    }
+
+    // "wall": {"width", "height", "nodes": [[x, y], ...]} - each node is a
+    // width × height canvas at (x, y) of the virtual canvas
+    WallConfig wall;
+    if (c.contains("wall")) {
+        wall.width = c["wall"].value("width", 0);
+        wall.height = c["wall"].value("height", 0);
+        wall.enabled = wall.width > 0 && wall.height > 0;
+    }
+
+    std::vector<uint64_t> times = c.value("times", std::vector<uint64_t>{0});
+    std::vector<Framebuffer> rendered = wall.enabled
+        ? renderFrames(c, panel, wall, wall.width, wall.height, bitmap_font_dir)
+        : renderFrames(c, panel, wall, width, height, bitmap_font_dir);
+
+    if (wall.enabled) {
+        for (const auto& node : c["wall"].value("nodes", json::array())) {
+            WallConfig viewport = wall;
+            viewport.x = node[0].get<int>();
+            viewport.y = node[1].get<int>();
+            std::vector<Framebuffer> parts = renderFrames(c, panel, viewport, width, height, bitmap_font_dir);
+            for (size_t i = 0; i < parts.size(); i++) {
+                if (!sameAsCrop(rendered[i], parts[i], viewport.x, viewport.y)) {
+                    viewport_failures.push_back(name + "@" + std::to_string(times[i]) + " node " +
+                                                std::to_string(viewport.x) + "," + std::to_string(viewport.y));
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < rendered.size(); i++) {
+        const Framebuffer& frame = rendered[i];
+        GoldenFrame golden;
+        golden.hash = fnv1a(frame.pixels);
+        golden.width = frame.width;
+        golden.height = frame.height;
+        std::vector<uint8_t> rle;
+        rleEncode(frame.pixels.data(), frame.pixelCount(), rle);
+        golden.rle = base64Encode(rle);
+        frames.push_back({name + "@" + std::to_string(times[i]), golden});
+        images.push_back(frame);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string cases_path = "golden/cases.json";
+    std::string goldens_path = "golden/frames.golden";
+    std::string diff_dir = "golden-diff";
+    std::string filter;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--cases" && i + 1 < argc) {
+            cases_path = argv[++i];
+        } else if (arg == "--goldens" && i + 1 < argc) {
+            goldens_path = argv[++i];
+        } else if (arg == "--diff-dir" && i + 1 < argc) {
+            diff_dir = argv[++i];
+        } else if (arg == "--update") {
+            update = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter SUBSTRING] [--update] [--cases FILE]"
+                     << " [--goldens FILE] [--diff-dir DIR]" << std::endl;
+            return 1;
+        }
+    }
+    if (update && !filter.empty()) {
+        std::cerr << "--update rewrites every golden and cannot be combined with --filter" << std::endl;
+        return 1;
+    }
+
+    json cases;
+    try {
+        std::ifstream file(cases_path);
+        cases = json::parse(file);
+    } catch (const json::exception& e) {
+        std::cerr << "Cannot read " << cases_path << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string env = environment();
+    std::string golden_env;
+    std::map<std::string, GoldenFrame> goldens;
+    if (!update) {
+        if (!loadGoldens(goldens_path, golden_env, goldens)) {
+            std::cerr << "Cannot read " << goldens_path << " (create it with: make golden-update)" << std::endl;
+            return 1;
+        }
+        if (golden_env != env) {
+            std::cout << "Goldens not applicable on this machine:\n"
+                     << "  goldens: " << golden_env << "\n"
+                     << "  here:    " << env << "\n"
+                     << "Install the same fonts, or regenerate with: make golden-update" << std::endl;
+            return 0;
+        }
+    }
+
+    // Renderer / handler logging would bury the report
+    std::streambuf* out_buf = std::cout.rdbuf();
+    std::streambuf* err_buf = std::cerr.rdbuf();
+    std::cout.rdbuf(nullptr);
+    std::cerr.rdbuf(nullptr);
+
+    // Cases with "bitmap_fonts": true load the fixture fonts next to the cases
+    size_t slash = cases_path.find_last_of('/');
+    std::string bitmap_font_dir = (slash == std::string::npos ? std::string(".") : cases_path.substr(0, slash)) + "/fonts";
+
+    std::vector<std::pair<std::string, GoldenFrame>> frames;
+    std::vector<Framebuffer> images;
+    std::vector<std::string> viewport_failures;
+    for (const auto& c : cases) {
+        if (!filter.empty() && c.value("name", "").find(filter) == std::string::npos) continue;
+        runCase(c, bitmap_font_dir, frames, images, viewport_failures);
+    }
+
+    std::cout.rdbuf(out_buf);
+    std::cerr.rdbuf(err_buf);
+    std::cout.clear();
+    std::cerr.clear();
+
+    // A wall node that disagrees with the whole is wrong whatever the goldens say
+    for (const std::string& failure : viewport_failures) {
+        std::cout << "VIEWPORT " << failure << " differs from the virtual canvas" << std::endl;
+    }
+    if (update && !viewport_failures.empty()) {
+        std::cerr << "Not writing goldens while wall nodes disagree" << std::endl;
+        return 1;
+    }
+
+    if (update) {
+        if (!saveGoldens(goldens_path, env, frames)) {
+            std::cerr << "Cannot write " << goldens_path << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << frames.size() << " golden frames to " << goldens_path << std::endl;
+        return 0;
+    }
+
+    int failed = (int)viewport_failures.size();
+    int missing = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const std::string& key = frames[i].first;
+        auto it = goldens.find(key);
+        if (it == goldens.end()) {
+            std::cout << "MISSING  " << key << std::endl;
+            missing++;
+            continue;
+        }
+        if (it->second.hash == frames[i].second.hash &&
+            it->second.width == frames[i].second.width &&
+            it->second.height == frames[i].second.height) {
+            continue;
+        }
+        mkdir(diff_dir.c_str(), 0755);
+        std::string path = diff_dir + "/" + key + ".ppm";
+        writeDiff(path, it->second, images[i]);
+        std::cout << "FAIL     " << key << " → " << path << std::endl;
+        failed++;
+    }
+
+    std::cout << frames.size() << " frames, " << failed << " failed, " << missing << " missing" << std::endl;
+    return (failed || missing) ? 1 : 0;
+}
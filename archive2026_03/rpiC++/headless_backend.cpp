@@ -0,0 +1,134 @@
+// headless_backend.cpp - In-memory display backend with PPM / shm output
+
+#include "headless_backend.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+HeadlessBackend::HeadlessBackend(int width, int height, const HeadlessOptions& options)
+    : width_(width), height_(height), options_(options), front_(width, height), frames_(0),
+      shm_fd_(-1), shm_(nullptr), shm_size_(0), slot_bytes_(0) {
+    if (options_.shm_slots < 1) {
+        options_.shm_slots = 1;
+    }
+    if (!options_.shm_name.empty() && !openRing()) {
+        options_.shm_name.clear();
+    }
+    std::cout << "✓ Headless display (" << width_ << "×" << height_ << ")";
+    if (!options_.ppm_path.empty()) std::cout << ", PPM → " << options_.ppm_path;
+    if (!options_.shm_name.empty()) std::cout << ", shm ring " << options_.shm_name
+                                             << " (" << options_.shm_slots << " slots)";
+    std::cout << std::endl;
+}
+
+HeadlessBackend::~HeadlessBackend() {
+    if (shm_) {
+        munmap(shm_, shm_size_);
+    }
+    if (shm_fd_ >= 0) {
+        close(shm_fd_);
+        shm_unlink(options_.shm_name.c_str());
+    }
+}
+
+void HeadlessBackend::present(const Framebuffer& frame) {
+    front_ = frame;
+    frames_++;
+
+    if (!options_.ppm_path.empty()) {
+        if (options_.ppm_path.find('%') != std::string::npos) {
+            char path[512];
+            snprintf(path, sizeof(path), options_.ppm_path.c_str(), (unsigned)frames_);
+            writePPM(front_, path);
+        } else {
+            // Readers never see a half-written file
+            std::string tmp = options_.ppm_path + ".tmp";
+            if (writePPM(front_, tmp)) {
+                rename(tmp.c_str(), options_.ppm_path.c_str());
+            }
+        }
+    }
+    if (shm_) {
+        writeRing();
+    }
+}
+
+void HeadlessBackend::clear() {
+    front_.fill(0, 0, 0);
+}
+
+// ─── Shared-memory Ring ──────────────────────────────────────────────────────
+
+bool HeadlessBackend::openRing() {
+    shm_fd_ = shm_open(options_.shm_name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (shm_fd_ < 0) {
+        std::cerr << "[HEADLESS] shm_open " << options_.shm_name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    slot_bytes_ = sizeof(ShmRingSlot) + front_.byteCount();
+    slot_bytes_ = (slot_bytes_ + 63) & ~(size_t)63;  // Keep slots cache-line aligned
+    shm_size_ = 64 + slot_bytes_ * options_.shm_slots;
+    if (ftruncate(shm_fd_, (off_t)shm_size_) < 0) {
+        std::cerr << "[HEADLESS] ftruncate " << options_.shm_name << ": " << strerror(errno) << std::endl;
+        close(shm_fd_);
+        shm_fd_ = -1;
+        return false;
+    }
+
+    void* mem = mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd_, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[HEADLESS] mmap " << options_.shm_name << ": " << strerror(errno) << std::endl;
+        close(shm_fd_);
+        shm_fd_ = -1;
+        return false;
+    }
+    shm_ = (uint8_t*)mem;
+    memset(shm_, 0, shm_size_);
+
+    ShmRingHeader* header = (ShmRingHeader*)shm_;
+    header->width = width_;
+    header->height = height_;
+    header->slots = options_.shm_slots;
+    header->slot_bytes = (uint32_t)slot_bytes_;
+    header->frames.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, HEADLESS_SHM_MAGIC, sizeof(header->magic));
+    return true;
+}
+
+static_assert(sizeof(ShmRingHeader) <= 64, "ring header must fit before the first slot");
+
+void HeadlessBackend::writeRing() {
+    ShmRingHeader* header = (ShmRingHeader*)shm_;
+    uint64_t n = frames_ - 1;
+    ShmRingSlot* slot = (ShmRingSlot*)(shm_ + 64 + slot_bytes_ * (n % options_.shm_slots));
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    slot->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->present_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    memcpy((uint8_t*)(slot + 1), front_.pixels.data(), front_.byteCount());
+    slot->seq.store(n + 1, std::memory_order_release);
+    header->frames.store(frames_, std::memory_order_release);
+}
+
+// ─── PPM ─────────────────────────────────────────────────────────────────────
+
+bool writePPM(const Framebuffer& frame, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "[HEADLESS] Cannot write " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", frame.width, frame.height);
+    bool ok = fwrite(frame.pixels.data(), 1, frame.byteCount(), f) == frame.byteCount();
+    return (fclose(f) == 0) && ok;
+}
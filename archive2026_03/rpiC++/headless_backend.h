@@ -0,0 +1,86 @@
+// headless_backend.h - In-memory display backend (no GPIO)
+//
+// Presented frames are kept in memory and can optionally be written out:
+//
+//   PPM   --ppm frame.ppm        latest frame, replaced atomically each frame
+//         --ppm out/%06u.ppm     one numbered file per frame
+//   shm   --shm /led-matrix      POSIX shared-memory ring (layout below)
+//
+// A ring reader maps the object read-only, reads `frames`, and copies slot
+// (frames - 1) % slots, which starts at 64 + slot * slot_bytes. The slot's
+// `seq` is 0 while it is being written and the frame number + 1 once
+// complete; if it is not the same before and after the copy, the copy
+// raced the writer and should be retried.
+
+#ifndef HEADLESS_BACKEND_H
+#define HEADLESS_BACKEND_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "display_backend.h"
+
+#define HEADLESS_SHM_SLOTS 8
+#define HEADLESS_SHM_MAGIC "LEDRING1"
+
+struct ShmRingHeader {
+    char magic[8];                  // HEADLESS_SHM_MAGIC, set last
+    uint32_t width;
+    uint32_t height;
+    uint32_t slots;
+    uint32_t slot_bytes;            // Slot header + width * height * 3 RGB bytes
+    std::atomic<uint64_t> frames;   // Frames written so far
+};
+
+struct ShmRingSlot {
+    std::atomic<uint64_t> seq;      // 0 = being written, else frame number + 1
+    uint64_t present_ns;            // CLOCK_MONOTONIC at present()
+    // Row-major RGB888 pixels follow
+};
+
+struct HeadlessOptions {
+    std::string ppm_path;  // Empty = no PPM output; a printf pattern numbers each frame
+    std::string shm_name;  // Empty = no shared-memory ring
+    int shm_slots;
+
+    HeadlessOptions() : shm_slots(HEADLESS_SHM_SLOTS) {}
+};
+
+class HeadlessBackend : public DisplayBackend {
+public:
+    HeadlessBackend(int width, int height, const HeadlessOptions& options = HeadlessOptions());
+    ~HeadlessBackend();
+
+    const char* name() const override { return "headless"; }
+    int width() const override { return width_; }
+    int height() const override { return height_; }
+
+    // The renderer's frame is the back buffer, so the blit is free here
+    void blit(const Framebuffer&) override {}
+    void present(const Framebuffer& frame) override;
+    void clear() override;
+
+    // Last presented frame and number of frames presented
+    const Framebuffer& frontBuffer() const { return front_; }
+    uint64_t frameCount() const { return frames_; }
+
+private:
+    int width_;
+    int height_;
+    HeadlessOptions options_;
+    Framebuffer front_;
+    uint64_t frames_;
+
+    int shm_fd_;
+    uint8_t* shm_;
+    size_t shm_size_;
+    size_t slot_bytes_;
+
+    bool openRing();
+    void writeRing();
+};
+
+// Binary PPM (P6). Returns false if the file could not be written.
+bool writePPM(const Framebuffer& frame, const std::string& path);
+
+#endif // HEADLESS_BACKEND_H
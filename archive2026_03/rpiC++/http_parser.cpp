@@ -0,0 +1,225 @@
+// http_parser.cpp - Incremental HTTP/1.1 request parser implementation
+
+#include "http_parser.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+static std::string toLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+static std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    size_t end = s.find_last_not_of(" \t\r");
+    if (start == std::string::npos) return "";
+    return s.substr(start, end - start + 1);
+}
+
+// ─── HttpRequest ─────────────────────────────────────────────────────────────
+
+std::string HttpRequest::header(const std::string& name) const {
+    auto it = headers.find(name);
+    return (it != headers.end()) ? it->second : "";
+}
+
+bool HttpRequest::keepAlive() const {
+    std::string conn = toLower(header("connection"));
+    if (version == "HTTP/1.0") {
+        return conn.find("keep-alive") != std::string::npos;
+    }
+    return conn.find("close") == std::string::npos;
+}
+
+std::string HttpRequest::queryParam(const std::string& key) const {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        std::string pair = query.substr(pos, amp - pos);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == key) {
+            return (eq == std::string::npos) ? "" : pair.substr(eq + 1);
+        }
+        pos = amp + 1;
+    }
+    return "";
+}
+
+// ─── HttpResponse ────────────────────────────────────────────────────────────
+
+const char* HttpResponse::reason(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Internal Server Error";
+    }
+}
+
+std::string HttpResponse::serialize(bool keep_alive, bool include_body) const {
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << " " << reason(status) << "\r\n";
+    if (!content_type.empty()) {
+        response << "Content-Type: " << content_type << "\r\n";
+    }
+    for (const auto& h : headers) {
+        response << h.first << ": " << h.second << "\r\n";
+    }
+    if (status != 304 && status != 204) {
+        response << "Content-Length: " << body.length() << "\r\n";
+    }
+    response << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+    if (include_body) {
+        response << body;
+    }
+    return response.str();
+}
+
+// ─── HttpParser ──────────────────────────────────────────────────────────────
+
+HttpParser::HttpParser() {
+    reset();
+}
+
+void HttpParser::reset() {
+    request_ = HttpRequest();
+    phase_ = PHASE_HEADERS;
+    content_length_ = 0;
+    chunk_remaining_ = 0;
+    trailer_bytes_ = 0;
+    error_status_ = 0;
+}
+
+bool HttpParser::expectsContinue() const {
+    return toLower(request_.header("expect")) == "100-continue";
+}
+
+HttpParser::State HttpParser::fail(int status) {
+    error_status_ = status;
+    return ERROR;
+}
+
+bool HttpParser::parseHead(const std::string& head) {
+    std::istringstream lines(head);
+    std::string line;
+
+    if (!std::getline(lines, line)) return false;
+    std::istringstream request_line(line);
+    std::string target;
+    request_line >> request_.method >> target >> request_.version;
+    if (request_.method.empty() || target.empty() || request_.version.compare(0, 5, "HTTP/") != 0) {
+        return false;
+    }
+
+    size_t q = target.find('?');
+    request_.path = target.substr(0, q);
+    if (q != std::string::npos) request_.query = target.substr(q + 1);
+
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) return false;
+        request_.headers[toLower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+    return true;
+}
+
+HttpParser::State HttpParser::feed(std::string& buffer) {
+    size_t pos = 0;
+    State result = READING;
+
+    while (result == READING) {
+        if (phase_ == PHASE_HEADERS) {
+            size_t end = buffer.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                if (buffer.size() > HTTP_MAX_HEADER_BYTES) return fail(431);
+                break;
+            }
+            if (end > HTTP_MAX_HEADER_BYTES) return fail(431);
+            if (!parseHead(buffer.substr(0, end))) return fail(400);
+            pos = end + 4;
+
+            std::string te = toLower(request_.header("transfer-encoding"));
+            std::string cl = request_.header("content-length");
+            if (!te.empty()) {
+                if (te != "chunked") return fail(501);
+                phase_ = PHASE_CHUNK_SIZE;
+            } else if (!cl.empty()) {
+                char* endp = nullptr;
+                unsigned long long len = strtoull(cl.c_str(), &endp, 10);
+                if (*endp != '\0') return fail(400);
+                if (len > HTTP_MAX_BODY_BYTES) return fail(413);
+                content_length_ = (size_t)len;
+                phase_ = content_length_ ? PHASE_BODY : PHASE_DONE;
+            } else {
+                phase_ = PHASE_DONE;
+            }
+        } else if (phase_ == PHASE_BODY) {
+            size_t take = std::min(content_length_ - request_.body.size(), buffer.size() - pos);
+            request_.body.append(buffer, pos, take);
+            pos += take;
+            if (request_.body.size() < content_length_) break;
+            phase_ = PHASE_DONE;
+        } else if (phase_ == PHASE_CHUNK_SIZE) {
+            size_t eol = buffer.find("\r\n", pos);
+            if (eol == std::string::npos) {
+                if (buffer.size() - pos > 64) return fail(400);
+                break;
+            }
+            std::string size_line = buffer.substr(pos, eol - pos);
+            size_line = size_line.substr(0, size_line.find(';'));  // Ignore chunk extensions
+            char* endp = nullptr;
+            errno = 0;
+            unsigned long long size = strtoull(size_line.c_str(), &endp, 16);
+            if (endp == size_line.c_str()) return fail(400);
+            // Written as a subtraction: a saturated size must not wrap past the limit
+            if (errno == ERANGE || size > HTTP_MAX_BODY_BYTES - request_.body.size()) return fail(413);
+            pos = eol + 2;
+            chunk_remaining_ = (size_t)size;
+            phase_ = size ? PHASE_CHUNK_DATA : PHASE_TRAILERS;
+        } else if (phase_ == PHASE_CHUNK_DATA) {
+            size_t take = std::min(chunk_remaining_, buffer.size() - pos);
+            request_.body.append(buffer, pos, take);
+            pos += take;
+            chunk_remaining_ -= take;
+            if (chunk_remaining_ > 0) break;
+            phase_ = PHASE_CHUNK_END;
+        } else if (phase_ == PHASE_CHUNK_END) {
+            if (buffer.size() - pos < 2) break;
+            if (buffer.compare(pos, 2, "\r\n") != 0) return fail(400);
+            pos += 2;
+            phase_ = PHASE_CHUNK_SIZE;
+        } else if (phase_ == PHASE_TRAILERS) {
+            // Trailer fields are skipped; an empty line ends the message.
+            // Together they get the same allowance as the header block.
+            size_t eol = buffer.find("\r\n", pos);
+            if (eol == std::string::npos) {
+                if (trailer_bytes_ + buffer.size() - pos > HTTP_MAX_HEADER_BYTES) return fail(431);
+                break;
+            }
+            trailer_bytes_ += eol + 2 - pos;
+            if (trailer_bytes_ > HTTP_MAX_HEADER_BYTES) return fail(431);
+            bool last = (eol == pos);
+            pos = eol + 2;
+            if (last) phase_ = PHASE_DONE;
+        } else {
+            result = COMPLETE;
+        }
+    }
+
+    buffer.erase(0, pos);
+    return result;
+}
@@ -0,0 +1,80 @@
+// http_parser.h - Incremental HTTP/1.1 request parser
+
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define HTTP_MAX_HEADER_BYTES 8192
+#define HTTP_MAX_BODY_BYTES   (256 * 1024)
+
+struct HttpRequest {
+    std::string method;
+    std::string path;     // Without query string
+    std::string query;    // Text after '?', undecoded
+    std::string version;  // "HTTP/1.1"
+    std::map<std::string, std::string> headers;  // Names lower-cased
+    std::string body;
+
+    std::string header(const std::string& name) const;
+    bool keepAlive() const;
+    std::string queryParam(const std::string& key) const;
+};
+
+struct HttpResponse {
+    int status;
+    std::string content_type;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;  // Extra headers
+
+    HttpResponse(int status_ = 200, const std::string& type = "text/html", const std::string& body_ = "")
+        : status(status_), content_type(type), body(body_) {}
+
+    // Status line, headers and body; Content-Length and Connection are added here
+    std::string serialize(bool keep_alive, bool include_body = true) const;
+
+    static const char* reason(int status);
+};
+
+// Feeds on a connection's receive buffer. Bytes belonging to the next
+// (pipelined) request are left in the buffer after COMPLETE.
+class HttpParser {
+public:
+    enum State { READING, COMPLETE, ERROR };
+
+    HttpParser();
+
+    State feed(std::string& buffer);
+    void reset();
+
+    HttpRequest& request() { return request_; }
+    bool headersComplete() const { return phase_ > PHASE_HEADERS; }
+    bool expectsContinue() const;
+    int errorStatus() const { return error_status_; }
+
+private:
+    enum Phase {
+        PHASE_HEADERS,
+        PHASE_BODY,
+        PHASE_CHUNK_SIZE,
+        PHASE_CHUNK_DATA,
+        PHASE_CHUNK_END,
+        PHASE_TRAILERS,
+        PHASE_DONE
+    };
+
+    HttpRequest request_;
+    Phase phase_;
+    size_t content_length_;
+    size_t chunk_remaining_;
+    size_t trailer_bytes_;
+    int error_status_;
+
+    State fail(int status);
+    bool parseHead(const std::string& head);
+};
+
+#endif // HTTP_PARSER_H
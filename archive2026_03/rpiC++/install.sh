@@ -7,6 +7,7 @@ set -e
 REPO_URL="https://github.com/DHPKE/QSYS-LED-Matrix.git"
 INSTALL_DIR="/home/$SUDO_USER/rpiC++"
 RGB_MATRIX_DIR="/tmp/rpi-rgb-led-matrix"
+BDF_FONT_DIR="/usr/share/fonts/led-matrix"  # BDF_FONT_DIR in config.h
 
 echo "╔════════════════════════════════════════════════════════════╗"
 echo "║  RPi C++ LED Matrix Controller - Full Installer           ║"
@@ -118,6 +119,17 @@ else
     echo "✓ rpi-rgb-led-matrix library installed"
 fi
 
+# BDF bitmap fonts for small segments (BDF_FONT_DIR) - on every run, so an
+# upgrade over an existing library install gets them too
+if [ ! -d "$RGB_MATRIX_DIR/fonts" ]; then
+    echo "Fetching BDF fonts from rpi-rgb-led-matrix..."
+    rm -rf "$RGB_MATRIX_DIR"
+    sudo -u "$REAL_USER" git clone --depth 1 https://github.com/hzeller/rpi-rgb-led-matrix.git "$RGB_MATRIX_DIR"
+fi
+mkdir -p "$BDF_FONT_DIR"
+cp "$RGB_MATRIX_DIR"/fonts/*.bdf "$BDF_FONT_DIR"/
+echo "✓ $(ls "$BDF_FONT_DIR"/*.bdf | wc -l) BDF fonts in $BDF_FONT_DIR"
+
 echo ""
 
 # ─── 4. Fetch Latest Controller Code ─────────────────────────────────────────
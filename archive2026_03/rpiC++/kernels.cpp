@@ -0,0 +1,71 @@
+// kernels.cpp - Geometry-specialized render kernels
+
+#include "kernels.h"
+#include <algorithm>
+
+namespace {
+
+// n pixels of one colour from p on: a store loop the compiler vectorizes
+inline void fillPixels(uint8_t* p, int n, uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < n; i++, p += 3) {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+}
+
+// One instance per geometry; W = H = 0 is the generic one
+template <int W, int H>
+void fillRect(Framebuffer& fb, const RowBand& band, int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b) {
+    const int width = W ? W : fb.width;
+    const int height = H ? H : fb.height;
+
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, std::max(band.y0, 0));
+    int x1 = std::min(x + w, width);
+    int y1 = std::min(y + h, std::min(band.y1, height));
+    if (x0 >= x1 || y0 >= y1) return;
+
+    uint8_t* row = fb.pixels.data() + ((size_t)y0 * width + x0) * 3;
+    if (x0 == 0 && x1 == width) {
+        // Whole rows are one contiguous run
+        fillPixels(row, (y1 - y0) * width, r, g, b);
+        return;
+    }
+    for (int yy = y0; yy < y1; yy++, row += (size_t)width * 3) {
+        fillPixels(row, x1 - x0, r, g, b);
+    }
+}
+
+// Four strips; together they cover the same ring as drawing `thickness`
+// nested one-pixel outlines
+template <int W, int H>
+void frameRect(Framebuffer& fb, const RowBand& band, int x, int y, int w, int h, int thickness,
+               uint8_t r, uint8_t g, uint8_t b) {
+    int t = std::min(thickness, std::min(w, h));
+    if (t <= 0) return;
+    fillRect<W, H>(fb, band, x, y, w, t, r, g, b);                  // Top
+    fillRect<W, H>(fb, band, x, y + h - t, w, t, r, g, b);          // Bottom
+    fillRect<W, H>(fb, band, x, y + t, t, h - 2 * t, r, g, b);      // Left
+    fillRect<W, H>(fb, band, x + w - t, y + t, t, h - 2 * t, r, g, b);  // Right
+}
+
+#define KERNEL_ENTRY(w, h) {#w "x" #h, &fillRect<w, h>, &frameRect<w, h>},
+const RenderKernels SPECIALIZED[] = {KERNEL_GEOMETRIES(KERNEL_ENTRY)};
+#undef KERNEL_ENTRY
+
+const RenderKernels GENERIC = {"generic", &fillRect<0, 0>, &frameRect<0, 0>};
+
+}  // namespace
+
+const RenderKernels& selectKernels(int width, int height) {
+    int i = 0;
+#define KERNEL_MATCH(w, h) if (width == w && height == h) return SPECIALIZED[i]; i++;
+    KERNEL_GEOMETRIES(KERNEL_MATCH)
+#undef KERNEL_MATCH
+    return GENERIC;
+}
+
+const RenderKernels& genericKernels() {
+    return GENERIC;
+}
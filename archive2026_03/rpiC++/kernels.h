@@ -0,0 +1,56 @@
+// kernels.h - Fill, border and blit kernels specialized on canvas geometry
+//
+// The fleet runs a handful of panel geometries (KERNEL_GEOMETRIES). For
+// those the kernels are instantiated with the canvas size as template
+// parameters: row strides are constants, full-width rows are filled by
+// fixed-count loops the compiler unrolls, and rectangles are clipped once
+// up front so the inner loops carry no bounds checks. Any other size runs
+// the same code with the size read at runtime (the "generic" kernels).
+// selectKernels() picks once, when the renderer is created.
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+#include "framebuffer.h"
+
+// Canvas sizes with specialized kernels (width, height), portrait included
+#define KERNEL_GEOMETRIES(X) X(64, 32) X(32, 64) X(64, 64) X(128, 32) X(32, 128) X(128, 64) X(256, 64)
+
+// Rows [y0, y1) a kernel may write: the whole canvas, or the band one
+// render thread composes
+struct RowBand {
+    int y0, y1;
+};
+
+struct RenderKernels {
+    const char* name;  // "64x32" ... or "generic"
+
+    // Solid rectangle, clipped to the canvas and the band
+    void (*fill_rect)(Framebuffer& fb, const RowBand& band, int x, int y, int w, int h,
+                      uint8_t r, uint8_t g, uint8_t b);
+
+    // Border `thickness` pixels wide along the inside of the rectangle
+    void (*frame_rect)(Framebuffer& fb, const RowBand& band, int x, int y, int w, int h, int thickness,
+                       uint8_t r, uint8_t g, uint8_t b);
+};
+
+// Kernels for a canvas of this size (the generic ones if it has none)
+const RenderKernels& selectKernels(int width, int height);
+const RenderKernels& genericKernels();
+
+// Hand every pixel of `frame` to sink.SetPixel(x, y, r, g, b), row-major.
+// W / H of 0 read the size from the frame (the generic instance).
+template <int W, int H, typename Sink>
+inline void blitPixels(const Framebuffer& frame, Sink* sink) {
+    const int width = W ? W : frame.width;
+    const int height = H ? H : frame.height;
+    const uint8_t* p = frame.pixels.data();
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++, p += 3) {
+            sink->SetPixel(x, y, p[0], p[1], p[2]);
+        }
+    }
+}
+
+#endif // KERNELS_H
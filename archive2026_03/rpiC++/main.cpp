@@ -12,23 +12,37 @@
 #include <net/if.h>
 #include <arpa/inet.h>
 #include <fstream>
+#include <fcntl.h>
+#include <sys/wait.h>
 #include "nlohmann/json.hpp"
 
-#include "led-matrix.h"
 #include "segment_manager.h"
 #include "udp_handler.h"
 #include "text_renderer.h"
 #include "web_server.h"
+#include "pixel_stream.h"
+#include "sync_clock.h"
+#include "wall_sync.h"
+#include "frame_mailbox.h"
+#include "net_monitor.h"
+#include "thread_policy.h"
+#include "trace.h"
+#include "metrics.h"
+#include "display_backend.h"
+#include "headless_backend.h"
+#include "udp_capture.h"
+#ifndef LED_MATRIX_HEADLESS
+#include "matrix_backend.h"
+#endif
 #include "config.h"
 
 using json = nlohmann::json;
 
-using namespace rgb_matrix;
-
 // Global pointers for signal handlers
-RGBMatrix* g_matrix = nullptr;
+DisplayBackend* g_display = nullptr;
 UDPHandler* g_udp_handler = nullptr;
 static volatile bool interrupt_received = false;
+static volatile bool restart_requested = false;  // Brightness / rotation change
 
 // Brightness changes are DISABLED - SetBrightness() causes the service to freeze
 // Set brightness at startup only via config file
@@ -39,24 +53,6 @@ static void InterruptHandler(int signo) {
 
 // ─── Network Helpers ─────────────────────────────────────────────────────────
 
-std::string getIP(const std::string& iface) {
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd < 0) return "";
-    
-    struct ifreq ifr;
-    memset(&ifr, 0, sizeof(ifr));
-    strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
-    
-    if (ioctl(fd, SIOCGIFADDR, &ifr) < 0) {
-        close(fd);
-        return "";
-    }
-    
-    close(fd);
-    struct sockaddr_in* addr = (struct sockaddr_in*)&ifr.ifr_addr;
-    return inet_ntoa(addr->sin_addr);
-}
-
 bool applyFallbackIP(const std::string& ip, const std::string& netmask,
                     const std::string& gateway, const std::string& iface) {
     // Calculate prefix length from netmask
@@ -108,9 +104,10 @@ std::string ensureNetwork() {
         std::this_thread::sleep_for(std::chrono::seconds(2));
     }
     
-    // Wait for DHCP
+    // Wait for DHCP (runs beside the render loop, so give up on shutdown)
     auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(DHCP_TIMEOUT_S);
     while (std::chrono::steady_clock::now() < deadline) {
+        if (interrupt_received) return "";
         std::string ip = getIP(FALLBACK_IFACE);
         if (!ip.empty() && ip.substr(0, 4) != "127." && ip != FALLBACK_IP) {
             std::cout << "[NET] ✓ DHCP address: " << ip << std::endl;
@@ -133,97 +130,88 @@ std::string ensureNetwork() {
     return "no IP";
 }
 
+// Read the font files once so they sit in the page cache before the first
+// text command needs them (an SD card read otherwise lands in that frame)
+static void prefetchFonts() {
+    for (const char* path : {FONT_PATH, FONT_PATH_FALLBACK, FONT_MONO_PATH}) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        char buf[64 * 1024];
+        while (read(fd, buf, sizeof(buf)) > 0) continue;
+        close(fd);
+    }
+}
+
+// ─── Command Line ────────────────────────────────────────────────────────────
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--headless] [--ppm PATH] [--shm NAME] [--capture FILE] [--trace] [--config FILE]" << std::endl
+              << "  --headless      Render in memory instead of to the LED panel (no GPIO)" << std::endl
+              << "  --ppm PATH      Headless: write each frame to PATH (printf pattern = numbered files)" << std::endl
+              << "  --shm NAME      Headless: publish frames to a POSIX shared-memory ring" << std::endl
+              << "  --capture FILE  Record every received datagram for led-matrix-replay" << std::endl
+              << "  --trace         Start with span tracing on (GET /api/trace to dump)" << std::endl
+              << "  --config FILE   Read and save settings here instead of " << CONFIG_FILE << std::endl;
+}
+
 // ─── Main ────────────────────────────────────────────────────────────────────
 
 int main(int argc, char* argv[]) {
+    const auto process_start = std::chrono::steady_clock::now();
+#ifdef LED_MATRIX_HEADLESS
+    bool headless = true;  // Built without rgbmatrix
+#else
+    bool headless = false;
+#endif
+    HeadlessOptions headless_options;
+    std::string capture_path;
+    std::string config_path = CONFIG_FILE;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--ppm" && i + 1 < argc) {
+            headless_options.ppm_path = argv[++i];
+        } else if (arg == "--shm" && i + 1 < argc) {
+            headless_options.shm_name = argv[++i];
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (arg == "--trace") {
+            traceEnable(true);
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!headless && (!headless_options.ppm_path.empty() || !headless_options.shm_name.empty())) {
+        std::cerr << "--ppm and --shm need --headless" << std::endl;
+        return 1;
+    }
+    
     std::cout << "==================================================" << std::endl;
     std::cout << "RPi RGB LED Matrix Controller (C++)" << std::endl;
     std::cout << "==================================================" << std::endl;
-    std::cout << "Matrix: " << MATRIX_WIDTH << "×" << MATRIX_HEIGHT 
-             << ", chain=" << MATRIX_CHAIN << std::endl;
     std::cout << "UDP port: " << UDP_PORT << ",  Web port: " << WEB_PORT << std::endl;
     
-    // ── 1. Network setup ─────────────────────────────────────────────────────
-    std::string device_ip = ensureNetwork();
-    
-    //── 3. Setup segment manager and load initial config ─────────────────────
-    SegmentManager sm;
-    
-    // Load rotation from config before matrix init
-    Rotation initial_rotation = ROTATION_0;
-    {
-        std::ifstream config_file(CONFIG_FILE);
-        if (config_file.is_open()) {
-            try {
-                json config;
-                config_file >> config;
-                int rotation_value = config.value("rotation", 0);
-                if (rotation_value == 0) initial_rotation = ROTATION_0;
-                else if (rotation_value == 90) initial_rotation = ROTATION_90;
-                else if (rotation_value == 180) initial_rotation = ROTATION_180;
-                else if (rotation_value == 270) initial_rotation = ROTATION_270;
-                std::cout << "[INIT] Loaded rotation from config: " << rotation_value << "°" << std::endl;
-            } catch (...) {
-                std::cout << "[INIT] Could not load rotation from config, using default (0°)" << std::endl;
-            }
-        }
-    }
-    
-    // ── 4. Setup RGB matrix ──────────────────────────────────────────────────
-    RGBMatrix::Options matrix_options;
-    RuntimeOptions runtime_opt;
-    
-    matrix_options.rows = MATRIX_HEIGHT;
-    matrix_options.cols = MATRIX_WIDTH;
-    matrix_options.chain_length = MATRIX_CHAIN;
-    matrix_options.parallel = MATRIX_PARALLEL;
-    matrix_options.hardware_mapping = HARDWARE_MAPPING;
-    matrix_options.brightness = BRIGHTNESS;
-    matrix_options.pwm_bits = PWM_BITS;
-    matrix_options.pwm_lsb_nanoseconds = PWM_LSB_NANOSECONDS;
-    matrix_options.scan_mode = SCAN_MODE;
-    matrix_options.row_address_type = ROW_ADDR_TYPE;
-    matrix_options.multiplexing = MULTIPLEXING;
-    matrix_options.pwm_dither_bits = PWM_DITHER_BITS;
-    matrix_options.led_rgb_sequence = LED_RGB_SEQUENCE;
-    matrix_options.limit_refresh_rate_hz = REFRESH_LIMIT;
-    matrix_options.disable_hardware_pulsing = true;  // Avoid audio conflict
-    matrix_options.show_refresh_rate = false;        // Disable refresh overlay
-    matrix_options.inverse_colors = false;           // Normal color display
-    
-    // Set pixel mapper for rotation
-    const char* pixel_mapper = "";
-    switch (initial_rotation) {
-        case ROTATION_0:
-            pixel_mapper = "";  // No rotation
-            break;
-        case ROTATION_90:
-            pixel_mapper = "Rotate:90";
-            break;
-        case ROTATION_180:
-            pixel_mapper = "Rotate:180";
-            break;
-        case ROTATION_270:
-            pixel_mapper = "Rotate:270";
-            break;
-    }
-    matrix_options.pixel_mapper_config = pixel_mapper;
+    // Thread policies are read while still root (the matrix drops privileges)
+    // and before any of our threads start
+    loadThreadPolicies(config_path.c_str());
     
-    runtime_opt.gpio_slowdown = GPIO_SLOWDOWN;
-    runtime_opt.drop_privileges = 1;  // Drop root after init
-    runtime_opt.daemon = 0;            // Run in foreground
-    runtime_opt.do_gpio_init = true;   // Initialize GPIO properly
+    // Installed first so a stop during startup is orderly
+    signal(SIGINT, InterruptHandler);
+    signal(SIGTERM, InterruptHandler);
     
-    g_matrix = RGBMatrix::CreateFromOptions(matrix_options, runtime_opt);
-    if (!g_matrix) {
-        std::cerr << "Failed to create RGB matrix" << std::endl;
-        return 1;
-    }
+    // Startup order: display, renderer and content first, so the panel lights
+    // up within a frame or two of a restart; the network, UDP, web server and
+    // font prefetch come up concurrently and the splash follows the address.
     
-    std::cout << "✓ LED matrix initialized (" << g_matrix->width() << "×" 
-             << g_matrix->height() << ")" << std::endl;
+    // ── 1. Segment state and config ──────────────────────────────────────────
+    SyncClock sync_clock;
+    SegmentManager sm;
+    sm.setClock(&sync_clock);
     
-    // ── 4. Brightness callback ───────────────────────────────────────────────
     // SetBrightness() causes freeze, so brightness changes trigger restart instead
     // Config is already saved by UDPHandler before calling this callback
     auto on_brightness_change = [](int value_255) {
@@ -234,10 +222,10 @@ int main(int argc, char* argv[]) {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
         
         // Trigger clean shutdown - systemd will restart us with new brightness
+        restart_requested = true;
         interrupt_received = true;
     };
     
-    // ── 5. Orientation callback ──────────────────────────────────────────────
     auto on_orientation_change = [&sm](Orientation orient) {
         std::cout << "[MAIN] Orientation → " 
                  << (orient == PORTRAIT ? "portrait" : "landscape") << std::endl;
@@ -250,7 +238,6 @@ int main(int argc, char* argv[]) {
         }
     };
     
-    // ── 6. Rotation callback ─────────────────────────────────────────────────
     auto on_rotation_change = [](Rotation rotation) {
         int angle = static_cast<int>(rotation);
         std::cout << "[MAIN] Rotation changed to " << angle << "° - restarting service..." << std::endl;
@@ -259,165 +246,209 @@ int main(int argc, char* argv[]) {
         // systemd will restart us automatically
         std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Give time for config save
         std::cout << "[MAIN] Initiating restart for rotation change" << std::endl;
+        restart_requested = true;
         interrupt_received = true; // Trigger clean shutdown
     };
     
-    // ── 7. Start UDP listener ────────────────────────────────────────────────
-    g_udp_handler = new UDPHandler(&sm, on_brightness_change, on_orientation_change, on_rotation_change);
-    g_udp_handler->start();
+    // The handler parses config.json once; rotation for the display comes from it
+    PixelStream pixel_stream;
+    g_udp_handler = new UDPHandler(&sm, on_brightness_change, on_orientation_change, on_rotation_change,
+                                   config_path);
+    g_udp_handler->setPixelStream(&pixel_stream);
+    g_udp_handler->setSyncClock(&sync_clock);
+    Rotation initial_rotation = g_udp_handler->getRotation();
+    const PanelGeometry& panel = g_udp_handler->getPanel();
+    std::cout << "Matrix: " << panel.width << "×" << panel.height
+             << ", chain=" << panel.chain << ", parallel=" << panel.parallel
+             << " (" << panel.canvasWidth() << "×" << panel.canvasHeight() << " canvas)" << std::endl;
+    
+    // ── 2. Network ───────────────────────────────────────────────────────────
+    // DHCP wait and fallback address run beside everything else. They need
+    // root, which the matrix drops as it starts, so they get a child process
+    // forked here - still root, and before any thread exists. A headless run
+    // is a guest on someone else's machine: it never touches the interface.
+    pid_t network_pid = -1;
+    if (!headless) {
+        network_pid = fork();
+        if (network_pid == 0) {
+            std::string ip = ensureNetwork();
+            if (!interrupt_received) {
+                std::cout << "[NET] Network ready: " << ip << std::endl;
+            }
+            _exit(0);
+        }
+        if (network_pid < 0) {
+            std::cerr << "[NET] fork failed - configuring the network before the display" << std::endl;
+            ensureNetwork();
+        }
+    }
+    
+    // ── 3. Display ───────────────────────────────────────────────────────────
+    if (headless) {
+        // Same canvas the panel would have, pixel mapper rotation included
+        int width = panel.canvasWidth();
+        int height = panel.canvasHeight();
+        if (initial_rotation == ROTATION_90 || initial_rotation == ROTATION_270) {
+            std::swap(width, height);
+        }
+        g_display = new HeadlessBackend(width, height, headless_options);
+    } else {
+#ifndef LED_MATRIX_HEADLESS
+        g_display = createMatrixBackend(initial_rotation, panel);
+#endif
+    }
+    if (!g_display) {
+        return 1;
+    }
+    
+    // Until a layout arrives, segment 0 covers the whole canvas
+    sm.resetLayout(g_display->width(), g_display->height());
+    
+    FrameMailbox preview_mailbox;
+    TextRenderer renderer(g_display, &sm, &pixel_stream);
+    renderer.setPreview(&preview_mailbox);
+    renderer.setRenderTiles(g_udp_handler->getRenderTiles());
+    if (!headless) {
+        // Glyphs rendered by earlier runs: the first frame skips FreeType
+        renderer.openGlyphCache(GLYPH_CACHE_FILE);
+    }
+    renderer.loadBitmapFonts(BDF_FONT_DIR);
+    
+    // A wall node shows its viewport of the virtual canvas; the splash goes
+    // where this node's panel is, and effects run on the wall's frame time
+    const WallConfig& wall = g_udp_handler->getWall();
+    WallSync wall_sync;
+    if (wall.enabled) {
+        sm.configure(0, wall.x, wall.y, g_display->width(), g_display->height());
+        sm.setWallTime(true);
+        renderer.setViewport(wall.x, wall.y);
+        g_udp_handler->setWallSync(&wall_sync);
+    }
     
-    // Note: rotation is already applied during matrix init from loaded config
+    // ── 4. First frame: last content, or the IP splash ───────────────────────
+    // A brightness / rotation restart saved what was on the panel; it goes
+    // straight back up. Otherwise show whatever address the interface has now
+    // (a restart keeps its lease) - the splash follows the network from here.
+    bool ip_splash_active = true;
+    std::string device_ip = getIP(FALLBACK_IFACE);
+    if (device_ip.empty()) device_ip = headless ? "headless" : "...";
+    
+    int restored_layout = 1;
+    if (!headless && sm.loadContent(SEGMENT_FILE, restored_layout)) {
+        remove(SEGMENT_FILE);  // One-shot: a power cycle shows the splash again
+        g_udp_handler->restoreLayout(restored_layout);
+        ip_splash_active = false;
+        std::cout << "[INIT] Restored content from before the restart (layout "
+                 << restored_layout << ")" << std::endl;
+    } else {
+        sm.updateText(0, device_ip, "FFFFFF", "000000", "C", "none");
+        sm.setFrame(0, true, "FFFFFF", 1);
+        sm.markDirty(0);
+        std::cout << "[SPLASH] Showing IP address: " << device_ip << std::endl;
+    }
+    renderer.renderAll();
+    
+    uint64_t first_pixel_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - process_start).count();
+    metrics().first_pixel_us.store(first_pixel_us, std::memory_order_relaxed);
+    std::cout << "[INIT] ✓ First frame on the display " << first_pixel_us / 1000 << " ms after start" << std::endl;
+    
+    // ── 5. Background bring-up ───────────────────────────────────────────────
+    // Hostname / address changes reach the splash through the monitor
+    NetMonitor net_monitor(FALLBACK_IFACE);
+    net_monitor.start();
+    uint64_t net_generation = 0;
+    
+    std::thread font_thread(prefetchFonts);
+    
+    CaptureWriter capture;
+    if (!capture_path.empty() && capture.open(capture_path)) {
+        g_udp_handler->setCapture(&capture);
+    }
+    g_udp_handler->start();
     
-    // Apply initial layout based on loaded orientation
     std::cout << "[MAIN] Initial orientation: " 
              << (g_udp_handler->getOrientation() == PORTRAIT ? "portrait" : "landscape") 
              << std::endl;
-    // UDP handler already loaded config, layout will be applied on first command
     
-    // ── 8. Start web config server ───────────────────────────────────────────
     WebServer web_server(WEB_PORT);
+    web_server.setPreviewSource(&preview_mailbox);
     web_server.start();
     
-    // ── 8. IP splash screen ──────────────────────────────────────────────────
-    TextRenderer renderer(g_matrix, &sm);
-    
-    // ── 8. IP splash screen ──────────────────────────────────────────────────
-    bool ip_splash_active = true;
-    sm.updateText(0, device_ip, "FFFFFF", "000000", "C", "none");
-    sm.setFrame(0, true, "FFFFFF", 1);
-    sm.markDirty(0);
-    std::cout << "[SPLASH] Showing IP address: " << device_ip << std::endl;
-    
-    // ── 9. Setup signal handlers ─────────────────────────────────────────────
-    signal(SIGINT, InterruptHandler);
-    signal(SIGTERM, InterruptHandler);
+    // Everything is started: pin the render (main) thread and lock memory
+    applyThreadPolicy("render", "led-render");
+    lockMemory();
     
     std::cout << "==================================================" << std::endl;
     std::cout << "System ready — press Ctrl+C to stop" << std::endl;
     std::cout << "==================================================" << std::endl;
     
-    // ── 10. Main render loop ─────────────────────────────────────────────────
-    auto last_effect = std::chrono::steady_clock::now();
-    auto last_render = std::chrono::steady_clock::now();
-    const int TARGET_FPS = 20;  // Lower FPS for lower CPU
-    const int FRAME_TIME_MS = 1000 / TARGET_FPS;
-    const int MIN_RENDER_INTERVAL_MS = 50;  // 20fps max - balance between smooth and low CPU
+    // ── 6. Main render loop ──────────────────────────────────────────────────
+    // Frames fall on absolute deadlines EFFECT_INTERVAL apart, so render time
+    // never stretches the period and the frame rate does not drift
+    const auto frame_period = std::chrono::milliseconds(EFFECT_INTERVAL);
+    auto next_frame = std::chrono::steady_clock::now();
+    
+    // Wall: the master counts frames from here and beacons each one; a
+    // follower renders on the beacon instead of its own deadline
+    const auto wall_epoch = next_frame;
+    uint64_t wall_frame = 0;
+    bool wall_beacon = false;
     
     while (!interrupt_received) {
         auto now = std::chrono::steady_clock::now();
         
-        // Check for test mode
+        // Check for test mode ("1" or "1 <pattern>" enables it)
         static bool test_mode_active = false;
         static bool test_mode_was_active = false;
-        static int test_bar_offset = 0;
+        static TestPattern test_pattern = PATTERN_BARS;
         std::ifstream testfile("/tmp/led-matrix-testmode");
         if (testfile.is_open()) {
-            char c;
-            testfile >> c;
+            char c = '0';
+            std::string pattern_name;
+            testfile >> c >> pattern_name;
             test_mode_active = (c == '1');
+            test_pattern = parseTestPattern(pattern_name);
             testfile.close();
         }
+        g_udp_handler->setTestMode(test_mode_active);
         
-        // Clear all segments when entering test mode
+        // The pattern is a render layer: it is composed off-screen with the
+        // segment text and presented through SwapOnVSync like any other frame
         if (test_mode_active && !test_mode_was_active) {
-            std::cout << "[TEST] Entering test mode - clearing display..." << std::endl;
+            std::cout << "[TEST] Entering test mode" << std::endl;
             sm.clearAll();
-            // Clear matrix multiple times to ensure it's black
-            for (int i = 0; i < 5; i++) {
-                g_matrix->Clear();
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            test_bar_offset = 0; // Reset bar position
-            std::cout << "[TEST] Display cleared, starting test pattern" << std::endl;
+        } else if (!test_mode_active && test_mode_was_active) {
+            std::cout << "[TEST] Leaving test mode" << std::endl;
+            sm.clearAll();
+            renderer.setTestPattern(PATTERN_NONE);
         }
-        test_mode_was_active = test_mode_active;
         
         if (test_mode_active) {
-            // Skip first few frames after entering test mode to let clear take effect
-            static int frames_since_test_start = 0;
-            static auto test_mode_start_time = std::chrono::steady_clock::now();
-            static bool initial_clear_done = false;
-            
-            if (!test_mode_was_active) {
-                frames_since_test_start = 0;
-                test_mode_start_time = now;
-                initial_clear_done = false;
-            }
-            frames_since_test_start++;
-            
-            // Keep clearing for first 1 second (30 frames at 30fps)
-            auto elapsed_since_start = std::chrono::duration_cast<std::chrono::milliseconds>(now - test_mode_start_time);
-            if (elapsed_since_start.count() < 1000) {
-                sm.clearAll(); // Keep segments clear
-                g_matrix->Clear(); // Keep clearing
-                std::this_thread::sleep_for(std::chrono::milliseconds(33));
-                continue;
-            }
-            
-            // After blackout, ensure segments are cleared once before starting pattern
-            if (!initial_clear_done) {
-                sm.clearAll();
-                initial_clear_done = true;
-            }
-            
-            // Render test pattern: 4-state cycle (hostname top, blank, IP bottom, blank)
-            
-            // Reset cycle state when entering test mode
-            static bool test_mode_just_started = false;
-            if (!test_mode_was_active) {
-                test_mode_just_started = true;
-            }
-            
-            // Get current hostname (refresh every 10 seconds)
-            static std::string hostname = "led-matrix";
-            static auto last_hostname_fetch = std::chrono::steady_clock::now();
-            auto hostname_elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_hostname_fetch);
-            if (hostname_elapsed.count() >= 10) {
-                FILE* pipe = popen("hostname", "r");
-                if (pipe) {
-                    char buf[128];
-                    if (fgets(buf, sizeof(buf), pipe)) {
-                        hostname = buf;
-                        if (!hostname.empty() && hostname.back() == '\n') {
-                            hostname.pop_back();
-                        }
-                    }
-                    pclose(pipe);
-                }
-                last_hostname_fetch = now;
-            }
-            
-            // Get current IP address (refresh every 10 seconds)
-            static std::string test_device_ip = device_ip;
-            static auto last_ip_fetch = std::chrono::steady_clock::now();
-            auto ip_elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_ip_fetch);
-            if (ip_elapsed.count() >= 10) {
-                // Get IP from eth1 (same as ensureNetwork)
-                FILE* pipe = popen("ip -4 addr show eth1 2>/dev/null | grep -oP '(?<=inet\\s)\\d+(\\.\\d+){3}'", "r");
-                if (pipe) {
-                    char buf[64];
-                    if (fgets(buf, sizeof(buf), pipe)) {
-                        test_device_ip = buf;
-                        if (!test_device_ip.empty() && test_device_ip.back() == '\n') {
-                            test_device_ip.pop_back();
-                        }
-                    }
-                    pclose(pipe);
-                }
-                last_ip_fetch = now;
-            }
-            
             // 4-state cycle every second: 0=hostname top, 1=blank, 2=IP bottom, 3=blank
             static auto last_cycle_switch = std::chrono::steady_clock::now();
             static int cycle_state = 0;
             static int last_cycle_state = -1;
             
-            // Reset cycle on test mode start
-            if (test_mode_just_started) {
+            // Hostname and IP come from the network monitor (no forking from the render loop)
+            static std::string hostname = "led-matrix";
+            static std::string test_device_ip = device_ip;
+            static uint64_t test_net_generation = UINT64_MAX;
+            
+            if (!test_mode_was_active) {
                 cycle_state = 0;
                 last_cycle_state = -1;
                 last_cycle_switch = now;
-                test_mode_just_started = false;
+            }
+            test_mode_was_active = true;
+            renderer.setTestPattern(test_pattern);
+            
+            if (net_monitor.generation() != test_net_generation) {
+                test_net_generation = net_monitor.generation();
+                NetMonitor::Status status = net_monitor.status();
+                hostname = status.hostname;
+                test_device_ip = status.ip.empty() ? "no IP" : status.ip;
+                last_cycle_state = -1;  // Redraw the current line with the new text
             }
             
             auto cycle_elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_cycle_switch);
@@ -426,49 +457,19 @@ int main(int argc, char* argv[]) {
                 last_cycle_switch = now;
             }
             
-            // Draw vertical color bars (full height)
-            const int bar_width = MATRIX_WIDTH / 5; // Even wider bars (1/5 = ~13px)
-            const int num_bars = 8;
-            
-            // Colors: Red, Green, Blue, Cyan, Magenta, Yellow, White, Black
-            const int colors[][3] = {
-                {255, 0, 0},    // Red
-                {0, 255, 0},    // Green
-                {0, 0, 255},    // Blue
-                {0, 255, 255},  // Cyan
-                {255, 0, 255},  // Magenta
-                {255, 255, 0},  // Yellow
-                {255, 255, 255},// White
-                {0, 0, 0}       // Black
-            };
-            
-            // Move bars from left to right (slower for smoother appearance)
-            static int frame_counter = 0;
-            frame_counter++;
-            if (frame_counter % 4 == 0) { // Update bar position every 4 frames (slower)
-                test_bar_offset = (test_bar_offset + 1) % (bar_width * num_bars);
-            }
-            
-            for (int x = 0; x < MATRIX_WIDTH; x++) {
-                int bar_index = ((x + test_bar_offset) / bar_width) % num_bars;
-                for (int y = 0; y < MATRIX_HEIGHT; y++) {
-                    g_matrix->SetPixel(x, y, colors[bar_index][0], colors[bar_index][1], colors[bar_index][2]);
-                }
-            }
-            
             // Update segments when cycle state changes
             if (cycle_state != last_cycle_state) {
                 sm.clearAll();
                 
                 if (cycle_state == 0) {
                     // Hostname in upper half
-                    sm.configure(0, 0, 0, MATRIX_WIDTH, MATRIX_HEIGHT / 2);
+                    sm.configure(0, 0, 0, g_display->width(), g_display->height() / 2);
                     sm.activate(0, true);
                     sm.setFrame(0, false, "FFFFFF", 1); // Disable frame
                     sm.updateText(0, hostname, "000000", "010101", "C", "none");
                 } else if (cycle_state == 2) {
                     // IP in lower half
-                    sm.configure(0, 0, MATRIX_HEIGHT / 2, MATRIX_WIDTH, MATRIX_HEIGHT / 2);
+                    sm.configure(0, 0, g_display->height() / 2, g_display->width(), g_display->height() / 2);
                     sm.activate(0, true);
                     sm.setFrame(0, false, "FFFFFF", 1); // Disable frame
                     sm.updateText(0, test_device_ip, "000000", "010101", "C", "none");
@@ -478,15 +479,25 @@ int main(int argc, char* argv[]) {
                 last_cycle_state = cycle_state;
             }
             
-            // Mark dirty every frame so text renders on top of bars
-            sm.markAllDirty();
-            
-            // Render text on top of bars
+            // Pattern + text in one frame
             renderer.renderAll();
             
             std::this_thread::sleep_for(std::chrono::milliseconds(33)); // 30fps
+            next_frame = std::chrono::steady_clock::now();  // Not an overrun
             continue; // Skip normal rendering
         }
+        test_mode_was_active = false;
+        
+        // Keep the splash address current (e.g. DHCP lease arriving late)
+        if (ip_splash_active && net_monitor.generation() != net_generation) {
+            net_generation = net_monitor.generation();
+            std::string ip = net_monitor.status().ip;
+            if (!ip.empty() && ip != device_ip) {
+                device_ip = ip;
+                sm.updateText(0, device_ip, "FFFFFF", "000000", "C", "none");
+                std::cout << "[SPLASH] Address changed: " << device_ip << std::endl;
+            }
+        }
         
         // Dismiss IP splash on first command
         if (ip_splash_active && g_udp_handler->hasReceivedCommand()) {
@@ -497,50 +508,127 @@ int main(int argc, char* argv[]) {
             sm.setFrame(0, false, "FFFFFF", 1);  // Disable splash frame
             std::cout << "[SPLASH] setFrame(0, false) called" << std::endl;
             
+            // The splash sat in this node's viewport; fullscreen on a wall is the whole wall
+            if (wall.enabled && g_udp_handler->getCurrentLayout() == 1) {
+                sm.configure(0, 0, 0, wall.width, wall.height);
+            }
+            
             // Force full canvas clear to remove frame pixels
-            g_matrix->Clear();
+            renderer.clearDisplay();
             std::cout << "[SPLASH] Canvas cleared" << std::endl;
             
             sm.markAllDirty();  // Force re-render
             std::cout << "[SPLASH] First command received — IP splash dismissed" << std::endl;
         }
         
-        // Update effects at fixed interval
-        bool effects_updated = false;
-        auto effect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_effect);
-        if (effect_elapsed.count() >= EFFECT_INTERVAL) {
-            sm.updateEffects();
-            effects_updated = true;
-            last_effect = now;
+        // Staged content goes live at its presentation time, not on the next tick
+        if (sm.applyPendingCommit()) {
+            try {
+                renderer.renderAll();
+            } catch (const std::exception& e) {
+                std::cerr << "[RENDER] Exception: " << e.what() << std::endl;
+            }
+        }
+        
+        // Update effects and render when the frame deadline is reached
+        now = std::chrono::steady_clock::now();
+        if (wall_beacon) {
+            next_frame = now;  // The beacon is the deadline
+        }
+        if (now >= next_frame) {
+            metrics().frame_lateness.observe(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - next_frame).count());
+            
+            // Effects are evaluated at the deadline, not at the (late) wake-up
+            uint64_t present_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_frame.time_since_epoch()).count();
+            if (wall.enabled) {
+                if (wall_beacon) {
+                    // wall_frame came with the beacon
+                } else if (wall.master || wall_sync.lastFrame() == 0) {
+                    wall_frame = (uint64_t)((next_frame - wall_epoch) / frame_period);
+                } else {
+                    // Master silent: count on from the last frame it sent
+                    wall_frame = wall_sync.lastFrame() + (uint64_t)((next_frame - wall_sync.lastBeacon()) / frame_period);
+                }
+                if (wall.master) {
+                    g_udp_handler->sendWallFrame(wall_frame);
+                }
+                present_ms = wall_frame * EFFECT_INTERVAL;
+            }
+            sm.updateEffects(present_ms);
             
             // Render on effect timer (like Python version)
-            // This gives consistent 10fps rendering regardless of command flood
+            // This gives consistent 20fps rendering regardless of command flood
             try {
                 renderer.renderAll();
-                last_render = now;
             } catch (const std::exception& e) {
                 std::cerr << "[RENDER] Exception: " << e.what() << std::endl;
             }
+            
+            // Deadlines already passed are skipped, not caught up in a burst
+            next_frame += frame_period;
+            
+            // On a shared clock the deadlines sit on its frame grid, so every
+            // panel following it renders the same instants
+            if (!wall.enabled && (sync_clock.isSynced() || sync_clock.isMaster())) {
+                uint64_t deadline_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_frame.time_since_epoch()).count();
+                int64_t phase = (int64_t)(sync_clock.fromLocal(deadline_ms) % EFFECT_INTERVAL);
+                next_frame -= std::chrono::milliseconds(phase <= EFFECT_INTERVAL / 2 ? phase : phase - EFFECT_INTERVAL);
+            }
+            now = std::chrono::steady_clock::now();
+            if (wall_beacon) {
+                // Next frame on the next beacon, or on our own once the master is gone
+                wall_beacon = false;
+                next_frame = now + std::chrono::milliseconds(WALL_BEACON_TIMEOUT_MS);
+            } else if (now >= next_frame) {
+                auto missed = (now - next_frame) / frame_period + 1;
+                next_frame += missed * frame_period;
+                metrics().frame_overruns.inc((uint64_t)missed);
+            }
         }
         
-        // Sleep to yield CPU and allow matrix clean refresh cycles
-        // Match Python: sleep for full EFFECT_INTERVAL
-        std::this_thread::sleep_for(std::chrono::milliseconds(EFFECT_INTERVAL));
+        // Sleep to yield CPU and allow matrix clean refresh cycles,
+        // until the next frame unless a commit falls due sooner
+        auto wake = next_frame;
+        int64_t commit_in = sm.msUntilCommit();
+        if (commit_in >= 0 && now + std::chrono::milliseconds(commit_in) < wake) {
+            wake = now + std::chrono::milliseconds(commit_in);
+        }
+        if (wall.enabled && !wall.master) {
+            wall_beacon = wall_sync.waitBeacon(wake, wall_frame);
+        } else {
+            std::this_thread::sleep_until(wake);
+        }
     }
     
     // ── Cleanup ──────────────────────────────────────────────────────────────
     std::cout << "\nShutting down..." << std::endl;
     
+    net_monitor.stop();
+    if (network_pid > 0) {
+        kill(network_pid, SIGTERM);  // No-op if it already finished
+        waitpid(network_pid, nullptr, 0);
+    }
+    font_thread.join();
+    
     if (g_udp_handler) {
         g_udp_handler->stop();
+        
+        // Brought back up by the next start, in place of the splash
+        if (restart_requested && !headless) {
+            sm.saveContent(SEGMENT_FILE, g_udp_handler->getCurrentLayout());
+        }
         delete g_udp_handler;
         g_udp_handler = nullptr;
     }
+    capture.close();
     
-    if (g_matrix) {
-        g_matrix->Clear();
-        delete g_matrix;
-        g_matrix = nullptr;
+    if (g_display) {
+        g_display->clear();
+        delete g_display;
+        g_display = nullptr;
     }
     
     std::cout << "Clean exit." << std::endl;
@@ -0,0 +1,109 @@
+// matrix_backend.cpp - rpi-rgb-led-matrix display backend
+
+#include "matrix_backend.h"
+#include "led-matrix.h"
+#include "kernels.h"
+#include "trace.h"
+#include <iostream>
+
+using namespace rgb_matrix;
+
+template <int W, int H>
+static void blitCanvas(const Framebuffer& frame, FrameCanvas* canvas) {
+    blitPixels<W, H>(frame, canvas);
+}
+
+MatrixBackend::MatrixBackend(RGBMatrix* matrix)
+    : matrix_(matrix), canvas_(matrix->CreateFrameCanvas()), blit_(&blitCanvas<0, 0>) {
+    int width = canvas_->width();
+    int height = canvas_->height();
+#define MATRIX_BLIT(w, h) if (width == w && height == h) blit_ = &blitCanvas<w, h>;
+    KERNEL_GEOMETRIES(MATRIX_BLIT)
+#undef MATRIX_BLIT
+}
+
+MatrixBackend::~MatrixBackend() {
+    matrix_->Clear();
+    delete matrix_;
+}
+
+int MatrixBackend::width() const {
+    return canvas_->width();
+}
+
+int MatrixBackend::height() const {
+    return canvas_->height();
+}
+
+void MatrixBackend::blit(const Framebuffer& frame) {
+    if (frame.width == canvas_->width() && frame.height == canvas_->height()) {
+        blit_(frame, canvas_);
+    } else {
+        blitCanvas<0, 0>(frame, canvas_);
+    }
+}
+
+void MatrixBackend::present(const Framebuffer&) {
+    TRACE_SPAN("SwapOnVSync");
+    canvas_ = matrix_->SwapOnVSync(canvas_);
+}
+
+void MatrixBackend::clear() {
+    matrix_->Clear();
+}
+
+MatrixBackend* createMatrixBackend(Rotation rotation, const PanelGeometry& panel) {
+    RGBMatrix::Options matrix_options;
+    RuntimeOptions runtime_opt;
+
+    matrix_options.rows = panel.height;
+    matrix_options.cols = panel.width;
+    matrix_options.chain_length = panel.chain;
+    matrix_options.parallel = panel.parallel;
+    matrix_options.hardware_mapping = HARDWARE_MAPPING;
+    matrix_options.brightness = BRIGHTNESS;
+    matrix_options.pwm_bits = PWM_BITS;
+    matrix_options.pwm_lsb_nanoseconds = PWM_LSB_NANOSECONDS;
+    matrix_options.scan_mode = SCAN_MODE;
+    matrix_options.row_address_type = ROW_ADDR_TYPE;
+    matrix_options.multiplexing = MULTIPLEXING;
+    matrix_options.pwm_dither_bits = PWM_DITHER_BITS;
+    matrix_options.led_rgb_sequence = LED_RGB_SEQUENCE;
+    matrix_options.limit_refresh_rate_hz = REFRESH_LIMIT;
+    matrix_options.disable_hardware_pulsing = true;  // Avoid audio conflict
+    matrix_options.show_refresh_rate = false;        // Disable refresh overlay
+    matrix_options.inverse_colors = false;           // Normal color display
+
+    // Set pixel mapper for rotation
+    const char* pixel_mapper = "";
+    switch (rotation) {
+        case ROTATION_0:
+            pixel_mapper = "";  // No rotation
+            break;
+        case ROTATION_90:
+            pixel_mapper = "Rotate:90";
+            break;
+        case ROTATION_180:
+            pixel_mapper = "Rotate:180";
+            break;
+        case ROTATION_270:
+            pixel_mapper = "Rotate:270";
+            break;
+    }
+    matrix_options.pixel_mapper_config = pixel_mapper;
+
+    runtime_opt.gpio_slowdown = GPIO_SLOWDOWN;
+    runtime_opt.drop_privileges = 1;  // Drop root after init
+    runtime_opt.daemon = 0;            // Run in foreground
+    runtime_opt.do_gpio_init = true;   // Initialize GPIO properly
+
+    RGBMatrix* matrix = RGBMatrix::CreateFromOptions(matrix_options, runtime_opt);
+    if (!matrix) {
+        std::cerr << "Failed to create RGB matrix" << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "✓ LED matrix initialized (" << matrix->width() << "×"
+             << matrix->height() << ")" << std::endl;
+    return new MatrixBackend(matrix);
+}
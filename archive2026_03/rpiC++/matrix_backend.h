@@ -0,0 +1,42 @@
+// matrix_backend.h - rpi-rgb-led-matrix display backend
+//
+// Not built by `make headless`, so nothing outside matrix_backend.cpp
+// includes the rgbmatrix headers.
+
+#ifndef MATRIX_BACKEND_H
+#define MATRIX_BACKEND_H
+
+#include "display_backend.h"
+#include "config.h"
+
+namespace rgb_matrix {
+class RGBMatrix;
+class FrameCanvas;
+}
+
+class MatrixBackend : public DisplayBackend {
+public:
+    // Takes ownership of the matrix
+    explicit MatrixBackend(rgb_matrix::RGBMatrix* matrix);
+    ~MatrixBackend();
+
+    const char* name() const override { return "rgbmatrix"; }
+    int width() const override;
+    int height() const override;
+
+    void blit(const Framebuffer& frame) override;
+    void present(const Framebuffer& frame) override;
+    void clear() override;
+
+private:
+    rgb_matrix::RGBMatrix* matrix_;
+    rgb_matrix::FrameCanvas* canvas_;
+    void (*blit_)(const Framebuffer& frame, rgb_matrix::FrameCanvas* canvas);  // Specialized on the panel size
+};
+
+// Initialise the panels (geometry from config.json, timing from config.h)
+// with the given rotation; drops root privileges. Returns nullptr if the
+// matrix could not be created.
+MatrixBackend* createMatrixBackend(Rotation rotation, const PanelGeometry& panel);
+
+#endif // MATRIX_BACKEND_H
@@ -0,0 +1,154 @@
+// metrics.cpp - Sharded counters/histograms and Prometheus text output
+
+#include "metrics.h"
+#include <cstdio>
+
+static const char* COMMAND_NAMES[CMD_TYPE_COUNT] = {
+    "text", "layout", "clear", "clear_all", "brightness", "orientation",
+    "rotation", "group", "config", "frame", "clock", "commit", "discard",
+    "wall_frame", "stream", "invalid", "other"
+};
+
+CommandType commandType(const std::string& cmd) {
+    for (int i = 0; i < CMD_STREAM; i++) {
+        if (cmd == COMMAND_NAMES[i]) return (CommandType)i;
+    }
+    return CMD_OTHER;
+}
+
+const char* commandTypeName(CommandType type) {
+    return COMMAND_NAMES[type];
+}
+
+// Threads are dealt shards round-robin the first time they touch a metric
+static unsigned threadShard() {
+    static std::atomic<unsigned> next_shard{0};
+    thread_local unsigned shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS;
+    return shard;
+}
+
+// ─── Counter ─────────────────────────────────────────────────────────────────
+
+void Counter::inc(uint64_t n) {
+    shards_[threadShard()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const Shard& s : shards_) {
+        total += s.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// ─── Histogram ───────────────────────────────────────────────────────────────
+
+const uint64_t Histogram::BOUNDS_US[Histogram::BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+
+void Histogram::observe(uint64_t us) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && us > BOUNDS_US[bucket]) {
+        bucket++;
+    }
+    Shard& s = shards_[threadShard()];
+    s.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.sum_us.fetch_add(us, std::memory_order_relaxed);
+}
+
+void Histogram::write(std::string& out, const char* name, const char* help) const {
+    uint64_t buckets[BUCKETS] = {};
+    uint64_t count = 0, sum_us = 0;
+    for (const Shard& s : shards_) {
+        for (int i = 0; i < BUCKETS; i++) {
+            buckets[i] += s.buckets[i].load(std::memory_order_relaxed);
+        }
+        count += s.count.load(std::memory_order_relaxed);
+        sum_us += s.sum_us.load(std::memory_order_relaxed);
+    }
+
+    char line[160];
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " histogram\n";
+    uint64_t cumulative = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        cumulative += buckets[i];
+        if (i < BUCKETS - 1) {
+            snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %llu\n",
+                     name, BOUNDS_US[i] / 1e6, (unsigned long long)cumulative);
+        } else {
+            snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %llu\n",
+                     name, (unsigned long long)cumulative);
+        }
+        out += line;
+    }
+    snprintf(line, sizeof(line), "%s_sum %.6f\n%s_count %llu\n",
+             name, sum_us / 1e6, name, (unsigned long long)count);
+    out += line;
+}
+
+// ─── Exposition ──────────────────────────────────────────────────────────────
+
+static void writeCounter(std::string& out, const char* name, const char* help, const Counter& c) {
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " counter\n";
+    out += std::string(name) + " " + std::to_string(c.value()) + "\n";
+}
+
+static void writeCommandCounters(std::string& out, const char* name, const char* help,
+                                 const Counter (&counters)[CMD_TYPE_COUNT]) {
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " counter\n";
+    for (int i = 0; i < CMD_TYPE_COUNT; i++) {
+        out += std::string(name) + "{cmd=\"" + COMMAND_NAMES[i] + "\"} " +
+               std::to_string(counters[i].value()) + "\n";
+    }
+}
+
+static void writeGauge(std::string& out, const char* name, const char* help, double value) {
+    char line[96];
+    snprintf(line, sizeof(line), "%.6f", value);
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " gauge\n";
+    out += std::string(name) + " " + line + "\n";
+}
+
+std::string Metrics::render() const {
+    std::string out;
+    out.reserve(8192);
+    render_frame.write(out, "led_render_frame_seconds", "Time to compose and present one frame");
+    render_segment.write(out, "led_render_segment_seconds", "Time to draw one segment");
+    render_band.write(out, "led_render_band_seconds", "Time to compose all segments over one tile band");
+    frame_lateness.write(out, "led_frame_lateness_seconds", "Render loop wake-up time past the frame deadline");
+    writeCounter(out, "led_frames_rendered_total", "Frames presented", frames_rendered);
+    writeCounter(out, "led_frames_skipped_total", "Render passes skipped because nothing changed", frames_skipped);
+    writeCounter(out, "led_frame_overruns_total", "Frame deadlines missed because the previous frame ran long", frame_overruns);
+    writeCommandCounters(out, "led_packets_received_total", "UDP packets received", packets_received);
+    writeCommandCounters(out, "led_packets_dropped_total", "UDP packets ignored (test mode, other group, malformed)", packets_dropped);
+    writeCommandCounters(out, "led_packets_coalesced_total", "UDP packets absorbed without new render work", packets_coalesced);
+    segment_lock_wait.write(out, "led_segment_lock_wait_seconds", "Time spent waiting for the segment lock");
+    latency_receive_dispatch.write(out, "led_latency_receive_dispatch_seconds",
+                                   "Kernel receive of a command to its change applied to the segments");
+    latency_dispatch_render.write(out, "led_latency_dispatch_render_seconds",
+                                  "Change applied to the start of the first frame showing it");
+    latency_render_swap.write(out, "led_latency_render_swap_seconds",
+                              "Start of that frame to its swap on the display");
+    latency_packet_photon.write(out, "led_latency_packet_photon_seconds",
+                                "Kernel receive of a command to the swap of the first frame showing it");
+    writeCounter(out, "led_font_cache_hits_total", "Font face cache hits", font_cache_hits);
+    writeCounter(out, "led_font_cache_misses_total", "Font face cache misses", font_cache_misses);
+    writeCounter(out, "led_measure_cache_hits_total", "Text measurement cache hits", measure_cache_hits);
+    writeCounter(out, "led_measure_cache_misses_total", "Text measurement cache misses", measure_cache_misses);
+    writeCounter(out, "led_glyph_cache_hits_total", "Rendered glyph cache hits", glyph_cache_hits);
+    writeCounter(out, "led_glyph_cache_misses_total", "Rendered glyph cache misses (FreeType render)", glyph_cache_misses);
+    writeGauge(out, "led_startup_first_pixel_seconds", "Time from process start to the first presented frame",
+               first_pixel_us.load(std::memory_order_relaxed) / 1e6);
+    return out;
+}
+
+Metrics& metrics() {
+    static Metrics instance;
+    return instance;
+}
@@ -0,0 +1,124 @@
+// metrics.h - Runtime counters and histograms exposed at /api/metrics
+//
+// Every counter is split into cache-line sized shards and each thread adds
+// to its own shard with a relaxed atomic, so the render, UDP and web
+// threads never contend on a metric. Shards are only summed when
+// /api/metrics is scraped. Output is the Prometheus text format.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#define METRICS_SHARDS 8
+
+// Command types used as the "cmd" label on packet counters
+enum CommandType {
+    CMD_TEXT = 0,
+    CMD_LAYOUT,
+    CMD_CLEAR,
+    CMD_CLEAR_ALL,
+    CMD_BRIGHTNESS,
+    CMD_ORIENTATION,
+    CMD_ROTATION,
+    CMD_GROUP,
+    CMD_CONFIG,
+    CMD_FRAME,
+    CMD_CLOCK,
+    CMD_COMMIT,
+    CMD_DISCARD,
+    CMD_WALL_FRAME,
+    CMD_STREAM,   // Binary pixel stream packet
+    CMD_INVALID,  // Not valid JSON
+    CMD_OTHER,    // Unknown "cmd"
+    CMD_TYPE_COUNT
+};
+
+CommandType commandType(const std::string& cmd);
+const char* commandTypeName(CommandType type);
+
+class Counter {
+public:
+    void inc(uint64_t n = 1);
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard shards_[METRICS_SHARDS];
+};
+
+// Durations in microseconds, fixed buckets from 50us to 100ms
+class Histogram {
+public:
+    static const int BUCKETS = 12;  // Last bucket is +Inf
+    static const uint64_t BOUNDS_US[BUCKETS - 1];
+
+    void observe(uint64_t us);
+
+    // Appends the _bucket/_sum/_count series (in seconds)
+    void write(std::string& out, const char* name, const char* help) const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[BUCKETS] = {};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum_us{0};
+    };
+    Shard shards_[METRICS_SHARDS];
+};
+
+struct Metrics {
+    Histogram render_frame;
+    Histogram render_segment;   // Untiled canvases only
+    Histogram render_band;      // Tiled canvases: one band, all segments
+    Counter frames_rendered;
+    Counter frames_skipped;   // Render pass with nothing dirty
+    Counter frame_overruns;   // Frame deadlines missed by the render loop
+    Histogram frame_lateness; // Wake-up time past the frame deadline
+
+    Counter packets_received[CMD_TYPE_COUNT];
+    Counter packets_dropped[CMD_TYPE_COUNT];    // Test mode, other group, malformed
+    Counter packets_coalesced[CMD_TYPE_COUNT];  // Absorbed without new render work
+
+    Histogram segment_lock_wait;
+
+    // Packet-to-photon, from the kernel receive timestamp of a command to
+    // the swap of the first frame showing its change, and its stages
+    Histogram latency_receive_dispatch;  // Receive → change applied
+    Histogram latency_dispatch_render;   // Change applied → frame composition starts
+    Histogram latency_render_swap;       // Composition starts → swap on the display
+    Histogram latency_packet_photon;     // Receive → swap
+
+    Counter font_cache_hits;
+    Counter font_cache_misses;
+    Counter measure_cache_hits;
+    Counter measure_cache_misses;
+    Counter glyph_cache_hits;
+    Counter glyph_cache_misses;
+
+    std::atomic<uint64_t> first_pixel_us{0};  // Process start to first presented frame
+
+    std::string render() const;
+};
+
+Metrics& metrics();
+
+// Microseconds elapsed since construction
+class ScopedTimer {
+public:
+    ScopedTimer() : start_(std::chrono::steady_clock::now()) {}
+    uint64_t elapsedUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // METRICS_H
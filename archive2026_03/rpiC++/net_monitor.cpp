@@ -0,0 +1,153 @@
+// net_monitor.cpp - rtnetlink / uname based hostname and address monitor
+
+#include "net_monitor.h"
+#include "thread_policy.h"
+#include <iostream>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/utsname.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+std::string getIP(const std::string& iface) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return "";
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+
+    if (ioctl(fd, SIOCGIFADDR, &ifr) < 0) {
+        close(fd);
+        return "";
+    }
+
+    close(fd);
+    struct sockaddr_in* addr = (struct sockaddr_in*)&ifr.ifr_addr;
+    return inet_ntoa(addr->sin_addr);
+}
+
+NetMonitor::NetMonitor(const std::string& iface)
+    : iface_(iface), netlink_fd_(-1), running_(false), generation_(0) {
+}
+
+NetMonitor::~NetMonitor() {
+    stop();
+}
+
+void NetMonitor::start() {
+    if (running_) return;
+
+    refresh();
+
+    netlink_fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlink_fd_ >= 0) {
+        struct sockaddr_nl addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_LINK;
+        if (bind(netlink_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(netlink_fd_);
+            netlink_fd_ = -1;
+        }
+    }
+    if (netlink_fd_ < 0) {
+        std::cerr << "[NET] rtnetlink unavailable - polling address once a second" << std::endl;
+    } else {
+        // Wake up once a second for the hostname check and for stop()
+        struct timeval tv = {1, 0};
+        setsockopt(netlink_fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    running_ = true;
+    thread_ = std::thread(&NetMonitor::run, this);
+}
+
+void NetMonitor::stop() {
+    if (!running_) return;
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (netlink_fd_ >= 0) {
+        close(netlink_fd_);
+        netlink_fd_ = -1;
+    }
+}
+
+NetMonitor::Status NetMonitor::status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+void NetMonitor::run() {
+    applyThreadPolicy("net", "led-net");
+    char buffer[8192];
+
+    while (running_) {
+        if (netlink_fd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            refresh();
+            continue;
+        }
+
+        ssize_t len = recv(netlink_fd_, buffer, sizeof(buffer), 0);
+        if (len < 0 && errno == ENOBUFS) {
+            refresh();  // Events were lost - just re-read everything
+            continue;
+        }
+
+        // Timeouts and events for other interfaces still re-check the hostname,
+        // which has no change notification of its own
+        unsigned int if_index = if_nametoindex(iface_.c_str());
+        if (len > 0 && addressEventForUs(buffer, len, if_index)) {
+            refresh();
+        } else {
+            struct utsname uts;
+            if (uname(&uts) == 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (status_.hostname != uts.nodename) {
+                    status_.hostname = uts.nodename;
+                    generation_.fetch_add(1, std::memory_order_release);
+                }
+            }
+        }
+    }
+}
+
+bool NetMonitor::addressEventForUs(const char* buffer, ssize_t len, unsigned int if_index) {
+    int remaining = (int)len;
+    for (const struct nlmsghdr* nh = (const struct nlmsghdr*)buffer;
+         NLMSG_OK(nh, remaining); nh = NLMSG_NEXT(nh, remaining)) {
+        if (nh->nlmsg_type == RTM_NEWADDR || nh->nlmsg_type == RTM_DELADDR) {
+            const struct ifaddrmsg* ifa = (const struct ifaddrmsg*)NLMSG_DATA(nh);
+            if (ifa->ifa_index == if_index) return true;
+        } else if (nh->nlmsg_type == RTM_NEWLINK || nh->nlmsg_type == RTM_DELLINK) {
+            const struct ifinfomsg* ifi = (const struct ifinfomsg*)NLMSG_DATA(nh);
+            if ((unsigned int)ifi->ifi_index == if_index) return true;
+        }
+    }
+    return false;
+}
+
+void NetMonitor::refresh() {
+    struct utsname uts;
+    std::string hostname = (uname(&uts) == 0) ? uts.nodename : "";
+    std::string ip = getIP(iface_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (hostname == status_.hostname && ip == status_.ip) return;
+
+    if (ip != status_.ip) {
+        std::cout << "[NET] " << iface_ << " address: " << (ip.empty() ? "none" : ip) << std::endl;
+    }
+    status_.hostname = hostname;
+    status_.ip = ip;
+    generation_.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,52 @@
+// net_monitor.h - Hostname and interface address tracking off the render thread
+//
+// A background thread listens for rtnetlink address events, so a new DHCP
+// lease is seen the moment the kernel applies it, and re-reads the
+// hostname with uname(). The render loop only compares a generation
+// number each frame and copies the strings when they changed.
+
+#ifndef NET_MONITOR_H
+#define NET_MONITOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// IPv4 address of `iface` (empty if it has none)
+std::string getIP(const std::string& iface);
+
+class NetMonitor {
+public:
+    struct Status {
+        std::string hostname;
+        std::string ip;  // Empty while the interface has no address
+    };
+
+    explicit NetMonitor(const std::string& iface);
+    ~NetMonitor();
+
+    void start();
+    void stop();
+
+    // Bumped every time hostname or address changes
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+    Status status();
+
+private:
+    std::string iface_;
+    int netlink_fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    Status status_;
+    std::atomic<uint64_t> generation_;
+
+    void run();
+    void refresh();
+    bool addressEventForUs(const char* buffer, ssize_t len, unsigned int if_index);
+};
+
+#endif // NET_MONITOR_H
@@ -0,0 +1,151 @@
+// pixel_stream.cpp - Binary pixel frame input implementation
+
+#include "pixel_stream.h"
+#include "frame_codec.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static inline uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+PixelStream::PixelStream()
+    : seq_(0), has_frame_(false), active_(false), dirty_(false), last_packet_ms_(0) {
+}
+
+uint64_t PixelStream::millis() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+bool PixelStream::isStreamPacket(const char* data, size_t len) {
+    return len >= 4 && data[0] == 'L' && data[1] == 'M' && (uint8_t)data[2] == STREAM_VERSION;
+}
+
+void PixelStream::handlePacket(const uint8_t* data, size_t len, std::vector<uint8_t>& reply) {
+    StreamStatus status = STREAM_MALFORMED;
+    uint32_t current_seq;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint8_t type = data[3];
+
+        if (type == STREAM_STOP) {
+            if (active_) {
+                std::cout << "[STREAM] Stopped by sender" << std::endl;
+            }
+            active_ = false;
+            status = STREAM_OK;
+        } else if (len >= STREAM_HEADER_SIZE) {
+            status = apply(type, readU32(data + 4), readU32(data + 8),
+                           readU16(data + 12), readU16(data + 14),
+                           data + STREAM_HEADER_SIZE, len - STREAM_HEADER_SIZE);
+        }
+        current_seq = has_frame_ ? seq_ : 0;
+    }
+
+    reply.resize(9);
+    reply[0] = 'L';
+    reply[1] = 'M';
+    reply[2] = STREAM_VERSION;
+    reply[3] = STREAM_ACK;
+    for (int i = 0; i < 4; i++) reply[4 + i] = (uint8_t)(current_seq >> (8 * i));
+    reply[8] = (uint8_t)status;
+}
+
+StreamStatus PixelStream::apply(uint8_t type, uint32_t seq, uint32_t base, int width, int height,
+                                const uint8_t* body, size_t body_len) {
+    if (width <= 0 || height <= 0 || width > 1024 || height > 1024) {
+        return STREAM_MALFORMED;
+    }
+
+    if (type == STREAM_KEY) {
+        if (width != frame_.width || height != frame_.height) {
+            frame_.resize(width, height);
+            std::cout << "[STREAM] Frame size " << width << "×" << height << std::endl;
+        }
+        if (!rleDecode(body, body_len, frame_.pixels.data(), width, height,
+                       (size_t)width * 3, RLE_COPY)) {
+            has_frame_ = false;
+            return STREAM_MALFORMED;
+        }
+    } else if (type == STREAM_XOR || type == STREAM_RECT) {
+        // Retransmitted delta for a frame we already hold - reapplying an XOR would corrupt it
+        if (has_frame_ && seq == seq_) {
+            last_packet_ms_ = millis();
+            return STREAM_OK;
+        }
+        if (!has_frame_ || base != seq_ || width != frame_.width || height != frame_.height) {
+            return STREAM_NEED_KEYFRAME;
+        }
+
+        bool ok;
+        if (type == STREAM_XOR) {
+            ok = rleDecode(body, body_len, frame_.pixels.data(), width, height,
+                           (size_t)width * 3, RLE_XOR);
+        } else {
+            if (body_len < STREAM_RECT_SIZE) return STREAM_MALFORMED;
+            int rx = readU16(body), ry = readU16(body + 2);
+            int rw = readU16(body + 4), rh = readU16(body + 6);
+            if (rx + rw > width || ry + rh > height) return STREAM_MALFORMED;
+            ok = rleDecode(body + STREAM_RECT_SIZE, body_len - STREAM_RECT_SIZE,
+                           frame_.row(ry) + rx * 3, rw, rh, (size_t)width * 3, RLE_COPY);
+        }
+        if (!ok) {
+            // Frame is partially written and no longer matches the sender's reference
+            has_frame_ = false;
+            return STREAM_MALFORMED;
+        }
+    } else {
+        return STREAM_MALFORMED;
+    }
+
+    if (!active_) {
+        std::cout << "[STREAM] Pixel stream active (" << width << "×" << height << ")" << std::endl;
+    }
+    seq_ = seq;
+    has_frame_ = true;
+    active_ = true;
+    dirty_ = true;
+    last_packet_ms_ = millis();
+    return STREAM_OK;
+}
+
+bool PixelStream::isActive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || !has_frame_) return false;
+    if (millis() - last_packet_ms_ >= STREAM_TIMEOUT_MS) {
+        std::cout << "[STREAM] No frames for " << STREAM_TIMEOUT_MS << "ms - returning to segments" << std::endl;
+        active_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool PixelStream::consumeDirty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool was_dirty = dirty_;
+    dirty_ = false;
+    return was_dirty;
+}
+
+bool PixelStream::copyViewport(Framebuffer& out, int x, int y) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_frame_) return false;
+    int w = std::min(frame_.width - x, out.width);
+    int h = std::min(frame_.height - y, out.height);
+    if (w != out.width || h != out.height) {
+        out.fill(0, 0, 0);
+    }
+    for (int row = 0; row < h && w > 0; row++) {
+        memcpy(out.row(row), frame_.row(y + row) + (size_t)x * 3, (size_t)w * 3);
+    }
+    return true;
+}
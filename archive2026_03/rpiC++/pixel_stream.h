@@ -0,0 +1,78 @@
+// pixel_stream.h - Binary pixel frame input with delta and RLE compression
+//
+// Datagrams that start with the "LM" magic carry pixel frames instead of JSON
+// commands. Header (little-endian):
+//   0  'L' 'M'       magic
+//   2  u8  version   STREAM_VERSION
+//   3  u8  type      StreamPacketType
+//   4  u32 seq       sequence number of the frame this packet produces
+//   8  u32 base      frame the delta applies to (XOR / RECT only)
+//   12 u16 width     full frame size
+//   14 u16 height
+//   16 u16 x, y, w, h  (RECT only) dirty rectangle
+// The payload is RLE-coded (see frame_codec.h). Every packet is answered with
+// an ACK carrying the receiver's current seq; a non-zero status asks the
+// sender for a keyframe. Senders base deltas on the last acknowledged frame.
+
+#ifndef PIXEL_STREAM_H
+#define PIXEL_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "framebuffer.h"
+
+#define STREAM_VERSION     1
+#define STREAM_HEADER_SIZE 16
+#define STREAM_RECT_SIZE   8
+
+enum StreamPacketType {
+    STREAM_KEY  = 0,     // Full frame, RLE
+    STREAM_XOR  = 1,     // XOR against frame `base`, RLE
+    STREAM_RECT = 2,     // Replace a dirty rectangle of frame `base`, RLE
+    STREAM_STOP = 3,     // Hand the display back to segments
+    STREAM_ACK  = 0x80   // Reply: u32 seq, u8 status
+};
+
+enum StreamStatus {
+    STREAM_OK = 0,
+    STREAM_NEED_KEYFRAME = 1,
+    STREAM_MALFORMED = 2
+};
+
+class PixelStream {
+public:
+    PixelStream();
+
+    static bool isStreamPacket(const char* data, size_t len);
+
+    // Apply one datagram and fill `reply` with the ACK for the sender
+    void handlePacket(const uint8_t* data, size_t len, std::vector<uint8_t>& reply);
+
+    // True while frames keep arriving (and no STOP was received)
+    bool isActive();
+
+    // Returns true once per applied frame
+    bool consumeDirty();
+
+    // Copy the part of the current frame at (x, y) that `out` covers straight
+    // into it, a row at a time; what the frame doesn't reach is black.
+    // Returns false (leaving `out` alone) until a frame has arrived.
+    bool copyViewport(Framebuffer& out, int x, int y);
+
+private:
+    std::mutex mutex_;
+    Framebuffer frame_;
+    uint32_t seq_;
+    bool has_frame_;
+    bool active_;
+    bool dirty_;
+    uint64_t last_packet_ms_;
+
+    StreamStatus apply(uint8_t type, uint32_t seq, uint32_t base, int width, int height,
+                       const uint8_t* body, size_t body_len);
+    uint64_t millis();
+};
+
+#endif // PIXEL_STREAM_H
@@ -0,0 +1,347 @@
+// replay.cpp - Feed a datagram capture back into the command path
+//
+//   led-matrix-replay CAPTURE [--speed N|max] [--udp HOST[:PORT]] [--json FILE]
+//
+// By default the capture is dispatched in-process, into a headless daemon
+// (UDPHandler::handleDatagram, with a render loop at EFFECT_INTERVAL). The
+// report gives throughput, dispatch latency percentiles per command type
+// and rendered / skipped / coalesced counts. With --udp the datagrams are
+// sent to a running daemon instead; frame counts then come from its
+// /api/metrics. --speed 1 keeps the captured timing, N compresses it N
+// times, and max sends back to back.
+
+#include "udp_capture.h"
+#include "udp_handler.h"
+#include "segment_manager.h"
+#include "text_renderer.h"
+#include "headless_backend.h"
+#include "pixel_stream.h"
+#include "sync_clock.h"
+#include "metrics.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+UDPHandler* g_udp_handler = nullptr;  // text_renderer.cpp reads orientation / layout through it
+
+namespace {
+
+struct Latencies {
+    std::vector<uint64_t> ns;
+
+    uint64_t percentile(double p) {
+        if (ns.empty()) return 0;
+        size_t i = std::min(ns.size() - 1, (size_t)(p * ns.size()));
+        std::nth_element(ns.begin(), ns.begin() + i, ns.end());
+        return ns[i];
+    }
+};
+
+struct Totals {
+    uint64_t frames_rendered;
+    uint64_t frames_skipped;
+    uint64_t coalesced;
+    uint64_t dropped;
+};
+
+Totals localTotals() {
+    Totals t = {metrics().frames_rendered.value(), metrics().frames_skipped.value(), 0, 0};
+    for (int i = 0; i < CMD_TYPE_COUNT; i++) {
+        t.coalesced += metrics().packets_coalesced[i].value();
+        t.dropped += metrics().packets_dropped[i].value();
+    }
+    return t;
+}
+
+CommandType classify(const std::vector<char>& data) {
+    if (PixelStream::isStreamPacket(data.data(), data.size())) return CMD_STREAM;
+    try {
+        json doc = json::parse(data.begin(), data.end());
+        return commandType(doc.value("cmd", ""));
+    } catch (const json::exception&) {
+        return CMD_INVALID;
+    }
+}
+
+// ─── Remote Metrics ──────────────────────────────────────────────────────────
+
+// Sum of every sample of `name` in the daemon's /api/metrics (-1 if unreachable)
+double remoteMetric(const std::string& host, const std::string& name) {
+    struct addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(WEB_PORT).c_str(), &hints, &res) != 0) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    bool ok = fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+    freeaddrinfo(res);
+    if (!ok) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    std::string request = "GET /api/metrics HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        response.append(buf, n);
+    }
+    close(fd);
+
+    double sum = 0;
+    size_t pos = 0;
+    while ((pos = response.find("\n" + name, pos)) != std::string::npos) {
+        size_t line_end = response.find('\n', pos + 1);
+        std::string line = response.substr(pos + 1, line_end - pos - 1);
+        char next = line.size() > name.size() ? line[name.size()] : ' ';
+        if (next == ' ' || next == '{') {
+            sum += atof(line.substr(line.rfind(' ') + 1).c_str());
+        }
+        pos = line_end;
+    }
+    return sum;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string capture_path, udp_target, json_path;
+    double speed = 1.0;  // 0 = as fast as possible
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--speed" && i + 1 < argc) {
+            std::string value = argv[++i];
+            speed = (value == "max") ? 0 : atof(value.c_str());
+            if (value != "max" && speed <= 0) {
+                std::cerr << "--speed needs a positive factor or \"max\"" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--udp" && i + 1 < argc) {
+            udp_target = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (capture_path.empty() && arg[0] != '-') {
+            capture_path = arg;
+        } else {
+            capture_path.clear();
+            break;
+        }
+    }
+    if (capture_path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " CAPTURE [--speed N|max] [--udp HOST[:PORT]] [--json FILE]" << std::endl;
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(capture_path)) return 1;
+    std::vector<CaptureRecord> records;
+    CaptureRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        std::cerr << capture_path << ": no datagrams" << std::endl;
+        return 1;
+    }
+    std::vector<CommandType> types;
+    for (const CaptureRecord& r : records) {
+        types.push_back(classify(r.data));
+    }
+
+    // ── Target ───────────────────────────────────────────────────────────────
+    int udp_fd = -1;
+    struct sockaddr_in dest = {};
+    std::string udp_host;
+    if (!udp_target.empty()) {
+        size_t colon = udp_target.find(':');
+        udp_host = udp_target.substr(0, colon);
+        int port = (colon == std::string::npos) ? UDP_PORT : atoi(udp_target.c_str() + colon + 1);
+        struct addrinfo hints = {}, *res = nullptr;
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        if (getaddrinfo(udp_host.c_str(), nullptr, &hints, &res) != 0) {
+            std::cerr << "Cannot resolve " << udp_host << std::endl;
+            return 1;
+        }
+        dest = *(struct sockaddr_in*)res->ai_addr;
+        dest.sin_port = htons(port);
+        freeaddrinfo(res);
+        udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    }
+
+    // In-process: a headless daemon without sockets. Its logging is muted so
+    // it doesn't dominate the timing.
+    std::ostream out(std::cout.rdbuf());
+    SegmentManager sm;
+    SyncClock sync_clock;
+    PixelStream pixel_stream;
+    HeadlessBackend* display = nullptr;
+    TextRenderer* renderer = nullptr;
+    UDPHandler* handler = nullptr;
+    std::atomic<bool> rendering(false);
+    std::thread render_thread;
+    std::streambuf* err_buf = std::cerr.rdbuf();
+
+    if (udp_fd < 0) {
+        std::cout.rdbuf(nullptr);
+        std::cerr.rdbuf(nullptr);
+        sm.setClock(&sync_clock);
+        handler = new UDPHandler(&sm);
+        handler->setPersistConfig(false);
+        handler->setPixelStream(&pixel_stream);
+        handler->setSyncClock(&sync_clock);
+        g_udp_handler = handler;
+        display = new HeadlessBackend(handler->getPanel().canvasWidth(), handler->getPanel().canvasHeight());
+        sm.resetLayout(display->width(), display->height());
+        renderer = new TextRenderer(display, &sm, &pixel_stream);
+        renderer->setRenderTiles(handler->getRenderTiles());
+
+        // Same pacing as the daemon's main loop
+        rendering = true;
+        render_thread = std::thread([&]() {
+            auto next_frame = Clock::now();
+            while (rendering) {
+                std::this_thread::sleep_until(next_frame);
+                sm.applyPendingCommit();
+                sm.updateEffects(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_frame.time_since_epoch()).count());
+                renderer->renderAll();
+                next_frame += std::chrono::milliseconds(EFFECT_INTERVAL);
+                if (Clock::now() > next_frame) next_frame = Clock::now();
+            }
+        });
+    }
+
+    double remote_frames = udp_fd >= 0 ? remoteMetric(udp_host, "led_frames_rendered_total") : -1;
+    Totals before = localTotals();
+
+    // ── Replay ───────────────────────────────────────────────────────────────
+    Latencies all, lateness;
+    std::vector<Latencies> by_type(CMD_TYPE_COUNT);
+    std::vector<uint8_t> reply;
+    uint64_t bytes = 0;
+    uint64_t first_t = records.front().t_ns;
+    auto start = Clock::now();
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const CaptureRecord& r = records[i];
+        if (speed > 0) {
+            auto due = start + std::chrono::nanoseconds((uint64_t)((r.t_ns - first_t) / speed));
+            std::this_thread::sleep_until(due);
+            lateness.ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count());
+        }
+
+        auto t0 = Clock::now();
+        if (udp_fd >= 0) {
+            sendto(udp_fd, r.data.data(), r.data.size(), 0, (struct sockaddr*)&dest, sizeof(dest));
+        } else {
+            handler->handleDatagram(r.data.data(), r.data.size(), reply);
+        }
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+        all.ns.push_back(ns);
+        by_type[types[i]].ns.push_back(ns);
+        bytes += r.data.size();
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Let the last commands reach the display before counting frames
+    std::this_thread::sleep_for(std::chrono::milliseconds(EFFECT_INTERVAL * 2));
+    Totals after = localTotals();
+    if (udp_fd >= 0) {
+        double now_frames = remoteMetric(udp_host, "led_frames_rendered_total");
+        remote_frames = (remote_frames >= 0 && now_frames >= 0) ? now_frames - remote_frames : -1;
+        close(udp_fd);
+    } else {
+        rendering = false;
+        render_thread.join();
+        delete renderer;
+        delete display;
+        g_udp_handler = nullptr;
+        delete handler;
+        std::cout.rdbuf(out.rdbuf());
+        std::cerr.rdbuf(err_buf);
+        std::cout.clear();
+        std::cerr.clear();
+    }
+
+    // ── Report ───────────────────────────────────────────────────────────────
+    double captured_s = (records.back().t_ns - first_t) / 1e9;
+    uint64_t frames = (udp_fd >= 0) ? (uint64_t)std::max(0.0, remote_frames)
+                                    : after.frames_rendered - before.frames_rendered;
+    const char* target = udp_target.empty() ? "dispatch" : udp_target.c_str();
+    const char* latency_name = udp_target.empty() ? "dispatch" : "send";
+
+    char line[200], pace[32];
+    snprintf(pace, sizeof(pace), speed > 0 ? "%gx" : "max speed", speed);
+    snprintf(line, sizeof(line), "%zu datagrams (%.1f s captured) → %s at %s\n",
+             records.size(), captured_s, target, pace);
+    out << line;
+    snprintf(line, sizeof(line), "Replayed in %.3f s: %.0f datagrams/s, %.2f MB/s\n",
+             elapsed_s, records.size() / elapsed_s, bytes / elapsed_s / 1e6);
+    out << line;
+    snprintf(line, sizeof(line), "%-12s %8s %10s %10s %10s %10s\n", latency_name, "count", "p50 us", "p90 us", "p99 us", "max us");
+    out << line;
+    auto row = [&](const char* name, Latencies& l) {
+        snprintf(line, sizeof(line), "%-12s %8zu %10.1f %10.1f %10.1f %10.1f\n", name, l.ns.size(),
+                 l.percentile(0.5) / 1e3, l.percentile(0.9) / 1e3, l.percentile(0.99) / 1e3, l.percentile(1.0) / 1e3);
+        out << line;
+    };
+    row("all", all);
+    for (int t = 0; t < CMD_TYPE_COUNT; t++) {
+        if (!by_type[t].ns.empty()) row(commandTypeName((CommandType)t), by_type[t]);
+    }
+    if (speed > 0) row("lateness", lateness);
+    if (udp_fd >= 0 && remote_frames < 0) {
+        out << "Frames rendered: unknown (no /api/metrics on " << udp_host << ")" << std::endl;
+    } else if (udp_fd >= 0) {
+        out << "Frames rendered: " << frames << std::endl;
+    } else {
+        out << "Frames rendered: " << frames << ", skipped: " << after.frames_skipped - before.frames_skipped
+            << ", packets coalesced: " << after.coalesced - before.coalesced
+            << ", dropped: " << after.dropped - before.dropped << std::endl;
+    }
+
+    if (!json_path.empty()) {
+        json doc;
+        doc["capture"] = capture_path;
+        doc["target"] = target;
+        doc["speed"] = speed;
+        doc["datagrams"] = records.size();
+        doc["captured_s"] = captured_s;
+        doc["elapsed_s"] = elapsed_s;
+        doc["datagrams_per_s"] = records.size() / elapsed_s;
+        doc["frames_rendered"] = frames;
+        if (udp_fd < 0) {
+            doc["frames_skipped"] = after.frames_skipped - before.frames_skipped;
+            doc["packets_coalesced"] = after.coalesced - before.coalesced;
+            doc["packets_dropped"] = after.dropped - before.dropped;
+        }
+        auto summary = [](Latencies& l) {
+            return json{{"count", l.ns.size()}, {"p50_us", l.percentile(0.5) / 1e3}, {"p90_us", l.percentile(0.9) / 1e3},
+                        {"p99_us", l.percentile(0.99) / 1e3}, {"max_us", l.percentile(1.0) / 1e3}};
+        };
+        doc["latency"]["all"] = summary(all);
+        for (int t = 0; t < CMD_TYPE_COUNT; t++) {
+            if (!by_type[t].ns.empty()) doc["latency"][commandTypeName((CommandType)t)] = summary(by_type[t]);
+        }
+        if (speed > 0) doc["lateness"] = summary(lateness);
+        std::ofstream file(json_path);
+        file << doc.dump(2) << "\n";
+    }
+    return 0;
+}
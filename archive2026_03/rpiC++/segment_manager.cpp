@@ -1,10 +1,42 @@
 // segment_manager.cpp - Implementation of segment state manager
 
 #include "segment_manager.h"
+#include "sync_clock.h"
+#include "metrics.h"
+#include "trace.h"
+#include "nlohmann/json.hpp"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <cstdio>
+
+// ─── Lock Timing ─────────────────────────────────────────────────────────────
+
+// Scoped lock on the segment mutex that records how long the caller waited
+class SegmentLock {
+public:
+    explicit SegmentLock(std::recursive_mutex& mutex) : mutex_(mutex) {
+        lockTimed(mutex_);
+    }
+    ~SegmentLock() { mutex_.unlock(); }
+    
+    static void lockTimed(std::recursive_mutex& mutex) {
+        if (mutex.try_lock()) {
+            metrics().segment_lock_wait.observe(0);
+            return;
+        }
+        TRACE_SPAN("segmentLockWait");
+        ScopedTimer wait;
+        mutex.lock();
+        metrics().segment_lock_wait.observe(wait.elapsedUs());
+    }
+    
+private:
+    std::recursive_mutex& mutex_;
+};
 
 // ─── Color Helper ────────────────────────────────────────────────────────────
 
@@ -24,35 +56,37 @@ Color Color::fromHex(const std::string& hex) {
 Segment::Segment(int seg_id, int x_, int y_, int w_, int h_)
     : id(seg_id), x(x_), y(y_), width(w_), height(h_),
       text(""), color(255, 255, 255), bgcolor(0, 0, 0),
-      align(ALIGN_CENTER), effect(EFFECT_NONE), effect_speed(50),
-      scroll_offset(0), last_scroll_update(0),
+      align(ALIGN_CENTER), effect(EFFECT_NONE), effect_speed(SCROLL_SPEED),
+      scroll_offset(0), scroll_origin(0),
       blink_state(true), last_blink_update(0),
+      fade_ms(FADE_DURATION_MS), fade_easing(EASING_IN_OUT), fade_origin(0), fade_alpha(255),
       is_active(false), is_dirty(false),
       frame_enabled(false), frame_color(255, 255, 255), frame_width(2),
-      font_name("arial") {
+      font_name("arial"), antialias(false) {
 }
 
 // ─── SegmentManager ──────────────────────────────────────────────────────────
 
 SegmentManager::SegmentManager()
-    : master_blink_state_(true), master_blink_last_update_(0) {
-    initDefaultLayout();
+    : master_blink_state_(true), clock_(nullptr), wall_time_(false),
+      staging_(false), has_staged_(false), staged_layout_(0), commit_at_(0), commit_pending_(false) {
+    initDefaultLayout(MATRIX_WIDTH, MATRIX_HEIGHT);
 }
 
 SegmentManager::~SegmentManager() {
 }
 
-void SegmentManager::initDefaultLayout() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+void SegmentManager::initDefaultLayout(int width, int height) {
+    SegmentLock lock(mutex_);
     segments_.clear();
     
     // Default: fullscreen on segment 0, others inactive
-    segments_.push_back(Segment(0, 0, 0, MATRIX_WIDTH, MATRIX_HEIGHT));
+    segments_.push_back(Segment(0, 0, 0, width, height));
     segments_[0].is_active = true;
     
-    segments_.push_back(Segment(1, MATRIX_WIDTH/2, 0, MATRIX_WIDTH/2, MATRIX_HEIGHT));
-    segments_.push_back(Segment(2, 0, MATRIX_HEIGHT/2, MATRIX_WIDTH/2, MATRIX_HEIGHT/2));
-    segments_.push_back(Segment(3, MATRIX_WIDTH/2, MATRIX_HEIGHT/2, MATRIX_WIDTH/2, MATRIX_HEIGHT/2));
+    segments_.push_back(Segment(1, width/2, 0, width/2, height));
+    segments_.push_back(Segment(2, 0, height/2, width/2, height/2));
+    segments_.push_back(Segment(3, width/2, height/2, width/2, height/2));
 }
 
 uint64_t SegmentManager::millis() {
@@ -60,22 +94,28 @@ uint64_t SegmentManager::millis() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 }
 
+uint64_t SegmentManager::clockNow() {
+    return clock_ ? clock_->now() : millis();
+}
+
 // ─── Read Access ─────────────────────────────────────────────────────────────
 
 Segment* SegmentManager::getSegment(int seg_id) {
-    if (seg_id >= 0 && seg_id < (int)segments_.size()) {
-        return &segments_[seg_id];
+    std::vector<Segment>& segs = target();
+    if (seg_id >= 0 && seg_id < (int)segs.size()) {
+        return &segs[seg_id];
     }
     return nullptr;
 }
 
 std::vector<Segment> SegmentManager::snapshot() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     return segments_;
 }
 
-std::vector<Segment> SegmentManager::getRenderSnapshot(bool& any_dirty) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+std::vector<Segment> SegmentManager::getRenderSnapshot(bool& any_dirty, PacketStamp* stamp) {
+    TRACE_SPAN("getRenderSnapshot");
+    SegmentLock lock(mutex_);
     std::vector<Segment> result;
     any_dirty = false;
     
@@ -87,21 +127,43 @@ std::vector<Segment> SegmentManager::getRenderSnapshot(bool& any_dirty) {
             }
         }
     }
+    if (stamp) {
+        *stamp = pending_stamp_;
+        pending_stamp_ = PacketStamp();
+    }
     return result;
 }
 
+void SegmentManager::notePacket(uint64_t rx_ns, uint64_t dispatched_ns) {
+    SegmentLock lock(mutex_);
+    if (pending_stamp_.rx_ns != 0) {
+        return;
+    }
+    // A command that changed nothing has no frame to wait for
+    for (const auto& seg : segments_) {
+        if (seg.is_dirty) {
+            pending_stamp_.rx_ns = rx_ns;
+            pending_stamp_.dispatched_ns = dispatched_ns;
+            return;
+        }
+    }
+}
+
 // ─── Write Access ────────────────────────────────────────────────────────────
 
-void SegmentManager::updateText(int seg_id, const std::string& text,
+bool SegmentManager::updateText(int seg_id, const std::string& text,
                                 const std::string& color,
                                 const std::string& bgcolor,
                                 const std::string& align,
                                 const std::string& effect,
                                 int intensity,
-                                const std::string& font) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+                                const std::string& font,
+                                int fade_ms,
+                                const std::string& easing,
+                                int antialias) {
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
-    if (!seg) return;
+    if (!seg) return false;
     
     // Track if anything actually changed
     bool changed = false;
@@ -140,6 +202,23 @@ void SegmentManager::updateText(int seg_id, const std::string& text,
         Effect new_effect = parseEffect(effect);
         if (seg->effect != new_effect) {
             seg->effect = new_effect;
+            seg->scroll_offset = 0;
+            seg->scroll_origin = 0;  // Restart the scroll from the next frame
+            seg->fade_origin = 0;    // and the fade from transparent
+            changed = true;
+        }
+    }
+    
+    if (fade_ms > 0 && seg->fade_ms != fade_ms) {
+        seg->fade_ms = fade_ms;
+        seg->fade_origin = 0;
+        changed = true;
+    }
+    
+    if (!easing.empty()) {
+        Easing new_easing = parseEasing(easing);
+        if (seg->fade_easing != new_easing) {
+            seg->fade_easing = new_easing;
             changed = true;
         }
     }
@@ -147,24 +226,32 @@ void SegmentManager::updateText(int seg_id, const std::string& text,
     if (!font.empty()) {
         std::string f = font;
         std::transform(f.begin(), f.end(), f.begin(), ::tolower);
-        std::string new_font = (f == "monospace" || f == "mono") ? "monospace" : "arial";
+        std::string new_font = (f == "monospace" || f == "mono") ? "monospace" :
+                               (f == "bitmap" || f == "bdf") ? "bitmap" : "arial";
         if (seg->font_name != new_font) {
             seg->font_name = new_font;
             changed = true;
         }
     }
     
+    if (antialias >= 0 && seg->antialias != (antialias != 0)) {
+        seg->antialias = antialias != 0;
+        changed = true;
+    }
+    
     // Note: is_active is controlled by layout command only!
     // Updating text doesn't activate segments outside current layout.
     
     // Only mark dirty if something actually changed
+    bool was_dirty = seg->is_dirty;
     if (changed) {
         seg->is_dirty = true;
     }
+    return changed && !was_dirty;
 }
 
 void SegmentManager::clearSegment(int seg_id) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
     if (seg) {
         seg->text = "";
@@ -173,8 +260,8 @@ void SegmentManager::clearSegment(int seg_id) {
 }
 
 void SegmentManager::clearAll() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    for (auto& seg : segments_) {
+    SegmentLock lock(mutex_);
+    for (auto& seg : target()) {
         seg.text = "";
         seg.is_active = false;  // Deactivate all segments
         seg.is_dirty = true;
@@ -182,21 +269,21 @@ void SegmentManager::clearAll() {
 }
 
 void SegmentManager::markAllDirty() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    for (auto& seg : segments_) {
+    SegmentLock lock(mutex_);
+    for (auto& seg : target()) {
         seg.is_dirty = true;
     }
 }
 
 void SegmentManager::clearDirtyFlags() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     for (auto& seg : segments_) {
         seg.is_dirty = false;
     }
 }
 
 bool SegmentManager::isDirty() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     for (const auto& seg : segments_) {
         if (seg.is_dirty) return true;
     }
@@ -204,7 +291,7 @@ bool SegmentManager::isDirty() {
 }
 
 void SegmentManager::configure(int seg_id, int x, int y, int w, int h) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
     if (seg) {
         std::cout << "[SEG] configure: seg=" << seg_id << " x=" << x << " y=" << y << " w=" << w << " h=" << h << std::endl;
@@ -216,28 +303,28 @@ void SegmentManager::configure(int seg_id, int x, int y, int w, int h) {
         seg->is_dirty = true;
         
         // Mark all segments dirty for full redraw
-        for (auto& s : segments_) {
+        for (auto& s : target()) {
             s.is_dirty = true;
         }
     }
 }
 
 void SegmentManager::activate(int seg_id, bool active) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
     if (seg) {
         seg->is_active = active;
         seg->is_dirty = true;
         
         // Mark all segments dirty for full redraw
-        for (auto& s : segments_) {
+        for (auto& s : target()) {
             s.is_dirty = true;
         }
     }
 }
 
 void SegmentManager::setFrame(int seg_id, bool enabled, const std::string& color, int width) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
     if (seg) {
         std::cout << "[SEG] setFrame: seg=" << seg_id << " enabled=" << enabled << " color=" << color << " width=" << width << std::endl;
@@ -251,7 +338,7 @@ void SegmentManager::setFrame(int seg_id, bool enabled, const std::string& color
 }
 
 void SegmentManager::markDirty(int seg_id) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SegmentLock lock(mutex_);
     Segment* seg = getSegment(seg_id);
     if (seg) {
         seg->is_dirty = true;
@@ -260,14 +347,28 @@ void SegmentManager::markDirty(int seg_id) {
 
 // ─── Effect Updates ──────────────────────────────────────────────────────────
 
-void SegmentManager::updateEffects() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    uint64_t now = millis();
+static float ease(Easing easing, float t) {
+    switch (easing) {
+        case EASING_IN:     return t * t;
+        case EASING_OUT:    return t * (2.0f - t);
+        case EASING_IN_OUT: return t * t * (3.0f - 2.0f * t);
+        default:            return t;
+    }
+}
+
+void SegmentManager::updateEffects(uint64_t present_ms) {
+    SegmentLock lock(mutex_);
     
-    // Update master blink state (500ms toggle)
-    if (now - master_blink_last_update_ >= 500) {
-        master_blink_state_ = !master_blink_state_;
-        master_blink_last_update_ = now;
+    // Every effect runs on the shared clock: blink phase, and the origins of
+    // scrolls and fades, read the same on every panel following it. With the
+    // render loop's deadlines on the shared frame grid, panels that get the
+    // same command start it on the same frame (or one apart at worst).
+    uint64_t shared_ms = clock_ && !wall_time_ ? clock_->fromLocal(present_ms) : present_ms;
+    
+    // Master blink state (500ms toggle)
+    bool blink_state = ((shared_ms / 500) % 2) == 0;
+    if (blink_state != master_blink_state_) {
+        master_blink_state_ = blink_state;
         
         // Mark blinking segments dirty
         for (auto& seg : segments_) {
@@ -282,16 +383,208 @@ void SegmentManager::updateEffects() {
         if (!seg.is_active) continue;
         
         if (seg.effect == EFFECT_SCROLL) {
-            int interval_ms = (seg.effect_speed > 0) ? (1000 / seg.effect_speed) : 50;
-            if (now - seg.last_scroll_update >= (uint64_t)interval_ms) {
-                seg.scroll_offset += 1;
-                seg.last_scroll_update = now;
+            // Offset from elapsed presentation time, not a count of ticks
+            if (wall_time_) {
+                seg.scroll_origin = 0;
+            } else if (seg.scroll_origin == 0 || seg.scroll_origin > shared_ms) {
+                seg.scroll_origin = shared_ms;
+            }
+            int offset = (int)((shared_ms - seg.scroll_origin) * (uint64_t)std::max(0, seg.effect_speed) / 1000);
+            if (offset != seg.scroll_offset) {
+                seg.scroll_offset = offset;
                 seg.is_dirty = true;
             }
         } else if (seg.effect == EFFECT_BLINK) {
             seg.blink_state = master_blink_state_;
+        } else if (seg.effect == EFFECT_FADE) {
+            // Fade in over fade_ms, out over fade_ms, repeat
+            if (wall_time_) {
+                seg.fade_origin = 0;
+            } else if (seg.fade_origin == 0 || seg.fade_origin > shared_ms) {
+                seg.fade_origin = shared_ms;
+            }
+            uint64_t period = 2 * (uint64_t)std::max(1, seg.fade_ms);
+            uint64_t phase = (shared_ms - seg.fade_origin) % period;
+            float t = (phase < period / 2 ? phase : period - phase) / (float)(period / 2);
+            uint8_t alpha = (uint8_t)lroundf(255.0f * ease(seg.fade_easing, t));
+            if (alpha != seg.fade_alpha) {
+                seg.fade_alpha = alpha;
+                seg.is_dirty = true;
+            }
+        }
+    }
+}
+
+// ─── Staged Presentation ─────────────────────────────────────────────────────
+
+void SegmentManager::beginStaging() {
+    // Held until endStaging() so the render thread never sees a half-staged state
+    SegmentLock::lockTimed(mutex_);
+    if (!has_staged_) {
+        staged_ = segments_;
+        has_staged_ = true;
+    }
+    staging_ = true;
+}
+
+void SegmentManager::endStaging() {
+    staging_ = false;
+    mutex_.unlock();
+}
+
+bool SegmentManager::hasStaged() {
+    SegmentLock lock(mutex_);
+    return has_staged_;
+}
+
+int SegmentManager::stagedLayout() {
+    SegmentLock lock(mutex_);
+    return staged_layout_;
+}
+
+void SegmentManager::stageLayout(int preset) {
+    SegmentLock lock(mutex_);
+    staged_layout_ = preset;
+}
+
+void SegmentManager::scheduleCommit(uint64_t at_ms) {
+    SegmentLock lock(mutex_);
+    if (!has_staged_) {
+        std::cout << "[SEG] commit: nothing staged" << std::endl;
+        return;
+    }
+    if (at_ms == 0) {
+        commitStaged();
+        return;
+    }
+    commit_at_ = at_ms;
+    commit_pending_ = true;
+}
+
+void SegmentManager::discardStaged() {
+    SegmentLock lock(mutex_);
+    staged_.clear();
+    has_staged_ = false;
+    staged_layout_ = 0;
+    commit_pending_ = false;
+}
+
+bool SegmentManager::applyPendingCommit() {
+    SegmentLock lock(mutex_);
+    if (!commit_pending_ || clockNow() < commit_at_) {
+        return false;
+    }
+    commitStaged();
+    return true;
+}
+
+int64_t SegmentManager::msUntilCommit() {
+    SegmentLock lock(mutex_);
+    if (!commit_pending_) return -1;
+    uint64_t now = clockNow();
+    return (commit_at_ > now) ? (int64_t)(commit_at_ - now) : 0;
+}
+
+void SegmentManager::commitStaged() {
+    segments_.swap(staged_);
+    staged_.clear();
+    has_staged_ = false;
+    commit_pending_ = false;
+    // Under the same lock as the swap, so layout and segments change together
+    if (staged_layout_ && layout_callback_) {
+        layout_callback_(staged_layout_);
+    }
+    staged_layout_ = 0;
+    for (auto& seg : segments_) {
+        seg.is_dirty = true;
+    }
+}
+
+// ─── Persistence ─────────────────────────────────────────────────────────────
+
+using json = nlohmann::json;
+
+static json colorJson(const Color& c) {
+    return json::array({c.r, c.g, c.b});
+}
+
+static Color colorFromJson(const json& j, const Color& fallback) {
+    if (!j.is_array() || j.size() != 3) return fallback;
+    return Color(j[0].get<uint8_t>(), j[1].get<uint8_t>(), j[2].get<uint8_t>());
+}
+
+bool SegmentManager::saveContent(const std::string& path, int layout) {
+    json doc;
+    doc["layout"] = layout;
+    doc["segments"] = json::array();
+    {
+        SegmentLock lock(mutex_);
+        for (const auto& seg : segments_) {
+            doc["segments"].push_back({
+                {"id", seg.id}, {"x", seg.x}, {"y", seg.y}, {"w", seg.width}, {"h", seg.height},
+                {"active", seg.is_active}, {"text", seg.text},
+                {"color", colorJson(seg.color)}, {"bgcolor", colorJson(seg.bgcolor)},
+                {"align", (int)seg.align}, {"effect", (int)seg.effect}, {"speed", seg.effect_speed},
+                {"fade_ms", seg.fade_ms}, {"easing", (int)seg.fade_easing},
+                {"font", seg.font_name}, {"aa", seg.antialias}, {"frame", seg.frame_enabled},
+                {"frame_color", colorJson(seg.frame_color)}, {"frame_width", seg.frame_width}
+            });
+        }
+    }
+    
+    // Write-then-rename: a power cut never leaves a truncated file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp);
+        if (!file.is_open()) {
+            std::cerr << "[SEG] Cannot write " << tmp << std::endl;
+            return false;
+        }
+        file << doc.dump();
+        if (!file.good()) return false;
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool SegmentManager::loadContent(const std::string& path, int& layout) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    
+    try {
+        json doc = json::parse(file);
+        SegmentLock lock(mutex_);
+        for (const auto& j : doc.at("segments")) {
+            Segment* seg = getSegment(j.at("id").get<int>());
+            if (!seg) continue;
+            seg->x = j.value("x", seg->x);
+            seg->y = j.value("y", seg->y);
+            seg->width = j.value("w", seg->width);
+            seg->height = j.value("h", seg->height);
+            seg->is_active = j.value("active", false);
+            seg->text = j.value("text", "").substr(0, MAX_TEXT_LENGTH);
+            seg->color = colorFromJson(j.value("color", json()), seg->color);
+            seg->bgcolor = colorFromJson(j.value("bgcolor", json()), seg->bgcolor);
+            seg->align = (Align)std::min(std::max(j.value("align", (int)ALIGN_CENTER), 0), (int)ALIGN_RIGHT);
+            seg->effect = (Effect)std::min(std::max(j.value("effect", (int)EFFECT_NONE), 0), (int)EFFECT_FADE);
+            seg->effect_speed = j.value("speed", SCROLL_SPEED);
+            seg->fade_ms = std::max(1, j.value("fade_ms", FADE_DURATION_MS));
+            seg->fade_easing = (Easing)std::min(std::max(j.value("easing", (int)EASING_IN_OUT), 0), (int)EASING_IN_OUT);
+            seg->font_name = j.value("font", "arial");
+            seg->antialias = j.value("aa", false);
+            seg->frame_enabled = j.value("frame", false);
+            seg->frame_color = colorFromJson(j.value("frame_color", json()), seg->frame_color);
+            seg->frame_width = j.value("frame_width", 2);
+            seg->scroll_offset = 0;
+            seg->scroll_origin = 0;
+            seg->fade_origin = 0;
+            seg->is_dirty = true;
         }
+        layout = doc.value("layout", 1);
+    } catch (const json::exception& e) {
+        std::cerr << "[SEG] Ignoring " << path << ": " << e.what() << std::endl;
+        return false;
     }
+    return true;
 }
 
 // ─── Helpers ─────────────────────────────────────────────────────────────────
@@ -314,3 +607,14 @@ Effect SegmentManager::parseEffect(const std::string& value) {
     if (v == "fade") return EFFECT_FADE;
     return EFFECT_NONE;
 }
+
+Easing SegmentManager::parseEasing(const std::string& value) {
+    std::string v = value;
+    std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+    if (v.compare(0, 5, "ease-") == 0) v = v.substr(5);  // CSS names
+    
+    if (v == "linear") return EASING_LINEAR;
+    if (v == "in") return EASING_IN;
+    if (v == "out") return EASING_OUT;
+    return EASING_IN_OUT;
+}
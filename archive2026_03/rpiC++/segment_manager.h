@@ -3,12 +3,15 @@
 #ifndef SEGMENT_MANAGER_H
 #define SEGMENT_MANAGER_H
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <mutex>
 #include <cstdint>
 #include "config.h"
 
+class SyncClock;
+
 struct Color {
     uint8_t r, g, b;
     
@@ -27,21 +30,33 @@ struct Segment {
     Color bgcolor;
     Align align;
     Effect effect;
-    int effect_speed;
+    int effect_speed;       // Scroll speed, pixels per second
     int scroll_offset;
-    uint64_t last_scroll_update;
+    uint64_t scroll_origin; // Shared-clock time of scroll offset 0 (0 = not started)
     bool blink_state;
     uint64_t last_blink_update;
+    int fade_ms;            // Duration of one fade in (or out)
+    Easing fade_easing;
+    uint64_t fade_origin;   // Shared-clock time the fade-in started (0 = not started)
+    uint8_t fade_alpha;     // Text opacity for this frame, 0-255
     bool is_active;
     bool is_dirty;
     bool frame_enabled;
     Color frame_color;
     int frame_width;
-    std::string font_name;  // "arial" or "monospace"
+    std::string font_name;  // "arial", "monospace" or "bitmap"
+    bool antialias;         // Blend glyph edges instead of thresholding them
     
     Segment(int seg_id, int x_, int y_, int w_, int h_);
 };
 
+// Receive and dispatch times (steady clock, ns) of the oldest command whose
+// change no frame has shown yet; zero when there is none
+struct PacketStamp {
+    uint64_t rx_ns = 0;
+    uint64_t dispatched_ns = 0;
+};
+
 class SegmentManager {
 public:
     SegmentManager();
@@ -50,16 +65,26 @@ public:
     // Read access (thread-safe)
     Segment* getSegment(int seg_id);
     std::vector<Segment> snapshot();
-    std::vector<Segment> getRenderSnapshot(bool& any_dirty);
+    // The renderer also takes the packet stamp the frame is going to show
+    std::vector<Segment> getRenderSnapshot(bool& any_dirty, PacketStamp* stamp = nullptr);
+    
+    // A command received at `rx_ns` was applied at `dispatched_ns`; kept
+    // (unless an older one is waiting) for the frame that first shows it
+    void notePacket(uint64_t rx_ns, uint64_t dispatched_ns);
     
     // Write access (thread-safe)
-    void updateText(int seg_id, const std::string& text,
+    // updateText returns false when the update adds no render work: nothing
+    // changed, or the segment already has a change waiting to be drawn
+    bool updateText(int seg_id, const std::string& text,
                    const std::string& color = "",
                    const std::string& bgcolor = "",
                    const std::string& align = "",
                    const std::string& effect = "",
                    int intensity = 255,
-                   const std::string& font = "");
+                   const std::string& font = "",
+                   int fade_ms = 0,
+                   const std::string& easing = "",
+                   int antialias = -1);  // -1 = keep
     void clearSegment(int seg_id);
     void clearAll();
     void markAllDirty();
@@ -69,23 +94,87 @@ public:
     void activate(int seg_id, bool active);
     void setFrame(int seg_id, bool enabled, const std::string& color = "#FFFFFF", int width = 2);
     
-    // Effect updates (call from render loop)
-    void updateEffects();
+    // Back to the startup layout (segment 0 fullscreen) on a canvas this size
+    void resetLayout(int width, int height) { initDefaultLayout(width, height); }
+    
+    // Effect updates (call from render loop) for the frame presented at
+    // `present_ms` (steady clock); effect state is a function of that time
+    // alone, so late or skipped frames never change the scroll speed
+    void updateEffects(uint64_t present_ms);
     
     // Mark a specific segment dirty
     void markDirty(int seg_id);
+    
+    // Effects run on this clock so panels sharing it blink, scroll and fade together
+    void setClock(const SyncClock* clock) { clock_ = clock; }
+    
+    // Video wall: `present_ms` is the wall's shared frame time, the same on
+    // every node, and scroll and fade run from its zero instead of from the
+    // frame that started them - so neighbouring viewports stay in phase
+    void setWallTime(bool wall_time) { wall_time_ = wall_time; }
+    
+    // Two-phase presentation: writes made inside a StagingScope go to a back
+    // copy of the segments; commit makes the whole copy visible at once.
+    class StagingScope {
+    public:
+        explicit StagingScope(SegmentManager& sm) : sm_(sm) { sm_.beginStaging(); }
+        ~StagingScope() { sm_.endStaging(); }
+    private:
+        SegmentManager& sm_;
+    };
+    
+    // True inside a StagingScope held by the calling thread
+    bool isStaging() const { return staging_; }
+    bool hasStaged();
+    
+    // A layout preset staged with the segments' geometry (0 = none); it is
+    // handed to the layout callback when the commit makes it visible
+    int stagedLayout();
+    void stageLayout(int preset);
+    void setLayoutCallback(std::function<void(int)> cb) { layout_callback_ = std::move(cb); }
+    
+    // Commit staged content at `at_ms` on the shared clock (0 = immediately)
+    void scheduleCommit(uint64_t at_ms);
+    void discardStaged();
+    
+    // Call from render loop; returns true when staged content went live
+    bool applyPendingCommit();
+    
+    // Milliseconds until a scheduled commit is due, or -1 if none
+    int64_t msUntilCommit();
+    
+    // Live segments (geometry, content, effects, frames) plus the layout
+    // preset they came from, so a restart can put them straight back
+    bool saveContent(const std::string& path, int layout);
+    bool loadContent(const std::string& path, int& layout);
 
 private:
     std::vector<Segment> segments_;
+    std::vector<Segment> staged_;
     std::recursive_mutex mutex_;
     bool master_blink_state_;
-    uint64_t master_blink_last_update_;
+    const SyncClock* clock_;
+    bool wall_time_;
+    bool staging_;
+    bool has_staged_;
+    int staged_layout_;
+    std::function<void(int)> layout_callback_;
+    uint64_t commit_at_;
+    bool commit_pending_;
+    PacketStamp pending_stamp_;
+    
+    std::vector<Segment>& target() { return staging_ ? staged_ : segments_; }
+    void beginStaging();
+    void endStaging();
+    void commitStaged();
+    uint64_t clockNow();
     
-    void initDefaultLayout();
+    void initDefaultLayout(int width, int height);
     uint64_t millis();
     
     Align parseAlign(const std::string& value);
     Effect parseEffect(const std::string& value);
+    Easing parseEasing(const std::string& value);
 };
 
 #endif // SEGMENT_MANAGER_H
@@ -0,0 +1,89 @@
+// sync_clock.cpp - Shared presentation clock implementation
+
+#include "sync_clock.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+SyncClock::SyncClock()
+    : offset_ms_(0), synced_(false), master_(false), candidate_id_(0), outranked_until_ms_(0) {
+}
+
+uint64_t SyncClock::localNow() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+uint64_t SyncClock::now() const {
+    return (uint64_t)((int64_t)localNow() + offset_ms_.load(std::memory_order_relaxed));
+}
+
+uint64_t SyncClock::toLocal(uint64_t shared_ms) const {
+    return (uint64_t)((int64_t)shared_ms - offset_ms_.load(std::memory_order_relaxed));
+}
+
+uint64_t SyncClock::fromLocal(uint64_t local_ms) const {
+    return (uint64_t)((int64_t)local_ms + offset_ms_.load(std::memory_order_relaxed));
+}
+
+void SyncClock::onBeacon(uint64_t master_ms, uint32_t id) {
+    uint32_t own_id = candidate_id_.load(std::memory_order_relaxed);
+    if (own_id != 0) {
+        // Our own beacon, or one from a panel we outrank: it will step down
+        if (id != 0 && id >= own_id) return;
+        outranked_until_ms_ = localNow() + CLOCK_ELECTION_TIMEOUT_MS;
+        if (master_) {
+            master_ = false;
+            std::cout << "[CLOCK] Clock master " << (id ? "id " + std::to_string(id) : std::string("(controller)"))
+                     << " outranks us - following it" << std::endl;
+        }
+    }
+    if (master_) return;
+
+    int64_t sample = (int64_t)master_ms - (int64_t)localNow();
+
+    std::lock_guard<std::mutex> lock(window_mutex_);
+
+    // A large jump means the master restarted (new steady clock epoch) - start over
+    if (!window_.empty() && std::llabs(sample - offset_ms_.load()) > CLOCK_RESYNC_MS) {
+        std::cout << "[CLOCK] Beacon jumped by " << (sample - offset_ms_.load())
+                 << "ms - resynchronising" << std::endl;
+        window_.clear();
+    }
+
+    window_.push_back(sample);
+    while (window_.size() > CLOCK_WINDOW) {
+        window_.pop_front();
+    }
+
+    offset_ms_ = *std::max_element(window_.begin(), window_.end());
+
+    if (!synced_) {
+        synced_ = true;
+        std::cout << "[CLOCK] Synchronised to beacon (offset " << offset_ms_.load() << "ms)" << std::endl;
+    }
+}
+
+void SyncClock::setCandidate(uint32_t id) {
+    // Listen for a sitting master before claiming the role
+    outranked_until_ms_ = localNow() + CLOCK_ELECTION_TIMEOUT_MS;
+    candidate_id_ = id;
+}
+
+bool SyncClock::shouldBeacon() {
+    uint32_t own_id = candidate_id_.load(std::memory_order_relaxed);
+    if (own_id == 0) {
+        return master_;
+    }
+    if (localNow() < outranked_until_ms_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (!master_) {
+        // The shared time we were following (if any) is the one we now beacon
+        master_ = true;
+        std::cout << "[CLOCK] Elected clock master (id " << own_id << ")" << std::endl;
+    }
+    return true;
+}
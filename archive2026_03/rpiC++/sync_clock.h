@@ -0,0 +1,66 @@
+// sync_clock.h - Shared presentation clock disciplined by network beacons
+//
+// One panel (or the controller) broadcasts {"cmd":"clock","t":<ms>} beacons.
+// Every other panel keeps an offset from its own steady clock so that now()
+// reads the same on all panels in a group. Beacons are one-way, so network
+// delay only ever makes a sample look late; the largest offset seen in the
+// recent window is the least-delayed one and is the estimate we use.
+//
+// Instead of naming a master, panels can elect one: every candidate carries
+// a random id in its beacons ({"cmd":"clock","t":<ms>,"id":<n>}) and the
+// lowest id heard in the last CLOCK_ELECTION_TIMEOUT_MS is the master. A
+// candidate that hears none lower takes over, beaconing the shared time it
+// was following, so the clock carries on without a jump. Beacons without
+// an id (the controller's) outrank every panel.
+
+#ifndef SYNC_CLOCK_H
+#define SYNC_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+class SyncClock {
+public:
+    SyncClock();
+
+    // Shared clock in milliseconds (local steady clock until the first beacon)
+    uint64_t now() const;
+
+    // Local steady clock in milliseconds
+    static uint64_t localNow();
+
+    // Convert a shared-clock time to the local steady clock, and back
+    uint64_t toLocal(uint64_t shared_ms) const;
+    uint64_t fromLocal(uint64_t local_ms) const;
+
+    // Feed a beacon timestamp received just now (`id` 0: sent by the controller)
+    void onBeacon(uint64_t master_ms, uint32_t id = 0);
+
+    bool isSynced() const { return synced_; }
+
+    // The master's clock is the reference; it ignores beacons (including its own)
+    void setMaster(bool master) { master_ = master; }
+    bool isMaster() const { return master_; }
+
+    // Take part in the master election under this id (non-zero)
+    void setCandidate(uint32_t id);
+    uint32_t candidateId() const { return candidate_id_; }
+
+    // Beacon thread, once per interval: true if this panel should beacon now
+    // (a configured master, or the elected one)
+    bool shouldBeacon();
+
+private:
+    std::atomic<int64_t> offset_ms_;
+    std::atomic<bool> synced_;
+    std::atomic<bool> master_;
+    std::atomic<uint32_t> candidate_id_;        // 0: not a candidate
+    std::atomic<uint64_t> outranked_until_ms_;  // Local time a lower id was last heard + timeout
+
+    std::mutex window_mutex_;
+    std::deque<int64_t> window_;
+};
+
+#endif // SYNC_CLOCK_H
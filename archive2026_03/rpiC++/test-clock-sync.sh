@@ -0,0 +1,101 @@
+#!/bin/bash
+# test-clock-sync.sh - Clock master election and effect phase on one machine
+#
+#   ./test-clock-sync.sh [PANELS]
+#
+# Starts PANELS (default 3) led-matrix-headless processes with
+# "clock_master": "auto", waits for the election, broadcasts the same
+# scrolling text to all of them and compares their frames: panels on the
+# shared clock render the same frame at the same instant. The elected
+# master is then stopped, and the rest must elect another and stay in step.
+
+PANELS="${1:-3}"
+PORT=21324
+BIN="./led-matrix-headless"
+DIR="$(mktemp -d /tmp/led-clock.XXXXXX)"
+
+if [ ! -x "$BIN" ]; then
+    echo "Build it first: make headless"
+    exit 1
+fi
+
+echo "=================================================="
+echo "Clock sync: $PANELS panels electing a master (loopback)"
+echo "Output in $DIR"
+echo "=================================================="
+
+PIDS=()
+for ((i = 0; i < PANELS; i++)); do
+    echo '{"panel": {"width": 64, "height": 32, "chain": 1, "parallel": 1}, "clock_master": "auto"}' > "$DIR/panel$i.json"
+    "$BIN" --headless --config "$DIR/panel$i.json" --ppm "$DIR/panel$i.ppm" > "$DIR/panel$i.log" 2>&1 &
+    PIDS+=($!)
+done
+trap 'kill "${PIDS[@]}" 2>/dev/null' EXIT
+
+# Candidates listen for 3 beacon intervals before claiming the role
+sleep 5
+
+python3 - "$PORT" <<'EOF'
+import socket, sys, time
+port = int(sys.argv[1])
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+commands = ['{"cmd":"text","seg":0,"text":"Every panel in step","effect":"scroll"}']
+# Sent twice: the first command to arrive dismisses the splash, clearing segment 0
+for attempt in range(2):
+    for cmd in commands:
+        s.sendto(cmd.encode(), ("255.255.255.255", port))
+    time.sleep(0.5)
+EOF
+
+# Snapshots taken between frames: in step, every panel shows the same one
+compare() {
+    python3 - "$DIR" "$@" <<'EOF'
+import sys, time
+d, panels = sys.argv[1], sys.argv[2:]
+same = 0
+for shot in range(10):
+    frames = {open("%s/panel%s.ppm" % (d, p), "rb").read() for p in panels}
+    same += len(frames) == 1
+    time.sleep(0.237)
+print("  %d of 10 snapshots identical across panels %s" % (same, ",".join(panels)))
+sys.exit(0 if same >= 7 else 1)
+EOF
+}
+
+FAILED=0
+ALL=$(seq 0 $((PANELS - 1)))
+compare $ALL || FAILED=1
+
+# The master is the panel whose last clock event is its election
+MASTER=""
+for ((i = 0; i < PANELS; i++)); do
+    grep "\[CLOCK\]" "$DIR/panel$i.log" | tail -1 | grep -q "Elected" && MASTER=$i
+done
+if [ -z "$MASTER" ]; then
+    echo "✗ no panel was elected"
+    exit 1
+fi
+echo "✓ panel $MASTER is the clock master - stopping it"
+kill -TERM "${PIDS[$MASTER]}"
+sleep 5
+
+REST=$(seq 0 $((PANELS - 1)) | grep -vx "$MASTER")
+TOOK_OVER=""
+for i in $REST; do
+    grep "\[CLOCK\]" "$DIR/panel$i.log" | tail -1 | grep -q "Elected" && TOOK_OVER=$i
+done
+if [ -n "$TOOK_OVER" ]; then
+    echo "✓ panel $TOOK_OVER took over"
+else
+    echo "✗ no panel took over"
+    FAILED=1
+fi
+compare $REST || FAILED=1
+
+kill -TERM "${PIDS[@]}" 2>/dev/null
+wait "${PIDS[@]}" 2>/dev/null
+trap - EXIT
+
+grep -h "\[CLOCK\]" "$DIR"/panel*.log | sort | uniq -c
+exit $FAILED
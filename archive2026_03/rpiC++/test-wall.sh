@@ -0,0 +1,90 @@
+#!/bin/bash
+# test-wall.sh - Video wall on one machine: headless nodes over loopback multicast
+#
+#   ./test-wall.sh [NODES]
+#
+# Starts NODES (default 4) led-matrix-headless processes, each a 64×32 node
+# of a (NODES × 64)×32 wall, node 0 the master. A scrolling ticker is sent
+# to the wall group; the nodes' last frames are stitched into wall.ppm, and
+# every follower must have locked onto the master's frame beacons.
+
+NODES="${1:-4}"
+GROUP="239.255.21.1"
+PORT=21324
+BIN="./led-matrix-headless"
+DIR="$(mktemp -d /tmp/led-wall.XXXXXX)"
+
+if [ ! -x "$BIN" ]; then
+    echo "Build it first: make headless"
+    exit 1
+fi
+
+echo "=================================================="
+echo "Video wall: $NODES nodes of 64×32 on $GROUP (loopback)"
+echo "Output in $DIR"
+echo "=================================================="
+
+PIDS=()
+for ((i = 0; i < NODES; i++)); do
+    MASTER=false
+    [ "$i" -eq 0 ] && MASTER=true
+    cat > "$DIR/node$i.json" <<EOF
+{"panel": {"width": 64, "height": 32, "chain": 1, "parallel": 1},
+ "wall": {"width": $((NODES * 64)), "height": 32, "x": $((i * 64)), "y": 0,
+          "master": $MASTER, "group": "$GROUP", "interface": "127.0.0.1"}}
+EOF
+    "$BIN" --headless --config "$DIR/node$i.json" --ppm "$DIR/node$i.ppm" > "$DIR/node$i.log" 2>&1 &
+    PIDS+=($!)
+done
+trap 'kill "${PIDS[@]}" 2>/dev/null' EXIT
+
+sleep 1
+
+python3 - "$GROUP" "$PORT" <<'EOF'
+import socket, sys, time
+group, port = sys.argv[1], int(sys.argv[2])
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton("127.0.0.1"))
+s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+commands = ['{"cmd":"text","seg":0,"text":"One ticker across the whole wall","effect":"scroll"}',
+            '{"cmd":"frame","seg":0,"enabled":true,"color":"FFFF00","width":1}']
+# Sent twice: the first command to arrive dismisses the splash, clearing segment 0
+for attempt in range(2):
+    for cmd in commands:
+        s.sendto(cmd.encode(), (group, port))
+    time.sleep(0.5)
+EOF
+
+sleep 2
+
+# Snapshot the nodes while they run (a stopping node blanks its canvas)
+python3 - "$DIR" "$NODES" <<'EOF'
+import sys
+d, n = sys.argv[1], int(sys.argv[2])
+def read(path):
+    data = open(path, "rb").read()
+    parts = data.split(b"\n", 3)
+    w, h = map(int, parts[1].split())
+    return w, h, parts[3]
+nodes = [read("%s/node%d.ppm" % (d, i)) for i in range(n)]
+w, h = nodes[0][0], nodes[0][1]
+rows = b"".join(b"".join(p[2][y * w * 3:(y + 1) * w * 3] for p in nodes) for y in range(h))
+open(d + "/wall.ppm", "wb").write(b"P6\n%d %d\n255\n" % (w * n, h) + rows)
+print("Stitched %d×%d → %s/wall.ppm" % (w * n, h, d))
+EOF
+
+kill -TERM "${PIDS[@]}" 2>/dev/null
+wait "${PIDS[@]}" 2>/dev/null
+trap - EXIT
+
+FAILED=0
+for ((i = 1; i < NODES; i++)); do
+    if grep -q "\[WALL\] Following frame beacons" "$DIR/node$i.log"; then
+        echo "✓ node $i follows the master"
+    else
+        echo "✗ node $i never heard a frame beacon (see $DIR/node$i.log)"
+        FAILED=1
+    fi
+done
+
+exit $FAILED
@@ -0,0 +1,138 @@
+// test_pattern.cpp - Panel qualification patterns
+
+#include "test_pattern.h"
+#include <algorithm>
+#include <cstring>
+
+#define BAR_SPEED_PX_PER_S  7.5   // Same drift speed as the old direct-draw bars
+#define WALK_STEP_MS        25
+#define CHECKER_PERIOD_MS   1000
+
+static const char* PATTERN_NAMES[] = {"none", "bars", "gradient", "walk", "checker", "ramp"};
+
+// Unknown or missing names give the default colour bars
+TestPattern parseTestPattern(const std::string& name) {
+    for (int i = PATTERN_NONE; i <= PATTERN_PWM_RAMP; i++) {
+        if (name == PATTERN_NAMES[i]) return (TestPattern)i;
+    }
+    return PATTERN_BARS;
+}
+
+const char* testPatternName(TestPattern pattern) {
+    return PATTERN_NAMES[pattern];
+}
+
+TestPatternGenerator::TestPatternGenerator()
+    : pattern_(PATTERN_NONE), width_(0), height_(0), built_(false), bar_period_(1) {
+}
+
+void TestPatternGenerator::setPattern(TestPattern pattern) {
+    if (pattern != pattern_) {
+        pattern_ = pattern;
+        built_ = false;
+    }
+}
+
+// Fully saturated hue, h in 0..1535
+static void hueToRgb(int h, uint8_t* p) {
+    int sector = h / 256, f = h % 256;
+    uint8_t up = f, down = 255 - f;
+    const uint8_t table[6][3] = {
+        {255, up, 0}, {down, 255, 0}, {0, 255, up},
+        {0, down, 255}, {up, 0, 255}, {255, 0, down}
+    };
+    memcpy(p, table[sector % 6], 3);
+}
+
+void TestPatternGenerator::build(int width, int height) {
+    width_ = width;
+    height_ = height;
+    built_ = true;
+
+    if (pattern_ == PATTERN_BARS) {
+        // Red, Green, Blue, Cyan, Magenta, Yellow, White, Black
+        static const uint8_t colors[8][3] = {
+            {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {0, 255, 255},
+            {255, 0, 255}, {255, 255, 0}, {255, 255, 255}, {0, 0, 0}
+        };
+        int bar_width = std::max(1, width / 5);
+        bar_period_ = bar_width * 8;
+        bar_row_.resize((size_t)(bar_period_ + width) * 3);
+        for (int i = 0; i < bar_period_ + width; i++) {
+            memcpy(&bar_row_[i * 3], colors[(i / bar_width) % 8], 3);
+        }
+    } else if (pattern_ == PATTERN_CHECKER) {
+        for (int phase = 0; phase < 2; phase++) {
+            checker_rows_[phase].assign((size_t)width * 3, 0);
+            for (int x = phase; x < width; x += 2) {
+                memset(&checker_rows_[phase][x * 3], 255, 3);
+            }
+        }
+    } else if (pattern_ == PATTERN_GRADIENT) {
+        still_.resize(width, height);
+        for (int y = 0; y < height; y++) {
+            int level = 255 - (y * 255) / std::max(1, height - 1);
+            uint8_t* p = still_.row(y);
+            for (int x = 0; x < width; x++, p += 3) {
+                hueToRgb((x * 1535) / std::max(1, width - 1), p);
+                for (int c = 0; c < 3; c++) p[c] = (p[c] * level) / 255;
+            }
+        }
+    } else if (pattern_ == PATTERN_PWM_RAMP) {
+        // Bands top to bottom: red, green, blue, white
+        still_.resize(width, height);
+        for (int y = 0; y < height; y++) {
+            int band = std::min(3, (y * 4) / std::max(1, height));
+            uint8_t* p = still_.row(y);
+            for (int x = 0; x < width; x++, p += 3) {
+                uint8_t v = (uint8_t)((x * 255) / std::max(1, width - 1));
+                p[0] = (band == 0 || band == 3) ? v : 0;
+                p[1] = (band == 1 || band == 3) ? v : 0;
+                p[2] = (band == 2 || band == 3) ? v : 0;
+            }
+        }
+    }
+}
+
+void TestPatternGenerator::render(Framebuffer& frame, uint64_t t_ms) {
+    if (!built_ || frame.width != width_ || frame.height != height_) {
+        build(frame.width, frame.height);
+    }
+    size_t row_bytes = (size_t)frame.width * 3;
+
+    switch (pattern_) {
+        case PATTERN_BARS: {
+            int offset = (int)(t_ms * BAR_SPEED_PX_PER_S / 1000) % bar_period_;
+            for (int y = 0; y < frame.height; y++) {
+                memcpy(frame.row(y), &bar_row_[offset * 3], row_bytes);
+            }
+            break;
+        }
+        case PATTERN_CHECKER: {
+            int phase = (int)((t_ms / CHECKER_PERIOD_MS) % 2);
+            for (int y = 0; y < frame.height; y++) {
+                memcpy(frame.row(y), checker_rows_[(y + phase) & 1].data(), row_bytes);
+            }
+            break;
+        }
+        case PATTERN_GRADIENT:
+        case PATTERN_PWM_RAMP:
+            memcpy(frame.pixels.data(), still_.pixels.data(), frame.byteCount());
+            break;
+        case PATTERN_WALK: {
+            // Previous pixel stays lit too, so none is skipped between frames
+            frame.fill(0, 0, 0);
+            size_t count = frame.pixelCount();
+            if (count == 0) break;
+            size_t step = (size_t)(t_ms / WALK_STEP_MS);
+            for (size_t i = 0; i < 2; i++) {
+                size_t index = (step + count - i) % count;
+                frame.setPixel(index % frame.width, index / frame.width, 255, 255, 255);
+            }
+            break;
+        }
+        case PATTERN_NONE:
+            frame.fill(0, 0, 0);
+            break;
+    }
+}
@@ -0,0 +1,54 @@
+// test_pattern.h - Panel qualification patterns composed off-screen
+//
+// Patterns are drawn into the renderer's frame, then presented with
+// SwapOnVSync like any other frame, so they never race the renderer.
+// Each pattern's rows are built once per size; animating a frame is
+// then just copying rows at an offset.
+
+#ifndef TEST_PATTERN_H
+#define TEST_PATTERN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "framebuffer.h"
+
+enum TestPattern {
+    PATTERN_NONE = 0,
+    PATTERN_BARS,       // Moving colour bars
+    PATTERN_GRADIENT,   // Hue across, brightness down
+    PATTERN_WALK,       // One white pixel visiting every pixel in turn
+    PATTERN_CHECKER,    // 1px checkerboard, inverting once a second
+    PATTERN_PWM_RAMP    // R, G, B and white 0-255 ramps in horizontal bands
+};
+
+TestPattern parseTestPattern(const std::string& name);
+const char* testPatternName(TestPattern pattern);
+
+class TestPatternGenerator {
+public:
+    TestPatternGenerator();
+
+    void setPattern(TestPattern pattern);
+    TestPattern pattern() const { return pattern_; }
+
+    // Compose the pattern at time `t_ms` into `frame` (its full size)
+    void render(Framebuffer& frame, uint64_t t_ms);
+
+private:
+    TestPattern pattern_;
+    int width_;
+    int height_;
+    bool built_;
+
+    // Bars: one period-extended row, copied at the scroll offset
+    std::vector<uint8_t> bar_row_;
+    int bar_period_;
+    // Checker: even and odd rows; gradient / ramp: the whole static frame
+    std::vector<uint8_t> checker_rows_[2];
+    Framebuffer still_;
+
+    void build(int width, int height);
+};
+
+#endif // TEST_PATTERN_H
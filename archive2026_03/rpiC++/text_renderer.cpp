@@ -2,25 +2,47 @@
 
 #include "text_renderer.h"
 #include "udp_handler.h"
+#include "pixel_stream.h"
+#include "frame_mailbox.h"
+#include "metrics.h"
+#include "trace.h"
+#include "blend.h"
 #include <iostream>
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
 
 extern UDPHandler* g_udp_handler;  // Declared in main.cpp
 
-TextRenderer::TextRenderer(RGBMatrix* matrix, SegmentManager* segment_manager)
-    : matrix_(matrix),
-      canvas_(matrix->CreateFrameCanvas()),
+TextRenderer::TextRenderer(DisplayBackend* display, SegmentManager* segment_manager,
+                           PixelStream* pixel_stream)
+    : display_(display),
       sm_(segment_manager),
+      stream_(pixel_stream),
+      stream_was_active_(false),
+      preview_(nullptr),
       ft_initialized_(false),
       current_orientation_(LANDSCAPE),
-      canvas_width_(MATRIX_WIDTH),
-      canvas_height_(MATRIX_HEIGHT),
       last_layout_(0),
       group_id_cache_(0),
       group_color_cache_(0, 0, 0),
-      render_count_(0) {
+      render_count_(0),
+      viewport_x_(0),
+      viewport_y_(0) {
+    
+    frame_.resize(display_->width(), display_->height());
+    kernels_ = &selectKernels(frame_.width, frame_.height);
+    std::cout << "[RENDER] " << kernels_->name << " kernels" << std::endl;
+    canvas_band_.rows = {0, frame_.height};
+    placements_.resize(1);
+    
+    // Coverage is a fraction of light; the panel's values are not linear in it
+    for (int c = 0; c < 256; c++) {
+        aa_gamma_[c] = (uint8_t)lroundf(255.0f * powf(c / 255.0f, 1.0f / AA_GAMMA));
+    }
     
     ft_initialized_ = initFreeType();
     if (!ft_initialized_) {
@@ -38,6 +60,40 @@ TextRenderer::~TextRenderer() {
     }
 }
 
+// Every frame is composed in the shadow frame and copied to the display's
+// back buffer in one blit when presented, so the frame always holds what
+// was last presented without reading back
+void TextRenderer::setPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    frame_.setPixel(x, y, r, g, b);
+}
+
+void TextRenderer::fill(uint8_t r, uint8_t g, uint8_t b) {
+    frame_.fill(r, g, b);
+}
+
+void TextRenderer::present() {
+    display_->blit(frame_);
+    display_->present(frame_);
+    metrics().frames_rendered.inc();
+    if (preview_) {
+        preview_->publish(frame_);
+    }
+}
+
+// Blank the display and the shadow frame so nothing of the previous content
+// lingers (the next present overwrites the whole back buffer)
+void TextRenderer::clearBuffers() {
+    fill(0, 0, 0);
+    display_->blit(frame_);
+    display_->present(frame_);
+}
+
+void TextRenderer::clearDisplay() {
+    display_->clear();
+    clearBuffers();
+    sm_->markAllDirty();
+}
+
 bool TextRenderer::initFreeType() {
     if (FT_Init_FreeType(&ft_library_)) {
         return false;
@@ -54,31 +110,58 @@ bool TextRenderer::initFreeType() {
     return true;
 }
 
+void TextRenderer::setRenderTiles(int tiles) {
+    if (tiles <= 0) {
+        // One band per core, less the one the panel refresh keeps busy
+        int cores = (int)std::thread::hardware_concurrency();
+        tiles = frame_.pixelCount() >= RENDER_TILE_MIN_PIXELS ? std::min(cores - 1, RENDER_TILES_MAX) : 1;
+    }
+    tiles = std::max(1, std::min(tiles, frame_.height));
+    
+    tile_pool_.reset();
+    bands_.clear();
+    if (tiles == 1) {
+        std::cout << "[RENDER] Composing on the render thread" << std::endl;
+        return;
+    }
+    
+    bands_.resize(tiles);
+    for (int i = 0; i < tiles; i++) {
+        bands_[i].rows = {i * frame_.height / tiles, (i + 1) * frame_.height / tiles};
+    }
+    tile_pool_.reset(new TilePool(tiles - 1));
+    std::cout << "[RENDER] Composing " << frame_.width << "×" << frame_.height << " in "
+             << tiles << " bands on " << tile_pool_->threads() << " threads" << std::endl;
+}
+
+// File a font name resolves to (Arial is replaced by DejaVu Sans if missing)
+const char* TextRenderer::fontPath(const std::string& font_name) {
+    const char* font_path = FONT_PATH;
+    if (font_name == "monospace" || font_name == "mono") {
+        font_path = FONT_MONO_PATH;
+    }
+    if (access(font_path, R_OK) != 0) {
+        font_path = FONT_PATH_FALLBACK;
+    }
+    return font_path;
+}
+
 FT_Face TextRenderer::loadFont(const std::string& font_name, int size) {
     // Check cache first
     FontCacheKey key = {font_name, size};
     auto it = font_cache_.find(key);
     if (it != font_cache_.end()) {
+        metrics().font_cache_hits.inc();
         return it->second;
     }
-    
-    // Determine font path
-    const char* font_path;
-    if (font_name == "monospace" || font_name == "mono") {
-        font_path = FONT_MONO_PATH;
-    } else {
-        // Default to Arial
-        font_path = FONT_PATH;
-    }
+    metrics().font_cache_misses.inc();
     
     // Load new face at this size
+    const char* font_path = fontPath(font_name);
     FT_Face face;
     if (FT_New_Face(ft_library_, font_path, 0, &face)) {
-        // Fallback to DejaVu Sans
-        if (FT_New_Face(ft_library_, FONT_PATH_FALLBACK, 0, &face)) {
-            std::cerr << "[RENDER] Failed to load font: " << font_path << std::endl;
-            return nullptr;
-        }
+        std::cerr << "[RENDER] Failed to load font: " << font_path << std::endl;
+        return nullptr;
     }
     
     FT_Set_Pixel_Sizes(face, 0, size);
@@ -86,30 +169,55 @@ FT_Face TextRenderer::loadFont(const std::string& font_name, int size) {
     return face;
 }
 
+// Rendered glyph from the glyph cache; FreeType only runs on a miss
+const Glyph* TextRenderer::glyph(const std::string& font_name, int size, char c) {
+    auto it = font_hashes_.find(font_name);
+    if (it == font_hashes_.end()) {
+        it = font_hashes_.emplace(font_name, hashFile(fontPath(font_name))).first;
+    }
+    uint64_t font_hash = it->second;
+    uint32_t code = (uint32_t)(FT_ULong)c;  // As FT_Load_Char sees it
+    
+    if (const Glyph* g = glyphs_.find(font_hash, size, code)) {
+        metrics().glyph_cache_hits.inc();
+        return g;
+    }
+    metrics().glyph_cache_misses.inc();
+    
+    FT_Face face = loadFont(font_name, size);
+    if (!face) {
+        return nullptr;
+    }
+    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+        // Cached as an empty glyph, so FreeType is not asked again
+        return glyphs_.insert(font_hash, size, code, 0, 0, 0, 0, 0, nullptr, 0);
+    }
+    FT_GlyphSlot slot = face->glyph;
+    return glyphs_.insert(font_hash, size, code, slot->advance.x >> 6, slot->bitmap_left, slot->bitmap_top,
+                          slot->bitmap.width, slot->bitmap.rows, slot->bitmap.buffer, slot->bitmap.pitch);
+}
+
 TextRenderer::TextMeasurement TextRenderer::measureText(const std::string& text, const std::string& font_name, int font_size) {
     // Check cache
     auto key = std::make_pair(text + ":" + font_name, font_size);
     auto it = text_measurement_cache_.find(key);
     if (it != text_measurement_cache_.end()) {
+        metrics().measure_cache_hits.inc();
         return it->second;
     }
+    metrics().measure_cache_misses.inc();
     
     // Measure text
-    FT_Face face = loadFont(font_name, font_size);
-    if (!face) {
-        return {0, 0};
-    }
-    
     int total_width = 0;
     int max_height = 0;
     
     for (char c : text) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+        const Glyph* g = glyph(font_name, font_size, c);
+        if (!g) {
             continue;
         }
-        total_width += face->glyph->advance.x >> 6;
-        int h = face->glyph->bitmap.rows;
-        if (h > max_height) max_height = h;
+        total_width += g->advance;
+        if (g->rows > max_height) max_height = g->rows;
     }
     
     TextMeasurement result = {total_width, max_height};
@@ -117,27 +225,112 @@ TextRenderer::TextMeasurement TextRenderer::measureText(const std::string& text,
     return result;
 }
 
-std::pair<int, TextRenderer::TextMeasurement> TextRenderer::fitText(const std::string& text, const std::string& font_name, int max_w, int max_h) {
+TextRenderer::TextFit TextRenderer::fitText(const std::string& text, const std::string& font_name, int max_w, int max_h) {
+    TRACE_SPAN("fitText");
+    // Tallest bitmap font that fits and has every character
+    auto fitBitmap = [&](TextFit& fit) {
+        for (const BdfFont& font : bdf_fonts_) {
+            if (font.height() > max_h || !font.covers(text)) continue;
+            int width = font.textWidth(text);
+            if (width <= max_w) {
+                fit = {font.height(), {width, font.height()}, &font};
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    TextFit fit = {0, {0, 0}, nullptr};
+    if (font_name == "bitmap" && fitBitmap(fit)) {
+        return fit;
+    }
+    
     for (int i = 0; i < FONT_SIZES_COUNT; i++) {
         int size = FONT_SIZES[i];
         TextMeasurement meas = measureText(text, font_name, size);
         
         if (meas.width <= max_w && meas.height <= max_h) {
-            return {size, meas};
+            fit = {size, meas, nullptr};
+            break;
         }
     }
     
+    if (fit.size >= BDF_AUTO_BELOW_PX) {
+        return fit;
+    }
+    // Small text: a bitmap font at its own size beats a tiny outline font
+    if (font_name != "bitmap" && fitBitmap(fit)) {
+        return fit;
+    }
+    if (fit.size > 0) {
+        return fit;
+    }
+    
     // Fallback to smallest
     int size = FONT_SIZES[FONT_SIZES_COUNT - 1];
-    return {size, measureText(text, font_name, size)};
+    return {size, measureText(text, font_name, size), nullptr};
+}
+
+int TextRenderer::loadBitmapFonts(const std::string& dir) {
+    bdf_fonts_ = loadBdfFonts(dir);
+    if (!bdf_fonts_.empty()) {
+        std::cout << "[RENDER] " << bdf_fonts_.size() << " bitmap fonts from " << dir << " ("
+                 << bdf_fonts_.back().height() << "-" << bdf_fonts_.front().height() << " px)" << std::endl;
+    }
+    return (int)bdf_fonts_.size();
+}
+
+void TextRenderer::setTestPattern(TestPattern pattern) {
+    if (pattern == test_pattern_.pattern()) return;
+    
+    bool leaving = (pattern == PATTERN_NONE);
+    test_pattern_.setPattern(pattern);
+    if (leaving) {
+        // Nothing of the pattern may survive in either buffer
+        clearBuffers();
+        sm_->markAllDirty();
+    }
+    std::cout << "[TEST] Pattern: " << testPatternName(pattern) << std::endl;
 }
 
 void TextRenderer::renderAll() {
-    // Get snapshot
+    TRACE_SPAN("renderAll");
+    ScopedTimer frame_timer;
+    
+    if (test_pattern_.pattern() != PATTERN_NONE) {
+        renderTestPattern();
+        metrics().render_frame.observe(frame_timer.elapsedUs());
+        return;
+    }
+    
+    // Pixel stream frames take over the whole canvas while the stream is active
+    if (stream_) {
+        if (stream_->isActive()) {
+            if (stream_->consumeDirty() || !stream_was_active_) {
+                stream_was_active_ = true;
+                renderStream();
+                metrics().render_frame.observe(frame_timer.elapsedUs());
+            } else {
+                metrics().frames_skipped.inc();
+            }
+            return;
+        }
+        if (stream_was_active_) {
+            // Stream ended - blank both buffers so no stream pixels linger, then repaint segments
+            stream_was_active_ = false;
+            clearBuffers();
+            sm_->markAllDirty();
+        }
+    }
+    
+    // Get snapshot (and the command this frame is the first to show, if any)
     bool any_dirty;
-    std::vector<Segment> snapshots = sm_->getRenderSnapshot(any_dirty);
+    PacketStamp stamp;
+    uint64_t render_ns = traceNowNs();
+    std::vector<Segment> snapshots = sm_->getRenderSnapshot(any_dirty, &stamp);
     
     if (!any_dirty) {
+        metrics().frames_skipped.inc();
         return;
     }
     
@@ -146,53 +339,85 @@ void TextRenderer::renderAll() {
         Orientation orient = g_udp_handler->getOrientation();
         int current_layout = g_udp_handler->getCurrentLayout();
         
-        // Check if orientation changed
+        // Check if orientation changed (the canvas itself follows the
+        // rotation the display was created with)
         if (orient != current_orientation_) {
             current_orientation_ = orient;
-            if (orient == PORTRAIT) {
-                canvas_width_ = MATRIX_HEIGHT;
-                canvas_height_ = MATRIX_WIDTH;
-            } else {
-                canvas_width_ = MATRIX_WIDTH;
-                canvas_height_ = MATRIX_HEIGHT;
-            }
-            std::cout << "[RENDER] Canvas resized to " << canvas_width_ << "×" 
-                     << canvas_height_ << " for " 
-                     << (orient == PORTRAIT ? "portrait" : "landscape") << " mode" << std::endl;
+            std::cout << "[RENDER] Orientation " << (orient == PORTRAIT ? "portrait" : "landscape")
+                     << " on the " << frame_.width << "×" << frame_.height << " canvas" << std::endl;
             
             // Full clear needed when orientation changes
-            canvas_->Fill(0, 0, 0);
+            fill(0, 0, 0);
         }
         // Check if layout changed
         else if (current_layout != last_layout_) {
             last_layout_ = current_layout;
             // Full clear needed when layout changes to remove old segments
-            canvas_->Fill(0, 0, 0);
+            fill(0, 0, 0);
             std::cout << "[RENDER] Layout changed to " << current_layout << " - canvas cleared" << std::endl;
         }
         // Otherwise: NO full clear - segments fill their own backgrounds
     }
     
     // Render all segments that are in the current layout
-    int rendered_count = 0;
-    for (const auto& seg : snapshots) {
+    drawn_.clear();
+    for (auto& seg : snapshots) {
         if (!seg.is_active) continue;
         
         // Skip segments not in current layout (1x1 dummy rects)
         if (seg.width <= 1 || seg.height <= 1) continue;
         
-        renderSegment(seg);
-        rendered_count++;
+        // On a wall, only segments reaching into this node's viewport
+        seg.x -= viewport_x_;
+        seg.y -= viewport_y_;
+        if (seg.x >= frame_.width || seg.y >= frame_.height ||
+            seg.x + seg.width <= 0 || seg.y + seg.height <= 0) continue;
+        
+        drawn_.push_back(&seg);
+    }
+    int rendered_count = (int)drawn_.size();
+    if (placements_.size() < drawn_.size()) {
+        placements_.resize(drawn_.size());
+    }
+    
+    if (tile_pool_) {
+        // Text is placed here (the font caches belong to this thread), then
+        // every band composes all segments over its own rows
+        for (size_t i = 0; i < drawn_.size(); i++) {
+            placeText(*drawn_[i], placements_[i]);
+        }
+        tile_pool_->run((int)bands_.size(), [this](int tile) {
+            TRACE_SPAN("composeBand");
+            ScopedTimer band_timer;
+            for (size_t i = 0; i < drawn_.size(); i++) {
+                composeSegment(*drawn_[i], placements_[i], bands_[tile]);
+            }
+            metrics().render_band.observe(band_timer.elapsedUs());
+        });
+    } else {
+        for (size_t i = 0; i < drawn_.size(); i++) {
+            ScopedTimer segment_timer;
+            renderSegment(*drawn_[i]);
+            metrics().render_segment.observe(segment_timer.elapsedUs());
+        }
     }
     
     // Render group indicator
     renderGroupIndicator();
     
     // Swap canvas
-    canvas_ = matrix_->SwapOnVSync(canvas_);
+    present();
+    
+    if (stamp.rx_ns) {
+        uint64_t swap_ns = traceNowNs();
+        metrics().latency_dispatch_render.observe((render_ns - std::min(render_ns, stamp.dispatched_ns)) / 1000);
+        metrics().latency_render_swap.observe((swap_ns - render_ns) / 1000);
+        metrics().latency_packet_photon.observe((swap_ns - std::min(swap_ns, stamp.rx_ns)) / 1000);
+    }
     
     // Clear dirty flags
     sm_->clearDirtyFlags();
+    metrics().render_frame.observe(frame_timer.elapsedUs());
     
     // Logging (throttled)
     render_count_++;
@@ -202,31 +427,55 @@ void TextRenderer::renderAll() {
     }
 }
 
-void TextRenderer::renderSegment(const Segment& seg) {
-    // Skip background fill if bgcolor is (1,1,1) - transparent marker for test mode
-    bool skip_background = (seg.bgcolor.r == 1 && seg.bgcolor.g == 1 && seg.bgcolor.b == 1);
+// Pattern and segment text are composed in frame_ and presented in one swap
+void TextRenderer::renderTestPattern() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    uint64_t t_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    test_pattern_.render(frame_, t_ms);
     
-    if (!skip_background) {
-        // Fill background
-        for (int y = seg.y; y < seg.y + seg.height; y++) {
-            for (int x = seg.x; x < seg.x + seg.width; x++) {
-                canvas_->SetPixel(x, y, seg.bgcolor.r, seg.bgcolor.g, seg.bgcolor.b);
-            }
-        }
+    bool any_dirty;
+    std::vector<Segment> snapshots = sm_->getRenderSnapshot(any_dirty);
+    for (const auto& seg : snapshots) {
+        if (!seg.is_active || seg.width <= 1 || seg.height <= 1) continue;
+        renderSegment(seg);
     }
     
+    present();
+    sm_->clearDirtyFlags();
+}
+
+void TextRenderer::renderStream() {
+    // Frames that don't cover the canvas (or on a wall, the viewport) are
+    // clipped / padded with black
+    if (!stream_->copyViewport(frame_, viewport_x_, viewport_y_)) {
+        return;
+    }
+    
+    renderGroupIndicator();
+    present();
+    render_count_++;
+}
+
+// Draw one segment over the whole canvas (test pattern layer, benchmarks)
+void TextRenderer::renderSegment(const Segment& seg) {
+    TRACE_SPAN("renderSegment");
+    placeText(seg, placements_[0]);
+    composeSegment(seg, placements_[0], canvas_band_);
+}
+
+// Everything in drawing a segment that touches the font caches: fit the
+// text, position it and look up its glyphs. Runs on the render thread only;
+// composeSegment() then needs nothing but the placement.
+void TextRenderer::placeText(const Segment& seg, TextPlacement& p) {
+    p.draw_text = false;
+    p.glyphs.clear();
     if (seg.text.empty()) {
-        if (seg.frame_enabled) {
-            drawFrame(seg);
-        }
         return;
     }
     
-    // Handle blink effect
-    if (seg.effect == EFFECT_BLINK && !seg.blink_state) {
-        if (seg.frame_enabled) {
-            drawFrame(seg);
-        }
+    // Handle blink effect (and a fade at fully transparent)
+    bool fading = seg.effect == EFFECT_FADE && seg.fade_alpha < 255;
+    if ((seg.effect == EFFECT_BLINK && !seg.blink_state) || (fading && seg.fade_alpha == 0)) {
         return;
     }
     
@@ -234,11 +483,7 @@ void TextRenderer::renderSegment(const Segment& seg) {
     int avail_w = std::max(1, seg.width - 2);
     int avail_h = std::max(1, seg.height - 2);
     
-    auto [font_size, meas] = fitText(seg.text, seg.font_name, avail_w, avail_h);
-    FT_Face face = loadFont(seg.font_name, font_size);
-    if (!face) {
-        return;
-    }
+    auto [font_size, meas, bitmap] = fitText(seg.text, seg.font_name, avail_w, avail_h);
     
     // Calculate text position
     int tx, ty;
@@ -260,74 +505,146 @@ void TextRenderer::renderSegment(const Segment& seg) {
         tx = seg.x + seg.width - offset;
     }
     
-    // Render each character
-    int pen_x = tx;
-    int pen_y = ty + meas.height;  // Baseline
+    p.draw_text = true;
+    p.bitmap = bitmap;
+    p.alpha = fading ? seg.fade_alpha : 255;
+    p.x = tx;
+    if (bitmap) {
+        p.y = ty;
+        return;
+    }
+    p.y = ty + meas.height;  // Baseline
+    
+    // Glyph coverage → text alpha: thresholded at 128 for sharp edges, or
+    // gamma-corrected when anti-aliased; scaled by the fade either way
+    const uint8_t* fade = alphaLut().mul[p.alpha];
+    for (int c = 0; c < 256; c++) {
+        p.coverage_alpha[c] = seg.antialias ? fade[aa_gamma_[c]] : (c > 128 ? fade[255] : 0);
+    }
     
     for (char c : seg.text) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+        p.glyphs.push_back(glyph(seg.font_name, font_size, c));
+    }
+}
+
+// Background, text and frame of a placed segment, in the band's rows only
+void TextRenderer::composeSegment(const Segment& seg, const TextPlacement& p, Band& band) {
+    if (seg.y >= band.rows.y1 || seg.y + seg.height <= band.rows.y0) {
+        return;
+    }
+    
+    // Skip background fill if bgcolor is (1,1,1) - transparent marker for test mode
+    bool skip_background = (seg.bgcolor.r == 1 && seg.bgcolor.g == 1 && seg.bgcolor.b == 1);
+    
+    if (!skip_background) {
+        kernels_->fill_rect(frame_, band.rows, seg.x, seg.y, seg.width, seg.height,
+                            seg.bgcolor.r, seg.bgcolor.g, seg.bgcolor.b);
+    }
+    
+    if (p.draw_text) {
+        if (p.bitmap) {
+            drawBitmapText(seg, p, band.rows);
+        } else {
+            drawText(seg, p, band);
+        }
+    }
+    
+    // Draw frame if enabled
+    if (seg.frame_enabled) {
+        drawFrame(seg, band.rows);
+    }
+}
+
+// TrueType glyphs, pen starting on the baseline at (p.x, p.y)
+void TextRenderer::drawText(const Segment& seg, const TextPlacement& p, Band& band) {
+    // Clip to segment bounds (and the band)
+    int clip_x0 = std::max(seg.x, 0);
+    int clip_y0 = std::max(seg.y, band.rows.y0);
+    int clip_x1 = std::min(seg.x + seg.width, frame_.width);
+    int clip_y1 = std::min(seg.y + seg.height, band.rows.y1);
+    
+    // Render each character
+    int pen_x = p.x;
+    int pen_y = p.y;
+    
+    for (const Glyph* g : p.glyphs) {
+        if (!g) {
             continue;
         }
         
-        FT_GlyphSlot slot = face->glyph;
-        FT_Bitmap& bitmap = slot->bitmap;
+        int glyph_x = pen_x + g->left;
+        int glyph_y = pen_y - g->top;
+        int x0 = std::max(glyph_x, clip_x0);
+        int x1 = std::min(glyph_x + g->width, clip_x1);
+        int n = x1 - x0;
         
-        int glyph_x = pen_x + slot->bitmap_left;
-        int glyph_y = pen_y - slot->bitmap_top;
+        // Blend each clipped glyph row over what is beneath it (the
+        // background, or the pattern under a transparent one) in frame_
+        for (int by = 0; by < g->rows && n > 0; by++) {
+            int py = glyph_y + by;
+            if (py < clip_y0 || py >= clip_y1) {
+                continue;
+            }
+            
+            const uint8_t* coverage = g->coverage + by * g->width + (x0 - glyph_x);
+            band.span_alpha.resize(n);
+            for (int i = 0; i < n; i++) {
+                band.span_alpha[i] = p.coverage_alpha[coverage[i]];
+            }
+            
+            blendSpan(frame_.row(py) + x0 * 3, band.span_alpha.data(), n, seg.color.r, seg.color.g, seg.color.b);
+        }
         
-        // Render glyph with binary threshold (sharp rendering)
-        for (unsigned int by = 0; by < bitmap.rows; by++) {
-            for (unsigned int bx = 0; bx < bitmap.width; bx++) {
+        pen_x += g->advance;
+    }
+}
+
+// Bitmap font text with its line top at p.y: one shift and test per lit pixel
+void TextRenderer::drawBitmapText(const Segment& seg, const TextPlacement& p, const RowBand& rows) {
+    const BdfFont& font = *p.bitmap;
+    int clip_x0 = std::max(seg.x, 0);
+    int clip_y0 = std::max(seg.y, rows.y0);
+    int clip_x1 = std::min(seg.x + seg.width, frame_.width);
+    int clip_y1 = std::min(seg.y + seg.height, rows.y1);
+    
+    int pen_x = p.x;
+    int baseline = p.y + font.ascent();
+    for (char c : seg.text) {
+        const BdfGlyph* g = font.glyph(c);
+        if (!g) {
+            continue;
+        }
+        
+        int glyph_x = pen_x + g->left;
+        int glyph_y = baseline - g->top;
+        for (size_t row = 0; row < g->rows.size(); row++) {
+            int py = glyph_y + (int)row;
+            if (py < clip_y0 || py >= clip_y1) {
+                continue;
+            }
+            
+            uint32_t bits = g->rows[row];
+            while (bits) {
+                int bx = __builtin_clz(bits);
+                bits &= ~(0x80000000u >> bx);
                 int px = glyph_x + bx;
-                int py = glyph_y + by;
-                
-                // Clip to segment bounds
-                if (px < seg.x || px >= seg.x + seg.width ||
-                    py < seg.y || py >= seg.y + seg.height) {
+                if (px < clip_x0 || px >= clip_x1) {
                     continue;
                 }
-                
-                unsigned char gray = bitmap.buffer[by * bitmap.width + bx];
-                
-                // Binary threshold at 128 for sharp edges
-                if (gray > 128) {
-                    canvas_->SetPixel(px, py, seg.color.r, seg.color.g, seg.color.b);
+                if (p.alpha == 255) {
+                    setPixel(px, py, seg.color.r, seg.color.g, seg.color.b);
+                } else {
+                    blendSpan(frame_.row(py) + px * 3, &p.alpha, 1, seg.color.r, seg.color.g, seg.color.b);
                 }
             }
         }
-        
-        pen_x += slot->advance.x >> 6;
-    }
-    
-    // Draw frame if enabled
-    if (seg.frame_enabled) {
-        drawFrame(seg);
+        pen_x += g->advance;
     }
 }
 
-void TextRenderer::drawFrame(const Segment& seg) {
-    for (int offset = 0; offset < seg.frame_width; offset++) {
-        // Top edge
-        for (int x = seg.x + offset; x <= seg.x + seg.width - 1 - offset; x++) {
-            canvas_->SetPixel(x, seg.y + offset, 
-                            seg.frame_color.r, seg.frame_color.g, seg.frame_color.b);
-        }
-        // Bottom edge
-        for (int x = seg.x + offset; x <= seg.x + seg.width - 1 - offset; x++) {
-            canvas_->SetPixel(x, seg.y + seg.height - 1 - offset,
-                            seg.frame_color.r, seg.frame_color.g, seg.frame_color.b);
-        }
-        // Left edge
-        for (int y = seg.y + offset; y <= seg.y + seg.height - 1 - offset; y++) {
-            canvas_->SetPixel(seg.x + offset, y,
-                            seg.frame_color.r, seg.frame_color.g, seg.frame_color.b);
-        }
-        // Right edge
-        for (int y = seg.y + offset; y <= seg.y + seg.height - 1 - offset; y++) {
-            canvas_->SetPixel(seg.x + seg.width - 1 - offset, y,
-                            seg.frame_color.r, seg.frame_color.g, seg.frame_color.b);
-        }
-    }
+void TextRenderer::drawFrame(const Segment& seg, const RowBand& rows) {
+    kernels_->frame_rect(frame_, rows, seg.x, seg.y, seg.width, seg.height, seg.frame_width,
+                         seg.frame_color.r, seg.frame_color.g, seg.frame_color.b);
 }
 
 void TextRenderer::renderGroupIndicator() {
@@ -350,15 +667,7 @@ void TextRenderer::renderGroupIndicator() {
     }
     
     // Draw colored square in bottom-left corner
-    int x1 = 0;
-    int y1 = canvas_height_ - GROUP_INDICATOR_SIZE;
-    int x2 = GROUP_INDICATOR_SIZE - 1;
-    int y2 = canvas_height_ - 1;
-    
-    for (int y = y1; y <= y2; y++) {
-        for (int x = x1; x <= x2; x++) {
-            canvas_->SetPixel(x, y, group_color_cache_.r, 
-                            group_color_cache_.g, group_color_cache_.b);
-        }
-    }
+    kernels_->fill_rect(frame_, canvas_band_.rows, 0, frame_.height - GROUP_INDICATOR_SIZE,
+                        GROUP_INDICATOR_SIZE, GROUP_INDICATOR_SIZE,
+                        group_color_cache_.r, group_color_cache_.g, group_color_cache_.b);
 }
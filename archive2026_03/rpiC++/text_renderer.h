@@ -6,40 +6,103 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <map>
+#include <memory>
 #include <string>
-#include "led-matrix.h"
-#include "graphics.h"
+#include <vector>
 #include "segment_manager.h"
+#include "display_backend.h"
+#include "framebuffer.h"
+#include "test_pattern.h"
+#include "glyph_cache.h"
+#include "bdf_font.h"
+#include "kernels.h"
+#include "tile_pool.h"
 
-using rgb_matrix::Canvas;
-using rgb_matrix::RGBMatrix;
-using rgb_matrix::FrameCanvas;
+class PixelStream;
+class FrameMailbox;
 
 class TextRenderer {
 public:
-    TextRenderer(RGBMatrix* matrix, SegmentManager* segment_manager);
+    TextRenderer(DisplayBackend* display, SegmentManager* segment_manager,
+                 PixelStream* pixel_stream = nullptr);
     ~TextRenderer();
     
     void renderAll();
     
+    // Blank the display and both buffers; segments repaint on the next frame
+    void clearDisplay();
+    
+    // Each presented frame is also published here (web preview)
+    void setPreview(FrameMailbox* mailbox) { preview_ = mailbox; }
+    
+    // Test mode: the pattern replaces the background, active segments draw
+    // on top of it. PATTERN_NONE returns to normal rendering.
+    void setTestPattern(TestPattern pattern);
+    
+    // Keep rendered glyphs in `path` across restarts (in memory otherwise)
+    bool openGlyphCache(const std::string& path) { return glyphs_.open(path); }
+    
+    // Bitmap fonts for small text (font "bitmap", or picked by fitText)
+    int loadBitmapFonts(const std::string& dir);
+    
+    // Compose frames in this many horizontal bands at once (1 = on the
+    // render thread; 0 = one per spare core on canvases of at least
+    // RENDER_TILE_MIN_PIXELS). Output is the same either way.
+    void setRenderTiles(int tiles);
+    
+    // Video wall: this display shows the part of the virtual canvas whose
+    // top-left corner is (x, y); segments and stream frames are in virtual
+    // canvas coordinates
+    void setViewport(int x, int y) { viewport_x_ = x; viewport_y_ = y; }
+    
 private:
-    RGBMatrix* matrix_;
-    FrameCanvas* canvas_;
+    friend struct BenchAccess;  // bench.cpp times the private hot paths
+    
+    DisplayBackend* display_;
     SegmentManager* sm_;
+    PixelStream* stream_;
+    bool stream_was_active_;
+    Framebuffer frame_;       // Shadow of the canvas contents
+    const RenderKernels* kernels_;  // Specialized on frame_'s size, picked at construction
+    FrameMailbox* preview_;
+    TestPatternGenerator test_pattern_;
     
     FT_Library ft_library_;
     FT_Face ft_face_;
     bool ft_initialized_;
     
     Orientation current_orientation_;
-    int canvas_width_;
-    int canvas_height_;
     int last_layout_;  // Track layout changes to know when to clear
     
     uint8_t group_id_cache_;
     Color group_color_cache_;
     
     int render_count_;
+    int viewport_x_, viewport_y_;
+    
+    uint8_t aa_gamma_[256];              // Glyph coverage → alpha for anti-aliased text
+    
+    // A segment's text fitted, positioned and its glyphs looked up
+    struct TextPlacement {
+        bool draw_text;                  // False: background and frame only
+        const BdfFont* bitmap;
+        int x, y;                        // Pen start: line top (bitmap) or baseline
+        uint8_t alpha;                   // Fade
+        uint8_t coverage_alpha[256];     // Glyph coverage → text alpha
+        std::vector<const Glyph*> glyphs;  // Per character, null if it has none
+    };
+    
+    // Rows of frame_ one thread composes, and that thread's scratch
+    struct Band {
+        RowBand rows;
+        std::vector<uint8_t> span_alpha;  // Alpha of one clipped glyph row
+    };
+    
+    Band canvas_band_;                      // The whole canvas
+    std::vector<Band> bands_;               // With a tile pool
+    std::unique_ptr<TilePool> tile_pool_;   // Null: compose on the render thread
+    std::vector<const Segment*> drawn_;     // This frame's segments ...
+    std::vector<TextPlacement> placements_; // ... and their text
     
     struct FontCacheKey {
         std::string font_name;
@@ -51,20 +114,44 @@ private:
     };
     std::map<FontCacheKey, FT_Face> font_cache_;
     
+    GlyphCache glyphs_;
+    std::map<std::string, uint64_t> font_hashes_;  // Font name → hash of the file it loads
+    
     struct TextMeasurement {
         int width;
         int height;
     };
     std::map<std::pair<std::string, int>, TextMeasurement> text_measurement_cache_;
     
+    std::vector<BdfFont> bdf_fonts_;  // Tallest first
+    
+    struct TextFit {
+        int size;               // TrueType pixel size, or the bitmap font's height
+        TextMeasurement meas;
+        const BdfFont* bitmap;  // Set when a bitmap font was picked
+    };
+    
     bool initFreeType();
+    const char* fontPath(const std::string& font_name);
     FT_Face loadFont(const std::string& font_name, int size);
+    const Glyph* glyph(const std::string& font_name, int size, char c);
     TextMeasurement measureText(const std::string& text, const std::string& font_name, int font_size);
-    std::pair<int, TextMeasurement> fitText(const std::string& text, const std::string& font_name, int max_w, int max_h);
+    TextFit fitText(const std::string& text, const std::string& font_name, int max_w, int max_h);
+    
+    void setPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b);
+    void fill(uint8_t r, uint8_t g, uint8_t b);
+    void present();
+    void clearBuffers();
+    void renderTestPattern();
     
+    void renderStream();
     void renderSegment(const Segment& seg);
+    void placeText(const Segment& seg, TextPlacement& p);
+    void composeSegment(const Segment& seg, const TextPlacement& p, Band& band);
     void renderGroupIndicator();
-    void drawFrame(const Segment& seg);
+    void drawText(const Segment& seg, const TextPlacement& p, Band& band);
+    void drawBitmapText(const Segment& seg, const TextPlacement& p, const RowBand& rows);
+    void drawFrame(const Segment& seg, const RowBand& rows);
 };
 
 #endif // TEXT_RENDERER_H
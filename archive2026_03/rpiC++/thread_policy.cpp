@@ -0,0 +1,224 @@
+// thread_policy.cpp - Thread affinity, scheduling class and memory locking
+
+#include "thread_policy.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct ThreadPolicy {
+    std::vector<int> cpus;  // Empty = any
+    int sched;              // SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int priority;
+};
+
+struct AppliedPolicy {
+    std::string thread;
+    std::string role;
+    std::string cpus;
+    std::string sched;
+    int priority;
+    bool ok;
+};
+
+std::mutex g_mutex;
+std::map<std::string, ThreadPolicy> g_policies;
+std::vector<AppliedPolicy> g_applied;
+bool g_mlock_requested = false;
+bool g_mlock_ok = false;
+
+const char* schedName(int sched) {
+    switch (sched) {
+        case SCHED_FIFO: return "fifo";
+        case SCHED_RR:   return "rr";
+        default:         return "other";
+    }
+}
+
+std::string cpuList(const std::vector<int>& cpus) {
+    if (cpus.empty()) return "all";
+    std::string out;
+    for (int cpu : cpus) {
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpu);
+    }
+    return out;
+}
+
+}  // namespace
+
+void loadThreadPolicies(const char* config_path) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    json config;
+    try {
+        std::ifstream file(config_path);
+        if (!file.is_open()) return;
+        file >> config;
+    } catch (const json::exception& e) {
+        std::cerr << "[SCHED] Could not read " << config_path << ": " << e.what() << std::endl;
+        return;
+    }
+
+    int max_rt_priority = 0;
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+
+    if (config.contains("threads") && config["threads"].is_object()) {
+        for (auto& entry : config["threads"].items()) {
+            const json& spec = entry.value();
+            ThreadPolicy policy;
+            policy.sched = SCHED_OTHER;
+            policy.priority = 0;
+
+            try {
+                for (int cpu : spec.value("cpus", std::vector<int>())) {
+                    if (cpu >= 0 && cpu < ncpus) {
+                        policy.cpus.push_back(cpu);
+                    } else {
+                        std::cerr << "[SCHED] " << entry.key() << ": no CPU " << cpu << std::endl;
+                    }
+                }
+                std::string sched = spec.value("sched", "other");
+                if (sched == "fifo") policy.sched = SCHED_FIFO;
+                else if (sched == "rr") policy.sched = SCHED_RR;
+                if (policy.sched != SCHED_OTHER) {
+                    int lo = sched_get_priority_min(policy.sched);
+                    int hi = sched_get_priority_max(policy.sched);
+                    policy.priority = std::max(lo, std::min(hi, spec.value("priority", lo)));
+                    max_rt_priority = std::max(max_rt_priority, policy.priority);
+                }
+            } catch (const json::exception& e) {
+                std::cerr << "[SCHED] Bad policy for " << entry.key() << ": " << e.what() << std::endl;
+                continue;
+            }
+            g_policies[entry.key()] = policy;
+        }
+    }
+    g_mlock_requested = config.value("mlockall", false);
+
+    // Unprivileged threads may use SCHED_FIFO / mlock within these limits
+    if (max_rt_priority > 0) {
+        struct rlimit rl = {(rlim_t)max_rt_priority, (rlim_t)max_rt_priority};
+        if (setrlimit(RLIMIT_RTPRIO, &rl) < 0) {
+            std::cerr << "[SCHED] Could not raise RLIMIT_RTPRIO: " << strerror(errno) << std::endl;
+        }
+    }
+    if (g_mlock_requested) {
+        struct rlimit rl = {RLIM_INFINITY, RLIM_INFINITY};
+        if (setrlimit(RLIMIT_MEMLOCK, &rl) < 0) {
+            std::cerr << "[SCHED] Could not raise RLIMIT_MEMLOCK: " << strerror(errno) << std::endl;
+        }
+    }
+
+    if (!g_policies.empty()) {
+        std::cout << "[SCHED] Loaded " << g_policies.size() << " thread policies" << std::endl;
+    }
+}
+
+static bool applyPolicy(const ThreadPolicy& policy, const std::string& thread_name) {
+    pthread_t self = pthread_self();
+    bool ok = true;
+    if (!policy.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : policy.cpus) {
+            CPU_SET(cpu, &set);
+        }
+        int err = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (err != 0) {
+            std::cerr << "[SCHED] " << thread_name << ": affinity failed: " << strerror(err) << std::endl;
+            ok = false;
+        }
+    }
+
+    struct sched_param param;
+    param.sched_priority = policy.priority;
+    int err = pthread_setschedparam(self, policy.sched, &param);
+    if (err != 0) {
+        std::cerr << "[SCHED] " << thread_name << ": " << schedName(policy.sched)
+                 << " priority " << policy.priority << " failed: " << strerror(err) << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// What the calling thread is actually running with
+static void currentPolicy(std::vector<int>& cpus, int& sched, int& priority) {
+    cpus.clear();
+    cpu_set_t set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+        for (int cpu = 0; cpu < ncpus; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+        if ((long)cpus.size() == ncpus) cpus.clear();
+    }
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &sched, &param) != 0) {
+        sched = SCHED_OTHER;
+        param.sched_priority = 0;
+    }
+    priority = param.sched_priority;
+}
+
+void applyThreadPolicy(const char* role, const std::string& thread_name) {
+    pthread_setname_np(pthread_self(), thread_name.substr(0, 15).c_str());  // Kernel limit: 15 chars
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    bool ok = true;
+    auto it = g_policies.find(role);
+    if (it != g_policies.end()) {
+        const ThreadPolicy& policy = it->second;
+        ok = applyPolicy(policy, thread_name);
+        std::cout << "[SCHED] " << thread_name << " → cpus " << cpuList(policy.cpus) << ", "
+                 << schedName(policy.sched) << "/" << policy.priority << (ok ? "" : " (failed)") << std::endl;
+    }
+
+    // Report what the thread ended up with, configured or inherited
+    std::vector<int> cpus;
+    int sched, priority;
+    currentPolicy(cpus, sched, priority);
+    g_applied.push_back({thread_name, role, cpuList(cpus), schedName(sched), priority, ok});
+}
+
+void lockMemory() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_mlock_requested) return;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        g_mlock_ok = true;
+        std::cout << "[SCHED] Memory locked (mlockall)" << std::endl;
+    } else {
+        std::cerr << "[SCHED] mlockall failed: " << strerror(errno) << std::endl;
+    }
+}
+
+std::string threadPolicyMetrics() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::string out;
+    out += "# HELP led_thread_policy Current CPU set and scheduling of each daemon thread (0 = configured policy failed)\n";
+    out += "# TYPE led_thread_policy gauge\n";
+    for (const AppliedPolicy& a : g_applied) {
+        out += "led_thread_policy{thread=\"" + a.thread + "\",role=\"" + a.role +
+               "\",cpus=\"" + a.cpus + "\",sched=\"" + a.sched +
+               "\",priority=\"" + std::to_string(a.priority) + "\"} " + (a.ok ? "1" : "0") + "\n";
+    }
+    out += "# HELP led_memory_locked Whether mlockall succeeded\n";
+    out += "# TYPE led_memory_locked gauge\n";
+    out += std::string("led_memory_locked ") + (g_mlock_ok ? "1" : "0") + "\n";
+    return out;
+}
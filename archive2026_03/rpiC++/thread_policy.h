@@ -0,0 +1,34 @@
+// thread_policy.h - Per-thread CPU affinity / scheduling from config.json
+//
+//   "threads": {
+//       "render": {"cpus": [2], "sched": "fifo", "priority": 40},
+//       "udp":    {"cpus": [0, 1], "sched": "fifo", "priority": 30},
+//       "web":    {"cpus": [0, 1]},
+//       "net":    {"cpus": [0, 1]},
+//       "tile":   {"cpus": [0, 1, 2]}
+//   },
+//   "mlockall": true
+//
+// Roles without an entry keep the default (inherited) policy. The LED
+// refresh thread belongs to the rgbmatrix library and is left alone, so
+// keeping our roles off its core (usually 3) is up to the config.
+
+#ifndef THREAD_POLICY_H
+#define THREAD_POLICY_H
+
+#include <string>
+
+// Read the config and, while still root, raise RLIMIT_RTPRIO / RLIMIT_MEMLOCK
+// so the policies can still be applied after the matrix drops privileges
+void loadThreadPolicies(const char* config_path);
+
+// Name the calling thread and apply the policy configured for `role`
+void applyThreadPolicy(const char* role, const std::string& thread_name);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE) if "mlockall" is set
+void lockMemory();
+
+// led_thread_policy / led_memory_locked series for /api/metrics
+std::string threadPolicyMetrics();
+
+#endif // THREAD_POLICY_H
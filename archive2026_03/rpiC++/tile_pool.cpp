@@ -0,0 +1,65 @@
+// tile_pool.cpp - Parallel band composition
+
+#include "tile_pool.h"
+#include "thread_policy.h"
+
+TilePool::TilePool(int workers)
+    : job_(nullptr), tiles_(0), next_(0), pending_(0), generation_(0), stopping_(false) {
+    for (int i = 0; i < workers; i++) {
+        workers_.emplace_back(&TilePool::workerLoop, this, i + 1);
+    }
+}
+
+TilePool::~TilePool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+void TilePool::run(int tiles, const std::function<void(int)>& fn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = &fn;
+    tiles_ = tiles;
+    next_ = 0;
+    pending_ = tiles;
+    generation_++;
+    start_cv_.notify_all();
+
+    // The caller composes bands too, then waits for the stragglers
+    composeTiles(lock);
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    job_ = nullptr;
+}
+
+// Take bands until none are left (mutex held on entry and exit)
+void TilePool::composeTiles(std::unique_lock<std::mutex>& lock) {
+    while (next_ < tiles_) {
+        int tile = next_++;
+        const std::function<void(int)>* job = job_;
+        lock.unlock();
+        (*job)(tile);
+        lock.lock();
+        if (--pending_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void TilePool::workerLoop(int index) {
+    applyThreadPolicy("tile", "led-tile-" + std::to_string(index));
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        start_cv_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+        if (stopping_) {
+            return;
+        }
+        seen = generation_;
+        composeTiles(lock);
+    }
+}
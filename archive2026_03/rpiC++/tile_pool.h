@@ -0,0 +1,48 @@
+// tile_pool.h - Threads that compose one frame in parallel bands
+//
+// A wall of chained panels has many times the pixels of one panel. The
+// renderer splits such a canvas into horizontal bands and composes them
+// at once: run(n, fn) calls fn(0) ... fn(n - 1), band 0 on the calling
+// thread and the rest on the workers, and returns when every band is
+// done - so the frame is whole before it is presented. Bands never share
+// a row, so they write the frame without locks.
+//
+// Workers take the "tile" thread policy (see thread_policy.h).
+
+#ifndef TILE_POOL_H
+#define TILE_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TilePool {
+public:
+    explicit TilePool(int workers);
+    ~TilePool();
+
+    // Threads that compose bands, the caller included
+    int threads() const { return (int)workers_.size() + 1; }
+
+    void run(int tiles, const std::function<void(int)>& fn);
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* job_;
+    int tiles_;
+    int next_;        // Next band to hand out
+    int pending_;     // Bands handed out or waiting, not yet finished
+    uint64_t generation_;
+    bool stopping_;
+
+    void workerLoop(int index);
+    void composeTiles(std::unique_lock<std::mutex>& lock);
+};
+
+#endif // TILE_POOL_H
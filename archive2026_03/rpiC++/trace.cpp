@@ -0,0 +1,154 @@
+// trace.cpp - Per-thread span rings and Chrome trace JSON output
+
+#include "trace.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <ctime>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS must be a power of two");
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+// Written only by the owning thread; fields are atomics so a concurrent
+// dump reads torn spans as stale ones instead of racing
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> begin_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+};
+
+struct TraceRing {
+    pthread_t thread;
+    int tid;
+    bool in_use;                   // Owning thread still running (registry mutex)
+    std::atomic<uint64_t> head{0}; // Spans ever recorded
+    TraceEvent events[TRACE_RING_EVENTS];
+};
+
+// Rings outlive their threads; a new thread takes over a released ring
+std::mutex g_rings_mutex;
+std::vector<TraceRing*> g_rings;
+std::atomic<uint64_t> g_session_ns{0};  // Spans older than this are discarded
+
+TraceRing* claimRing() {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    TraceRing* ring = nullptr;
+    for (TraceRing* r : g_rings) {
+        if (!r->in_use) {
+            ring = r;
+            break;
+        }
+    }
+    if (!ring) {
+        ring = new TraceRing();
+        g_rings.push_back(ring);
+    }
+    ring->thread = pthread_self();
+    ring->tid = (int)syscall(SYS_gettid);
+    ring->in_use = true;
+    ring->head.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+struct RingHolder {
+    TraceRing* ring = nullptr;
+    ~RingHolder() {
+        if (ring) {
+            std::lock_guard<std::mutex> lock(g_rings_mutex);
+            ring->in_use = false;
+        }
+    }
+};
+
+TraceRing* threadRing() {
+    thread_local RingHolder holder;
+    if (!holder.ring) {
+        holder.ring = claimRing();
+    }
+    return holder.ring;
+}
+
+}  // namespace
+
+uint64_t traceNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void traceEnable(bool enabled) {
+    if (enabled && !traceEnabled()) {
+        g_session_ns.store(traceNowNs(), std::memory_order_relaxed);
+    }
+    g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void traceRecord(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+    TraceRing* ring = threadRing();
+    uint64_t n = ring->head.load(std::memory_order_relaxed);
+    TraceEvent& ev = ring->events[n & (TRACE_RING_EVENTS - 1)];
+    ev.name.store(name, std::memory_order_relaxed);
+    ev.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    ev.end_ns.store(end_ns, std::memory_order_relaxed);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+// ─── Chrome Trace JSON ───────────────────────────────────────────────────────
+
+std::string traceDump() {
+    uint64_t session_ns = g_session_ns.load(std::memory_order_relaxed);
+    int pid = (int)getpid();
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    for (TraceRing* ring : g_rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t start = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+
+        struct Span { const char* name; uint64_t begin_ns, end_ns; };
+        std::vector<Span> spans;
+        spans.reserve(head - start);
+        for (uint64_t i = start; i < head; i++) {
+            const TraceEvent& ev = ring->events[i & (TRACE_RING_EVENTS - 1)];
+            spans.push_back({ev.name.load(std::memory_order_relaxed),
+                             ev.begin_ns.load(std::memory_order_relaxed),
+                             ev.end_ns.load(std::memory_order_relaxed)});
+        }
+
+        // Drop the oldest spans if the owner lapped them while they were copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now_head = ring->head.load(std::memory_order_relaxed);
+        uint64_t valid = now_head + 1 > TRACE_RING_EVENTS ? now_head + 1 - TRACE_RING_EVENTS : 0;
+        size_t skip = valid > start ? (size_t)std::min<uint64_t>(valid - start, spans.size()) : 0;
+
+        char thread_name[16] = "";
+        if (ring->in_use) {
+            pthread_getname_np(ring->thread, thread_name, sizeof(thread_name));
+        }
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 first ? "" : ",", pid, ring->tid, thread_name[0] ? thread_name : "exited");
+        out += line;
+        first = false;
+
+        for (size_t i = skip; i < spans.size(); i++) {
+            const Span& s = spans[i];
+            if (!s.name || s.begin_ns < session_ns) continue;
+            snprintf(line, sizeof(line),
+                     ",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                     s.name, pid, ring->tid, s.begin_ns / 1000.0, (s.end_ns - s.begin_ns) / 1000.0);
+            out += line;
+        }
+    }
+    out += "]}";
+    return out;
+}
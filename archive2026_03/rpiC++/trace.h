@@ -0,0 +1,57 @@
+// trace.h - Per-thread span tracing, dumped as Chrome trace JSON at /api/trace
+//
+// TRACE_SPAN("name") records the enclosing scope as one complete span
+// (begin and end, CLOCK_MONOTONIC nanoseconds) into a ring owned by the
+// calling thread, so recording takes no lock and never blocks. Each ring
+// keeps the last TRACE_RING_EVENTS spans. With tracing off a span costs one
+// relaxed load, so the instrumentation stays in production builds.
+//
+//   curl -X POST -d '{"enabled":true}' http://<IP>:8080/api/trace
+//   curl http://<IP>:8080/api/trace > trace.json   # chrome://tracing or ui.perfetto.dev
+//
+// Names must be string literals (only the pointer is stored).
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define TRACE_RING_EVENTS 8192  // Spans kept per thread (power of two)
+
+extern std::atomic<bool> g_trace_enabled;
+
+inline bool traceEnabled() {
+    return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+// Turning tracing on discards the spans of any earlier session
+void traceEnable(bool enabled);
+
+uint64_t traceNowNs();
+void traceRecord(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+// {"traceEvents":[...]} with thread names, oldest span first
+std::string traceDump();
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+        : name_(traceEnabled() ? name : nullptr), begin_ns_(name_ ? traceNowNs() : 0) {}
+    ~TraceSpan() {
+        if (name_) traceRecord(name_, begin_ns_, traceNowNs());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t begin_ns_;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#endif // TRACE_H
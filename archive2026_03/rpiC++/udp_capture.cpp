@@ -0,0 +1,186 @@
+// udp_capture.cpp - Datagram capture file writer / reader
+
+#include "udp_capture.h"
+#include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void putLE(char* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (char)(value >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const unsigned char* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// ─── Writer ──────────────────────────────────────────────────────────────────
+
+CaptureWriter::CaptureWriter()
+    : file_(nullptr), start_ns_(0), written_(0), running_(false), recorded_(0), dropped_(0),
+      full_(false) {
+}
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path) {
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "[CAPTURE] Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_ = path;
+
+    char header[CAPTURE_HEADER_SIZE];
+    memcpy(header, CAPTURE_MAGIC, 8);
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    putLE(header + 8, (uint64_t)wall.tv_sec * 1000000000ull + wall.tv_nsec, 8);
+    fwrite(header, 1, sizeof(header), file_);
+    written_ = sizeof(header);
+
+    start_ns_ = monotonicNs();
+    recorded_ = 0;
+    dropped_ = 0;
+    full_ = false;
+    pending_.reserve(CAPTURE_FLUSH_BYTES * 2);
+    running_ = true;
+    thread_ = std::thread(&CaptureWriter::writerLoop, this);
+
+    std::cout << "[CAPTURE] Recording datagrams to " << path << std::endl;
+    return true;
+}
+
+void CaptureWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    fclose(file_);
+    file_ = nullptr;
+    std::cout << "[CAPTURE] " << path_ << ": " << recorded() << " datagrams, "
+             << dropped() << " dropped" << std::endl;
+}
+
+void CaptureWriter::record(const char* data, size_t len, const struct sockaddr_in& from) {
+    if (full_.load(std::memory_order_relaxed)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    char header[CAPTURE_RECORD_SIZE];
+    putLE(header, monotonicNs() - start_ns_, 8);
+    memcpy(header + 8, &from.sin_addr.s_addr, 4);
+    putLE(header + 12, ntohs(from.sin_port), 2);
+    putLE(header + 14, len, 2);
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || pending_.size() + sizeof(header) + len > CAPTURE_MAX_PENDING) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pending_.insert(pending_.end(), header, header + sizeof(header));
+        pending_.insert(pending_.end(), data, data + len);
+        wake = pending_.size() >= CAPTURE_FLUSH_BYTES;
+    }
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+    if (wake) {
+        cv_.notify_one();
+    }
+}
+
+void CaptureWriter::writerLoop() {
+    std::vector<char> batch;
+    batch.reserve(CAPTURE_FLUSH_BYTES * 2);
+
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Also flush once a second so a capture of a quiet link is current
+            cv_.wait_for(lock, std::chrono::seconds(1), [this]() {
+                return !running_ || pending_.size() >= CAPTURE_FLUSH_BYTES;
+            });
+            batch.swap(pending_);
+            stopping = !running_;
+        }
+
+        if (!batch.empty() && !full_) {
+            if (written_ + batch.size() > CAPTURE_MAX_BYTES) {
+                std::cerr << "[CAPTURE] " << path_ << " reached " << (CAPTURE_MAX_BYTES >> 20)
+                         << " MB - recording stopped" << std::endl;
+                full_ = true;
+            } else {
+                fwrite(batch.data(), 1, batch.size(), file_);
+                fflush(file_);
+                written_ += batch.size();
+            }
+        }
+        batch.clear();
+        if (stopping) break;
+    }
+}
+
+// ─── Reader ──────────────────────────────────────────────────────────────────
+
+CaptureReader::CaptureReader() : file_(nullptr), start_wall_ns_(0) {
+}
+
+CaptureReader::~CaptureReader() {
+    if (file_) {
+        fclose(file_);
+    }
+}
+
+bool CaptureReader::open(const std::string& path) {
+    file_ = fopen(path.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    unsigned char header[CAPTURE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+        memcmp(header, CAPTURE_MAGIC, 8) != 0) {
+        std::cerr << path << " is not a capture file" << std::endl;
+        fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    start_wall_ns_ = getLE(header + 8, 8);
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    unsigned char header[CAPTURE_RECORD_SIZE];
+    if (!file_ || fread(header, 1, sizeof(header), file_) != sizeof(header)) {
+        return false;
+    }
+    record.t_ns = getLE(header, 8);
+    memcpy(&record.addr, header + 8, 4);
+    record.port = (uint16_t)getLE(header + 12, 2);
+    size_t len = getLE(header + 14, 2);
+    record.data.resize(len);
+    return fread(record.data.data(), 1, len, file_) == len;
+}
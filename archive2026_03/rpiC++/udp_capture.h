@@ -0,0 +1,93 @@
+// udp_capture.h - Record received datagrams to a capture file and read them back
+//
+// File layout (little-endian):
+//   header  8  "LMCAP1\0\0"
+//           8  u64 wall-clock start, ns since the epoch (for reference only)
+//   record  8  u64 receive time, ns since the capture started (CLOCK_MONOTONIC)
+//           4  u32 sender IPv4 address (network byte order)
+//           2  u16 sender port
+//           2  u16 payload length
+//           n  payload, exactly as received (JSON or binary "LM" stream)
+//
+// The UDP thread only appends to a memory buffer; a writer thread does the
+// file I/O, so a slow SD card never delays command handling. If the writer
+// falls CAPTURE_MAX_PENDING behind, records are dropped and counted.
+
+#ifndef UDP_CAPTURE_H
+#define UDP_CAPTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#define CAPTURE_MAGIC        "LMCAP1\0\0"
+#define CAPTURE_HEADER_SIZE  16
+#define CAPTURE_RECORD_SIZE  16
+#define CAPTURE_FLUSH_BYTES  (64 * 1024)          // Wake the writer past this much
+#define CAPTURE_MAX_PENDING  (4 * 1024 * 1024)    // Drop records past this much
+#define CAPTURE_MAX_BYTES    (512ull * 1024 * 1024)  // Stop recording at this file size
+
+struct CaptureRecord {
+    uint64_t t_ns;
+    uint32_t addr;   // Network byte order
+    uint16_t port;   // Host byte order
+    std::vector<char> data;
+};
+
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    bool open(const std::string& path);
+    void close();
+
+    // Called from the UDP thread for every datagram
+    void record(const char* data, size_t len, const struct sockaddr_in& from);
+
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    FILE* file_;
+    std::string path_;
+    uint64_t start_ns_;
+    uint64_t written_;  // Writer thread only
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<char> pending_;
+    bool running_;
+    std::thread thread_;
+
+    std::atomic<uint64_t> recorded_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> full_;  // CAPTURE_MAX_BYTES reached
+
+    void writerLoop();
+};
+
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const std::string& path);
+
+    // False at the end of the file (or at a truncated last record)
+    bool next(CaptureRecord& record);
+
+    uint64_t startWallNs() const { return start_wall_ns_; }
+
+private:
+    FILE* file_;
+    uint64_t start_wall_ns_;
+};
+
+#endif // UDP_CAPTURE_H
@@ -2,8 +2,16 @@
 
 #include "udp_handler.h"
 #include "config.h"
+#include "pixel_stream.h"
+#include "sync_clock.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include "udp_capture.h"
+#include "trace.h"
+#include "wall_sync.h"
 #include <nlohmann/json.hpp>
 #include <sys/socket.h>
+#include <ctime>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -12,17 +20,26 @@
 #include <iostream>
 #include <sys/stat.h>
 #include <libgen.h>
+#include <vector>
+#include <optional>
+#include <random>
 
 using json = nlohmann::json;
 
 UDPHandler::UDPHandler(SegmentManager* segment_manager,
                        BrightnessCallback brightness_cb,
                        OrientationCallback orientation_cb,
-                       RotationCallback rotation_cb)
+                       RotationCallback rotation_cb,
+                       const std::string& config_path)
     : sm_(segment_manager),
+      pixel_stream_(nullptr),
+      sync_clock_(nullptr),
+      wall_sync_(nullptr),
+      capture_(nullptr),
       socket_fd_(-1),
       running_(false),
       first_command_received_(false),
+      test_mode_(false),
       brightness_callback_(brightness_cb),
       orientation_callback_(orientation_cb),
       rotation_callback_(rotation_cb),
@@ -30,12 +47,20 @@ UDPHandler::UDPHandler(SegmentManager* segment_manager,
       rotation_(ROTATION_0),
       current_layout_(1),
       brightness_(128),
-      group_id_(0) {
+      group_id_(0),
+      clock_master_(false),
+      clock_election_(false),
+      persist_config_(true),
+      render_tiles_(0),
+      config_path_(config_path) {
     loadConfig();
+    // A staged layout becomes current when its commit swaps the segments in
+    sm_->setLayoutCallback([this](int preset) { current_layout_ = preset; });
 }
 
 UDPHandler::~UDPHandler() {
     stop();
+    sm_->setLayoutCallback(nullptr);
 }
 
 void UDPHandler::start() {
@@ -48,6 +73,10 @@ void UDPHandler::start() {
     int reuse = 1;
     setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
     
+    // Kernel receive timestamps, the start of the packet-to-photon latency
+    int timestamps = 1;
+    setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps));
+    
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
@@ -71,6 +100,25 @@ void UDPHandler::start() {
     listener_thread_ = std::thread(&UDPHandler::run, this);
     
     std::cout << "[UDP] Listening on " << UDP_BIND_ADDR << ":" << UDP_PORT << std::endl;
+    
+    if (wall_.enabled) {
+        joinWallGroup();
+    }
+    
+    if ((clock_master_ || clock_election_) && sync_clock_) {
+        int broadcast = 1;
+        setsockopt(socket_fd_, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+        if (clock_master_) {
+            sync_clock_->setMaster(true);
+            std::cout << "[CLOCK] Clock master - beaconing to " << CLOCK_BEACON_ADDR << ":" << UDP_PORT << std::endl;
+        } else {
+            std::random_device random;
+            uint32_t id = std::max(1u, (uint32_t)random());
+            sync_clock_->setCandidate(id);
+            std::cout << "[CLOCK] Clock master candidate (id " << id << ")" << std::endl;
+        }
+        beacon_thread_ = std::thread(&UDPHandler::beaconLoop, this);
+    }
 }
 
 void UDPHandler::stop() {
@@ -82,60 +130,198 @@ void UDPHandler::stop() {
     if (listener_thread_.joinable()) {
         listener_thread_.join();
     }
+    if (beacon_thread_.joinable()) {
+        beacon_thread_.join();
+    }
+}
+
+// Commands for the wall and the master's frame beacons both arrive on the
+// group; the loopback copy lets nodes sharing a host hear each other
+void UDPHandler::joinWallGroup() {
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    inet_aton(wall_.group.c_str(), &mreq.imr_multiaddr);
+    inet_aton(wall_.interface.c_str(), &mreq.imr_interface);
+    if (setsockopt(socket_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        std::cerr << "[WALL] Cannot join " << wall_.group << " on " << wall_.interface
+                 << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    setsockopt(socket_fd_, IPPROTO_IP, IP_MULTICAST_IF, &mreq.imr_interface, sizeof(mreq.imr_interface));
+    unsigned char loop = 1;
+    setsockopt(socket_fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    
+    std::cout << "[WALL] Joined " << wall_.group << ":" << UDP_PORT << " - viewport "
+             << wall_.x << "," << wall_.y << " of " << wall_.width << "×" << wall_.height
+             << (wall_.master ? " (master)" : "") << std::endl;
+}
+
+void UDPHandler::sendWallFrame(uint64_t frame) {
+    int fd = socket_fd_;
+    if (fd < 0 || !wall_.enabled) {
+        return;
+    }
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(UDP_PORT);
+    inet_aton(wall_.group.c_str(), &dest.sin_addr);
+    
+    std::string beacon = "{\"cmd\":\"wall_frame\",\"n\":" + std::to_string(frame) + "}";
+    sendto(fd, beacon.data(), beacon.size(), 0, (struct sockaddr*)&dest, sizeof(dest));
+}
+
+void UDPHandler::beaconLoop() {
+    applyThreadPolicy("udp", "led-beacon");
+    
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(UDP_PORT);
+    inet_aton(CLOCK_BEACON_ADDR, &dest.sin_addr);
+    
+    // Candidates put their id in the beacon so the others can rank them
+    uint32_t id = sync_clock_->candidateId();
+    std::string id_field = id ? ",\"id\":" + std::to_string(id) : std::string();
+    
+    auto next = std::chrono::steady_clock::now();
+    while (running_) {
+        int fd = socket_fd_;
+        if (fd >= 0 && sync_clock_->shouldBeacon()) {
+            std::string beacon = "{\"cmd\":\"clock\",\"t\":" + std::to_string(sync_clock_->now()) + id_field + "}";
+            sendto(fd, beacon.data(), beacon.size(), 0, (struct sockaddr*)&dest, sizeof(dest));
+        }
+        
+        // Sleep in short slices so stop() doesn't wait a full interval
+        next += std::chrono::milliseconds(CLOCK_BEACON_INTERVAL_MS);
+        while (running_ && std::chrono::steady_clock::now() < next) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+// The kernel stamps datagrams on the realtime clock; carried back to the
+// steady clock by their age. Without a stamp, when recvmsg() returned.
+static uint64_t receiveTimeNs(struct msghdr& msg) {
+    uint64_t now_ns = traceNowNs();
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPNS) continue;
+        struct timespec kernel, real;
+        memcpy(&kernel, CMSG_DATA(c), sizeof(kernel));
+        clock_gettime(CLOCK_REALTIME, &real);
+        int64_t age_ns = (int64_t)(real.tv_sec - kernel.tv_sec) * 1000000000 + (real.tv_nsec - kernel.tv_nsec);
+        if (age_ns >= 0 && (uint64_t)age_ns < now_ns) {
+            return now_ns - (uint64_t)age_ns;
+        }
+    }
+    return now_ns;
 }
 
 void UDPHandler::run() {
-    char buffer[4096];
+    applyThreadPolicy("udp", "led-udp");
+    
+    // Large enough for a full pixel stream keyframe; JSON commands are far smaller
+    std::vector<char> buffer(UDP_MAX_DATAGRAM + 1);
+    std::vector<uint8_t> reply;
+    char control[CMSG_SPACE(sizeof(struct timespec))];
     
     while (running_) {
         struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        struct iovec iov = {buffer.data(), buffer.size() - 1};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &client_addr;
+        msg.msg_namelen = sizeof(client_addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
         
-        ssize_t len = recvfrom(socket_fd_, buffer, sizeof(buffer) - 1, 0,
-                              (struct sockaddr*)&client_addr, &client_len);
+        ssize_t len = recvmsg(socket_fd_, &msg, 0);
         
         if (len < 0) {
             if (!running_) break;
             continue;
         }
+        socklen_t client_len = msg.msg_namelen;
+        uint64_t rx_ns = receiveTimeNs(msg);
         
-        buffer[len] = '\0';
-        std::string raw(buffer, len);
-        
-        // Trim whitespace
-        size_t start = raw.find_first_not_of(" \t\r\n");
-        size_t end = raw.find_last_not_of(" \t\r\n");
-        if (start != std::string::npos && end != std::string::npos) {
-            raw = raw.substr(start, end - start + 1);
+        if (capture_) {
+            capture_->record(buffer.data(), len, client_addr);
         }
         
-        dispatch(raw);
+        handleDatagram(buffer.data(), len, reply, rx_ns);
+        if (!reply.empty()) {
+            sendto(socket_fd_, reply.data(), reply.size(), 0,
+                   (struct sockaddr*)&client_addr, client_len);
+        }
     }
     
     std::cout << "[UDP] Listener thread exited" << std::endl;
 }
 
-void UDPHandler::dispatch(const std::string& raw_json) {
-    // Check if test mode is active - if so, ignore all UDP commands
-    std::ifstream testfile("/tmp/led-matrix-testmode");
-    if (testfile.is_open()) {
-        char c;
-        testfile >> c;
-        testfile.close();
-        if (c == '1') {
-            // Test mode active - ignore all commands silently
-            return;
+void UDPHandler::handleDatagram(const char* data, size_t len, std::vector<uint8_t>& reply, uint64_t rx_ns) {
+    reply.clear();
+    
+    // Binary pixel frames bypass the JSON parser entirely
+    if (PixelStream::isStreamPacket(data, len)) {
+        metrics().packets_received[CMD_STREAM].inc();
+        if (!pixel_stream_ || test_mode_) {
+            metrics().packets_dropped[CMD_STREAM].inc();
+        } else {
+            first_command_received_ = true;
+            pixel_stream_->handlePacket((const uint8_t*)data, len, reply);
         }
+        return;
+    }
+    
+    std::string raw(data, len);
+    
+    // Trim whitespace
+    size_t start = raw.find_first_not_of(" \t\r\n");
+    size_t end = raw.find_last_not_of(" \t\r\n");
+    if (start != std::string::npos && end != std::string::npos) {
+        raw = raw.substr(start, end - start + 1);
     }
     
+    dispatch(raw, rx_ns);
+}
+
+void UDPHandler::dispatch(const std::string& raw_json, uint64_t rx_ns) {
+    TRACE_SPAN("dispatch");
     // Reduced logging - only log on startup or errors
     // std::cout << "[UDP] Received: " << raw_json << std::endl;
     
+    CommandType type = CMD_INVALID;
     try {
         json doc = json::parse(raw_json);
-        first_command_received_ = true;
-        
         std::string cmd = doc.value("cmd", "");
+        type = commandType(cmd);
+        metrics().packets_received[type].inc();
+        
+        // Check if test mode is active - if so, ignore all UDP commands silently
+        if (test_mode_) {
+            metrics().packets_dropped[type].inc();
+            return;
+        }
+        
+        // Clock beacons are group-independent and don't count as a first command
+        if (cmd == "clock") {
+            if (sync_clock_ && doc.contains("t")) {
+                sync_clock_->onBeacon(doc["t"].get<uint64_t>(), doc.value("id", 0u));
+            }
+            return;
+        }
+        
+        // Nor are wall frame beacons (the master hears its own and ignores them)
+        if (cmd == "wall_frame") {
+            if (wall_sync_ && !wall_.master && doc.contains("n")) {
+                wall_sync_->onBeacon(doc["n"].get<uint64_t>());
+            }
+            return;
+        }
+        
+        first_command_received_ = true;
         
         // Check group filtering
         int cmd_group = doc.value("group", 0);
@@ -144,6 +330,7 @@ void UDPHandler::dispatch(const std::string& raw_json) {
         if (cmd_group != 0 && my_group != 0 && cmd_group != my_group) {
             std::cout << "[UDP] Ignoring command for group " << cmd_group 
                      << " (this panel is group " << my_group << ")" << std::endl;
+            metrics().packets_dropped[type].inc();
             return;
         }
         
@@ -151,37 +338,18 @@ void UDPHandler::dispatch(const std::string& raw_json) {
         // std::cout << "[UDP] Executing command: " << cmd 
         //          << " (group=" << cmd_group << ", my_group=" << my_group << ")" << std::endl;
         
-        // Auto-disable frame on segment 1 when first command arrives (unless it's a frame command)
-        if (cmd != "frame" && doc.contains("seg")) {
-            int seg = doc.value("seg", 0);
-            if (seg == 1) {
-                std::cout << "[UDP] Auto-disabling frame on segment 1 (cmd: " << cmd << ")" << std::endl;
-                sm_->setFrame(seg, false, "FFFFFF", 2);
+        // "prepare": true stages content commands; "commit" makes them visible
+        // together. A live content write while something is staged is made to
+        // the staged copy too, so the commit doesn't roll it back.
+        if (isContentCommand(cmd)) {
+            bool prepare = doc.value("prepare", false);
+            if (prepare || sm_->hasStaged()) {
+                SegmentManager::StagingScope staging(*sm_);
+                applyContent(cmd, doc, prepare);
+            }
+            if (!prepare) {
+                applyContent(cmd, doc, true);
             }
-        }
-        
-        if (cmd == "text") {
-            int seg = doc.value("seg", 0);
-            std::string text = doc.value("text", "");
-            std::string color = doc.value("color", "FFFFFF");
-            std::string bgcolor = doc.value("bgcolor", "000000");
-            std::string align = doc.value("align", "C");
-            std::string effect = doc.value("effect", "none");
-            int intensity = doc.value("intensity", 255);
-            std::string font = doc.value("font", "arial");  // "arial" or "monospace"
-            
-            sm_->updateText(seg, text, color, bgcolor, align, effect, intensity, font);
-            
-        } else if (cmd == "layout") {
-            int preset = doc.value("preset", 1);
-            applyLayout(preset);
-            
-        } else if (cmd == "clear") {
-            int seg = doc.value("seg", 0);
-            sm_->clearSegment(seg);
-            
-        } else if (cmd == "clear_all") {
-            sm_->clearAll();
             
         } else if (cmd == "brightness") {
             int val = doc.value("value", -1);
@@ -282,62 +450,147 @@ void UDPHandler::dispatch(const std::string& raw_json) {
                 std::cout << "[UDP] ✗ Invalid group value: " << value << std::endl;
             }
             
-        } else if (cmd == "config") {
-            int seg = doc.value("seg", 0);
-            int x = doc.value("x", 0);
-            int y = doc.value("y", 0);
-            int w = doc.value("w", 64);
-            int h = doc.value("h", 32);
-            sm_->configure(seg, x, y, w, h);
+        } else if (cmd == "commit") {
+            // "at" is a presentation time on the shared clock; omitted = now
+            uint64_t at = doc.value("at", (uint64_t)0);
+            sm_->scheduleCommit(at);
             
-        } else if (cmd == "frame") {
-            int seg = doc.value("seg", 0);
-            bool enabled = doc.value("enabled", false);
-            std::string color = doc.value("color", "FFFFFF");
-            int width = doc.value("width", 2);
-            sm_->setFrame(seg, enabled, color, width);
+        } else if (cmd == "discard") {
+            sm_->discardStaged();
             
         } else {
             std::cerr << "[UDP] Unknown cmd: " << cmd << std::endl;
         }
         
+        // Staged changes wait for their commit time on purpose; the rest are
+        // timed to the first frame that shows them
+        if (rx_ns && !doc.value("prepare", false) && cmd != "commit" && cmd != "discard") {
+            uint64_t dispatched_ns = traceNowNs();
+            metrics().latency_receive_dispatch.observe((dispatched_ns - std::min(dispatched_ns, rx_ns)) / 1000);
+            sm_->notePacket(rx_ns, dispatched_ns);
+        }
+        
     } catch (const json::exception& e) {
+        if (type == CMD_INVALID) {
+            metrics().packets_received[CMD_INVALID].inc();
+        }
+        metrics().packets_dropped[type].inc();
         std::cerr << "[UDP] JSON parse error: " << e.what() << std::endl;
     }
 }
 
+bool UDPHandler::isContentCommand(const std::string& cmd) {
+    return cmd == "text" || cmd == "layout" || cmd == "clear" || cmd == "clear_all" ||
+           cmd == "config" || cmd == "frame";
+}
+
+// Segment content and geometry, written to the live segments - or inside a
+// StagingScope to the staged copy. `count` is false for the copy of a live
+// write, so a coalesced update isn't counted twice.
+void UDPHandler::applyContent(const std::string& cmd, const json& doc, bool count) {
+    // Auto-disable frame on segment 1 when first command arrives (unless it's a frame command)
+    if (cmd != "frame" && doc.contains("seg")) {
+        int seg = doc.value("seg", 0);
+        if (seg == 1) {
+            std::cout << "[UDP] Auto-disabling frame on segment 1 (cmd: " << cmd << ")" << std::endl;
+            sm_->setFrame(seg, false, "FFFFFF", 2);
+        }
+    }
+    
+    if (cmd == "text") {
+        int seg = doc.value("seg", 0);
+        std::string text = doc.value("text", "");
+        std::string color = doc.value("color", "FFFFFF");
+        std::string bgcolor = doc.value("bgcolor", "000000");
+        std::string align = doc.value("align", "C");
+        std::string effect = doc.value("effect", "none");
+        int intensity = doc.value("intensity", 255);
+        std::string font = doc.value("font", "arial");  // "arial", "monospace" or "bitmap"
+        int fade_ms = doc.value("fade_ms", 0);          // 0 = keep the segment's
+        std::string easing = doc.value("easing", "");
+        int antialias = doc.contains("aa") ? (int)doc.value("aa", false) : -1;
+        
+        if (!sm_->updateText(seg, text, color, bgcolor, align, effect, intensity, font, fade_ms, easing,
+                             antialias)) {
+            if (count) metrics().packets_coalesced[CMD_TEXT].inc();
+        }
+        
+    } else if (cmd == "layout") {
+        int preset = doc.value("preset", 1);
+        applyLayout(preset);
+        
+    } else if (cmd == "clear") {
+        int seg = doc.value("seg", 0);
+        sm_->clearSegment(seg);
+        
+    } else if (cmd == "clear_all") {
+        sm_->clearAll();
+        
+    } else if (cmd == "config") {
+        int seg = doc.value("seg", 0);
+        int x = doc.value("x", 0);
+        int y = doc.value("y", 0);
+        int w = doc.value("w", 64);
+        int h = doc.value("h", 32);
+        sm_->configure(seg, x, y, w, h);
+        
+    } else if (cmd == "frame") {
+        int seg = doc.value("seg", 0);
+        bool enabled = doc.value("enabled", false);
+        std::string color = doc.value("color", "FFFFFF");
+        int width = doc.value("width", 2);
+        sm_->setFrame(seg, enabled, color, width);
+        
+    }
+}
+
 void UDPHandler::applyLayout(int preset) {
     if (preset < 1 || preset > 14) {
         std::cerr << "[UDP] Unknown layout preset " << preset << std::endl;
         return;
     }
     
+    // A staged layout goes live with the commit; until then the renderer
+    // must not see the preset change (it would clear the canvas early)
+    bool staged = sm_->isStaging();
+    int shown = (staged && sm_->stagedLayout()) ? sm_->stagedLayout() : current_layout_.load();
+    
     // Skip if layout didn't actually change
-    if (current_layout_ == preset) {
+    if (shown == preset) {
         return;  // No-op, already on this layout
     }
     
-    current_layout_ = preset;
-    
-    // Select base layout based on rotation (rotation changes effective canvas dimensions)
-    // 0° and 180° use landscape (64×32), 90° and 270° use portrait (32×64)
-    const std::vector<LayoutRect>* zones;
-    bool use_portrait_layout = (rotation_ == ROTATION_90 || rotation_ == ROTATION_270);
-    
-    if (use_portrait_layout) {
-        zones = &LAYOUT_PORTRAIT[preset];
+    if (staged) {
+        sm_->stageLayout(preset);
     } else {
-        zones = &LAYOUT_LANDSCAPE[preset];
+        current_layout_ = preset;
+    }
+    
+    // Presets are scaled to the canvas as rotated (90° and 270° swap its
+    // sides) - or on a wall, to the virtual canvas all its nodes share; a
+    // canvas taller than wide uses the portrait arrangements
+    int canvas_w = panel_.canvasWidth();
+    int canvas_h = panel_.canvasHeight();
+    if (rotation_ == ROTATION_90 || rotation_ == ROTATION_270) {
+        std::swap(canvas_w, canvas_h);
     }
+    if (wall_.enabled) {
+        canvas_w = wall_.width;
+        canvas_h = wall_.height;
+    }
+    bool use_portrait_layout = canvas_h > canvas_w;
+    const std::vector<LayoutCell>* zones = use_portrait_layout ? &LAYOUT_PORTRAIT[preset]
+                                                               : &LAYOUT_LANDSCAPE[preset];
     
     std::cout << "[UDP] LAYOUT preset=" << preset 
              << " (" << zones->size() << " segment(s))"
              << " rotation=" << static_cast<int>(rotation_) << "°"
-             << " [using " << (use_portrait_layout ? "portrait" : "landscape") << " coords]" << std::endl;
+             << " canvas=" << canvas_w << "×" << canvas_h
+             << " [using " << (use_portrait_layout ? "portrait" : "landscape") << " layouts]" << std::endl;
     
     for (int i = 0; i < MAX_SEGMENTS; i++) {
         if (i < (int)zones->size()) {
-            const LayoutRect& rect = (*zones)[i];
+            LayoutRect rect = layoutRect((*zones)[i], canvas_w, canvas_h);
             sm_->configure(i, rect.x, rect.y, rect.w, rect.h);
             sm_->activate(i, true);
         } else {
@@ -351,7 +604,7 @@ void UDPHandler::applyLayout(int preset) {
 }
 
 void UDPHandler::loadConfig() {
-    std::ifstream file(CONFIG_FILE);
+    std::ifstream file(config_path_);
     if (!file.is_open()) {
         std::cout << "[CONFIG] No config file found, using defaults" << std::endl;
         return;
@@ -373,26 +626,60 @@ void UDPHandler::loadConfig() {
         
         group_id_ = config.value("group_id", 0);
         brightness_ = config.value("brightness", 128);
+        // true: always the clock master; "auto": stand in the election
+        if (config.contains("clock_master")) {
+            const json& master = config["clock_master"];
+            clock_master_ = master.is_boolean() && master.get<bool>();
+            clock_election_ = master.is_string() && master.get<std::string>() == "auto";
+        }
+        
+        if (config.contains("panel")) {
+            const json& panel = config["panel"];
+            panel_.width = std::max(1, panel.value("width", MATRIX_WIDTH));
+            panel_.height = std::max(1, panel.value("height", MATRIX_HEIGHT));
+            panel_.chain = std::max(1, panel.value("chain", MATRIX_CHAIN));
+            panel_.parallel = std::max(1, panel.value("parallel", MATRIX_PARALLEL));
+        }
+        render_tiles_ = std::max(0, config.value("render_tiles", 0));
+        
+        if (config.contains("wall")) {
+            const json& wall = config["wall"];
+            wall_.width = wall.value("width", 0);
+            wall_.height = wall.value("height", 0);
+            wall_.x = wall.value("x", 0);
+            wall_.y = wall.value("y", 0);
+            wall_.master = wall.value("master", false);
+            wall_.group = wall.value("group", std::string(WALL_GROUP_ADDR));
+            wall_.interface = wall.value("interface", std::string("0.0.0.0"));
+            wall_.enabled = wall_.width > 0 && wall_.height > 0;
+        }
         
         std::cout << "[CONFIG] Loaded orientation: " << orient 
                  << ", rotation: " << rotation_value << "°"
                  << ", group_id: " << group_id_ 
-                 << ", brightness: " << brightness_ << std::endl;
+                 << ", brightness: " << brightness_
+                 << ", panel: " << panel_.width << "×" << panel_.height
+                 << " chain=" << panel_.chain << " parallel=" << panel_.parallel << std::endl;
     } catch (const json::exception& e) {
         std::cerr << "[CONFIG] Failed to parse: " << e.what() << std::endl;
     }
 }
 
 void UDPHandler::saveConfig() {
+    TRACE_SPAN("saveConfig");
+    if (!persist_config_) {
+        return;
+    }
+    
     // Create directory if it doesn't exist
-    char* path_copy = strdup(CONFIG_FILE);
+    char* path_copy = strdup(config_path_.c_str());
     char* dir = dirname(path_copy);
     mkdir(dir, 0755);
     free(path_copy);
     
     // Read existing config first to preserve network settings
     json config;
-    std::ifstream existing_file(CONFIG_FILE);
+    std::ifstream existing_file(config_path_);
     if (existing_file.is_open()) {
         try {
             existing_file >> config;
@@ -412,10 +699,10 @@ void UDPHandler::saveConfig() {
         config["brightness"] = brightness_;
     }
     
-    std::ofstream file(CONFIG_FILE);
+    std::ofstream file(config_path_);
     if (file.is_open()) {
         file << config.dump(2);
-        std::cout << "[CONFIG] Saved to " << CONFIG_FILE << " (network settings preserved)" << std::endl;
+        std::cout << "[CONFIG] Saved to " << config_path_ << " (network settings preserved)" << std::endl;
     } else {
         std::cerr << "[CONFIG] Failed to save" << std::endl;
     }
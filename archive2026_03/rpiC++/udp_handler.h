@@ -8,8 +8,15 @@
 #include <atomic>
 #include <functional>
 #include <mutex>
+#include <vector>
+#include <nlohmann/json_fwd.hpp>
 #include "segment_manager.h"
 
+class PixelStream;
+class SyncClock;
+class CaptureWriter;
+class WallSync;
+
 class UDPHandler {
 public:
     using BrightnessCallback = std::function<void(int)>;
@@ -19,7 +26,8 @@ public:
     UDPHandler(SegmentManager* segment_manager,
                BrightnessCallback brightness_cb = nullptr,
                OrientationCallback orientation_cb = nullptr,
-               RotationCallback rotation_cb = nullptr);
+               RotationCallback rotation_cb = nullptr,
+               const std::string& config_path = CONFIG_FILE);
     ~UDPHandler();
     
     void start();
@@ -31,27 +39,88 @@ public:
     int getGroupId() const { return group_id_; }
     int getBrightness() const { return brightness_; }
     
-    void dispatch(const std::string& raw_json);
+    // Panel geometry and render bands from config.json (defaults without one)
+    const PanelGeometry& getPanel() const { return panel_; }
+    int getRenderTiles() const { return render_tiles_; }
+    
+    // Layout presets are scaled to this panel's canvas (replay, goldens)
+    void setPanel(const PanelGeometry& panel) { panel_ = panel; }
+    
+    // Video wall: presets span the virtual canvas; the group is joined on start()
+    const WallConfig& getWall() const { return wall_; }
+    void setWall(const WallConfig& wall) { wall_ = wall; }
+    
+    // Frame beacons heard from the wall master go here
+    void setWallSync(WallSync* wall_sync) { wall_sync_ = wall_sync; }
+    
+    // Wall master: announce the frame about to be composed
+    void sendWallFrame(uint64_t frame);
+    
+    // `rx_ns`: when the datagram arrived (steady clock, ns; 0 = unknown). A
+    // known time is carried to the frame showing the change, for the
+    // packet-to-photon latency metrics.
+    void dispatch(const std::string& raw_json, uint64_t rx_ns = 0);
+    
+    // Route one received datagram: pixel stream packets to the stream (the
+    // ACK for the sender goes to `reply`), everything else to dispatch()
+    void handleDatagram(const char* data, size_t len, std::vector<uint8_t>& reply, uint64_t rx_ns = 0);
+    
+    // Route binary "LM" frame datagrams to a pixel stream (optional)
+    void setPixelStream(PixelStream* stream) { pixel_stream_ = stream; }
+    
+    // Shared clock for staged commits and effect phase; beaconed from here if
+    // "clock_master" is true, or if this panel wins the election ("auto")
+    void setSyncClock(SyncClock* clock) { sync_clock_ = clock; }
+    
+    // Record every received datagram (optional, see udp_capture.h)
+    void setCapture(CaptureWriter* capture) { capture_ = capture; }
+    
+    // Replay and benchmarks apply settings in memory only
+    void setPersistConfig(bool persist) { persist_config_ = persist; }
+    
+    // Segments were restored from `preset` at startup (no reconfiguration)
+    void restoreLayout(int preset) { current_layout_ = preset; }
+    
+    // Test mode drops every command and stream frame; the render loop, which
+    // reads /tmp/led-matrix-testmode anyway, keeps this flag current
+    void setTestMode(bool active) { test_mode_ = active; }
     
 private:
     SegmentManager* sm_;
+    PixelStream* pixel_stream_;
+    SyncClock* sync_clock_;
+    WallSync* wall_sync_;
+    CaptureWriter* capture_;
     int socket_fd_;
     std::thread listener_thread_;
+    std::thread beacon_thread_;
     std::atomic<bool> running_;
     std::atomic<bool> first_command_received_;
+    std::atomic<bool> test_mode_;
     BrightnessCallback brightness_callback_;
     OrientationCallback orientation_callback_;
     RotationCallback rotation_callback_;
     
     Orientation orientation_;
     Rotation rotation_;
-    int current_layout_;
+    std::atomic<int> current_layout_;  // Set by the render thread when a staged layout commits
     int brightness_;
     int group_id_;
+    bool clock_master_;
+    bool clock_election_;
+    bool persist_config_;
+    PanelGeometry panel_;
+    int render_tiles_;
+    WallConfig wall_;
+    std::string config_path_;
     
     mutable std::mutex config_mutex_;
     
     void run();
+    void beaconLoop();
+    void joinWallGroup();
+    static bool isContentCommand(const std::string& cmd);
+    void applyContent(const std::string& cmd, const nlohmann::json& doc, bool count);
     void applyLayout(int preset);
     void loadConfig();
     void saveConfig();
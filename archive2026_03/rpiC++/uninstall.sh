@@ -52,6 +52,9 @@ echo "✓ Systemd service removed"
 rm -f /usr/local/bin/led-matrix
 echo "✓ Binary removed"
 
+rm -rf /usr/share/fonts/led-matrix
+echo "✓ BDF fonts removed"
+
 echo ""
 
 # ─── 3. Configuration Files ──────────────────────────────────────────────────
@@ -34,6 +34,7 @@ echo "RGB Matrix Library:"
 check "Library headers installed" "test -f /usr/local/include/led-matrix.h"
 check "Static library installed" "test -f /usr/local/lib/librgbmatrix.a"
 check "Shared library installed" "test -f /usr/local/lib/librgbmatrix.so.1"
+check "BDF fonts installed" "ls /usr/share/fonts/led-matrix/*.bdf"
 
 echo ""
 echo "LED Matrix Controller:"
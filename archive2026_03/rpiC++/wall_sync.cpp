@@ -0,0 +1,45 @@
+// wall_sync.cpp - Video wall frame lock
+
+#include "wall_sync.h"
+#include <iostream>
+
+WallSync::WallSync() : frame_(0), fresh_(false) {
+}
+
+void WallSync::onBeacon(uint64_t frame) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Duplicates and stragglers are dropped; a big step back is the
+        // master restarting with a new count
+        if (frame <= frame_ && frame + 100 > frame_) {
+            return;
+        }
+        if (frame_ == 0) {
+            std::cout << "[WALL] Following frame beacons (frame " << frame << ")" << std::endl;
+        }
+        frame_ = frame;
+        fresh_ = true;
+        last_beacon_ = std::chrono::steady_clock::now();
+    }
+    cv_.notify_one();
+}
+
+bool WallSync::waitBeacon(std::chrono::steady_clock::time_point deadline, uint64_t& frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cv_.wait_until(lock, deadline, [this]() { return fresh_; })) {
+        return false;
+    }
+    fresh_ = false;
+    frame = frame_;
+    return true;
+}
+
+uint64_t WallSync::lastFrame() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_;
+}
+
+std::chrono::steady_clock::time_point WallSync::lastBeacon() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_beacon_;
+}
@@ -0,0 +1,42 @@
+// wall_sync.h - Frame lock between the nodes of a video wall
+//
+// The wall master sends {"cmd":"wall_frame","n":<frame>} to the wall group
+// just before it composes each frame. A follower's render loop sleeps in
+// waitBeacon() and composes frame n as soon as its beacon arrives, with
+// effects evaluated at n × EFFECT_INTERVAL - so every node draws the same
+// instant of a scrolling ticker and presents it within a network hop of
+// the others. When the master goes quiet the followers pace themselves,
+// counting on from the last frame they heard.
+
+#ifndef WALL_SYNC_H
+#define WALL_SYNC_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+class WallSync {
+public:
+    WallSync();
+
+    // UDP thread: a frame beacon arrived
+    void onBeacon(uint64_t frame);
+
+    // Render loop: sleep until `deadline` or a new beacon, whichever comes
+    // first; true (and the frame) if a beacon woke us
+    bool waitBeacon(std::chrono::steady_clock::time_point deadline, uint64_t& frame);
+
+    // Last frame heard, and when (steady clock; epoch if never)
+    uint64_t lastFrame() const;
+    std::chrono::steady_clock::time_point lastBeacon() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t frame_;
+    bool fresh_;  // Not yet taken by waitBeacon()
+    std::chrono::steady_clock::time_point last_beacon_;
+};
+
+#endif // WALL_SYNC_H
@@ -0,0 +1,23 @@
+// web_assets.h - Web UI files embedded at build time (see embed-assets.sh)
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <cstddef>
+#include <string>
+
+struct WebAsset {
+    const char* path;          // URL path, e.g. "/index.html"
+    const char* content_type;
+    const char* etag;          // Quoted, for the identity body
+    const char* etag_gzip;     // Quoted, for the gzip body
+    const unsigned char* data;
+    size_t size;
+    const unsigned char* gzip_data;
+    size_t gzip_size;
+};
+
+// "/" maps to "/index.html"; returns nullptr for unknown paths
+const WebAsset* findWebAsset(const std::string& path);
+
+#endif // WEB_ASSETS_H
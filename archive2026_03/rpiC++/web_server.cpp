@@ -2,26 +2,48 @@
 
 #include "web_server.h"
 #include "config.h"
+#include "web_assets.h"
+#include "frame_mailbox.h"
+#include "frame_codec.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include "trace.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <chrono>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
-#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
 #include <cstring>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
 WebServer::WebServer(int port)
-    : port_(port), server_fd_(-1), running_(false) {
+    : port_(port), server_fd_(-1), running_(false), server_thread_(0), next_conn_id_(1),
+      preview_source_(nullptr), next_preview_ms_(0) {
+    wake_pipe_[0] = wake_pipe_[1] = -1;
 }
 
 WebServer::~WebServer() {
     stop();
 }
 
+uint64_t WebServer::millis() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
 void WebServer::start() {
     if (running_) return;
     
@@ -43,134 +65,579 @@ void WebServer::start() {
     if (bind(server_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         std::cerr << "[WEB] Failed to bind port " << port_ << std::endl;
         close(server_fd_);
+        server_fd_ = -1;
         return;
     }
     
-    if (listen(server_fd_, 5) < 0) {
+    if (listen(server_fd_, 16) < 0) {
         std::cerr << "[WEB] Failed to listen" << std::endl;
         close(server_fd_);
+        server_fd_ = -1;
         return;
     }
+    setNonBlocking(server_fd_);
+    
+    // Workers poke the event loop through this pipe when a response is ready
+    if (pipe(wake_pipe_) < 0) {
+        std::cerr << "[WEB] Failed to create wake pipe" << std::endl;
+        close(server_fd_);
+        server_fd_ = -1;
+        return;
+    }
+    setNonBlocking(wake_pipe_[0]);
+    setNonBlocking(wake_pipe_[1]);
     
     running_ = true;
     
-    pthread_t thread;
-    pthread_create(&thread, nullptr, serverThread, this);
-    pthread_detach(thread);
+    pthread_create(&server_thread_, nullptr, serverThread, this);
+    for (int i = 0; i < WEB_WORKER_THREADS; i++) {
+        pthread_t worker;
+        pthread_create(&worker, nullptr, workerThread, this);
+        worker_threads_.push_back(worker);
+    }
     
-    std::cout << "[WEB] Config server started on port " << port_ << std::endl;
+    std::cout << "[WEB] Config server started on port " << port_ 
+             << " (" << WEB_WORKER_THREADS << " workers)" << std::endl;
 }
 
 void WebServer::stop() {
     if (!running_) return;
     running_ = false;
-    if (server_fd_ >= 0) {
-        close(server_fd_);
-        server_fd_ = -1;
+    
+    wake();
+    queue_cv_.notify_all();
+    pthread_join(server_thread_, nullptr);
+    for (pthread_t worker : worker_threads_) {
+        pthread_join(worker, nullptr);
+    }
+    worker_threads_.clear();
+    
+    for (auto& entry : connections_) {
+        close(entry.second.fd);
     }
+    connections_.clear();
+    
+    close(server_fd_);
+    close(wake_pipe_[0]);
+    close(wake_pipe_[1]);
+    server_fd_ = wake_pipe_[0] = wake_pipe_[1] = -1;
+}
+
+void WebServer::wake() {
+    char c = 1;
+    ssize_t ignored = write(wake_pipe_[1], &c, 1);
+    (void)ignored;
 }
 
+// ─── Event Loop ──────────────────────────────────────────────────────────────
+
 void* WebServer::serverThread(void* arg) {
     WebServer* server = (WebServer*)arg;
+    server->eventLoop();
+    return nullptr;
+}
+
+void WebServer::eventLoop() {
+    applyThreadPolicy("web", "led-web");
+    
+    std::vector<struct pollfd> fds;
+    std::vector<uint64_t> ids;
     
-    while (server->running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(server->server_fd_, (struct sockaddr*)&client_addr, &client_len);
+    while (running_) {
+        fds.clear();
+        ids.clear();
+        fds.push_back({server_fd_, POLLIN, 0});
+        fds.push_back({wake_pipe_[0], POLLIN, 0});
         
-        if (client_fd >= 0) {
-            server->handleClient(client_fd);
+        uint64_t now = millis();
+        int timeout_ms = 1000;
+        bool previewing = false;
+        for (auto& entry : connections_) {
+            Connection& conn = entry.second;
+            short events = 0;
+            if (!conn.out.empty()) events |= POLLOUT;
+            else if (!conn.busy && !conn.read_closed) events |= POLLIN;
+            fds.push_back({conn.fd, events, 0});
+            ids.push_back(entry.first);
+            if (conn.preview) {
+                previewing = true;
+            } else if (!conn.busy) {
+                int64_t left = (int64_t)conn.deadline_ms - (int64_t)now;
+                timeout_ms = std::max(0, std::min<int>(timeout_ms, (int)left));
+            }
+        }
+        if (previewing) {
+            int64_t left = (int64_t)next_preview_ms_ - (int64_t)now;
+            timeout_ms = std::max(0, std::min<int>(timeout_ms, (int)left));
+        }
+        
+        int ready = poll(fds.data(), fds.size(), timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "[WEB] poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (!running_) break;
+        
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wake_pipe_[0], drain, sizeof(drain)) > 0) {}
+        }
+        collectResults();
+        pumpPreview();
+        
+        for (size_t i = 0; i < ids.size(); i++) {
+            auto it = connections_.find(ids[i]);
+            if (it == connections_.end()) continue;
+            short revents = fds[i + 2].revents;
+            if (revents & (POLLERR | POLLNVAL)) {
+                close(it->second.fd);
+                connections_.erase(it);
+                continue;
+            }
+            if (revents & POLLOUT) {
+                writeClient(ids[i], it->second);
+            } else if (revents & (POLLIN | POLLHUP)) {
+                readClient(ids[i], it->second);
+            }
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            acceptClients();
+        }
+        
+        // Drop connections that went quiet (slowloris, abandoned keep-alives)
+        now = millis();
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            Connection& conn = it->second;
+            if (!conn.busy && !conn.preview && now >= conn.deadline_ms) {
+                close(conn.fd);
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void WebServer::acceptClients() {
+    while (true) {
+        int client_fd = accept(server_fd_, nullptr, nullptr);
+        if (client_fd < 0) return;
+        
+        if ((int)connections_.size() >= WEB_MAX_CONNECTIONS) {
+            std::string busy = HttpResponse(503, "text/plain", "Busy\n").serialize(false);
+            send(client_fd, busy.data(), busy.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
             close(client_fd);
+            continue;
         }
+        
+        setNonBlocking(client_fd);
+        int nodelay = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        
+        Connection conn;
+        conn.fd = client_fd;
+        conn.busy = false;
+        conn.keep_alive = true;
+        conn.read_closed = false;
+        conn.continue_sent = false;
+        conn.preview = false;
+        conn.preview_synced = false;
+        conn.deadline_ms = millis() + WEB_REQUEST_TIMEOUT_S * 1000;
+        connections_.emplace(next_conn_id_++, std::move(conn));
     }
-    
-    return nullptr;
 }
 
-void WebServer::handleClient(int client_fd) {
+void WebServer::readClient(uint64_t id, Connection& conn) {
+    // First bytes of a new request on a kept-alive connection restart the request clock
+    if (conn.in.empty() && !conn.parser.headersComplete()) {
+        conn.deadline_ms = millis() + WEB_REQUEST_TIMEOUT_S * 1000;
+    }
+    
     char buffer[4096];
-    ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-    if (bytes <= 0) return;
+    while (true) {
+        ssize_t bytes = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (bytes > 0) {
+            conn.in.append(buffer, bytes);
+            // The parser bounds each request; this bounds what waits for the parser
+            if (conn.in.size() > HTTP_MAX_HEADER_BYTES + HTTP_MAX_BODY_BYTES) {
+                conn.in.clear();
+                if (conn.busy || !conn.out.empty()) {
+                    close(conn.fd);
+                    connections_.erase(id);
+                } else {
+                    rejectRequest(id, conn, conn.parser.headersComplete() ? 413 : 431);
+                }
+                return;
+            }
+            continue;
+        }
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (bytes < 0 && errno == EINTR) continue;
+        
+        // Half-close (shutdown(SHUT_WR), "nc -q"): requests already sent are
+        // still answered. An error, or a viewer hanging up, ends it here.
+        if (bytes == 0 && !conn.preview) {
+            conn.read_closed = true;
+            break;
+        }
+        close(conn.fd);
+        connections_.erase(id);
+        return;
+    }
+    processInput(id, conn);
+}
+
+void WebServer::processInput(uint64_t id, Connection& conn) {
+    if (conn.preview) {
+        conn.in.clear();  // Viewers have nothing more to say
+        return;
+    }
+    if (conn.busy || !conn.out.empty()) return;
+    if (conn.in.empty() && !conn.read_closed) return;
+    
+    HttpParser::State state = conn.in.empty() ? HttpParser::READING : conn.parser.feed(conn.in);
+    
+    if (state == HttpParser::READING) {
+        // Read side closed: a request not complete by now never will be
+        if (conn.read_closed) {
+            close(conn.fd);
+            connections_.erase(id);
+            return;
+        }
+        // Clients waiting on "Expect: 100-continue" won't send the body until told to
+        if (conn.parser.headersComplete() && conn.parser.expectsContinue() && !conn.continue_sent) {
+            conn.continue_sent = true;
+            conn.out = "HTTP/1.1 100 Continue\r\n\r\n";
+            writeClient(id, conn);
+        }
+        return;
+    }
+    
+    if (state == HttpParser::ERROR) {
+        rejectRequest(id, conn, conn.parser.errorStatus());
+        return;
+    }
+    
+    // The preview stream never reaches a worker - the event loop feeds it
+    const HttpRequest& req = conn.parser.request();
+    if (req.method == "GET" && req.path == "/api/preview") {
+        startPreview(id, conn);
+        return;
+    }
+    
+    // Complete request - hand it to a worker, or refuse if the queue is full
+    conn.keep_alive = conn.parser.request().keepAlive();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (jobs_.size() < WEB_MAX_QUEUED_REQUESTS) {
+            jobs_.push_back({id, std::move(conn.parser.request())});
+            conn.busy = true;
+        }
+    }
+    conn.parser.reset();
+    conn.continue_sent = false;
+    
+    if (conn.busy) {
+        queue_cv_.notify_one();
+    } else {
+        conn.out = HttpResponse(503, "text/plain", "Busy\n").serialize(false);
+        conn.keep_alive = false;
+        writeClient(id, conn);
+    }
+}
+
+void WebServer::rejectRequest(uint64_t id, Connection& conn, int status) {
+    conn.out = HttpResponse(status, "text/plain", std::string(HttpResponse::reason(status)) + "\n")
+                   .serialize(false);
+    conn.keep_alive = false;
+    conn.in.clear();
+    writeClient(id, conn);
+}
+
+void WebServer::writeClient(uint64_t id, Connection& conn) {
+    while (!conn.out.empty()) {
+        ssize_t sent = send(conn.fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.out.erase(0, sent);
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (sent < 0 && errno == EINTR) continue;
+        close(conn.fd);
+        connections_.erase(id);
+        return;
+    }
+    
+    if (conn.preview) {
+        return;
+    }
+    
+    if (!conn.keep_alive) {
+        close(conn.fd);
+        connections_.erase(id);
+        return;
+    }
+    
+    // Interim "100 Continue" went out - keep reading the same request
+    if (conn.parser.headersComplete()) {
+        return;
+    }
+    
+    conn.deadline_ms = millis() + WEB_KEEPALIVE_TIMEOUT_S * 1000;
+    processInput(id, conn);  // Pipelined request may already be buffered
+}
+
+void WebServer::collectResults() {
+    std::deque<Result> done;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        done.swap(results_);
+    }
+    
+    for (Result& result : done) {
+        auto it = connections_.find(result.conn_id);
+        if (it == connections_.end()) continue;
+        Connection& conn = it->second;
+        conn.busy = false;
+        conn.keep_alive = result.keep_alive;
+        conn.out = std::move(result.bytes);
+        writeClient(result.conn_id, conn);
+    }
+}
+
+// ─── Live Preview ────────────────────────────────────────────────────────────
+
+static std::string base64Encode(const uint8_t* data, size_t len) {
+    static const char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = (uint32_t)data[i] << 16;
+        if (i + 1 < len) n |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) n |= data[i + 2];
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += (i + 1 < len) ? table[(n >> 6) & 63] : '=';
+        out += (i + 2 < len) ? table[n & 63] : '=';
+    }
+    return out;
+}
+
+// One SSE event: "<width> <height> <base64 RLE pixels>"
+static std::string previewEvent(const char* type, int w, int h, const std::vector<uint8_t>& rle) {
+    return std::string("event: ") + type + "\ndata: " + std::to_string(w) + " " +
+           std::to_string(h) + " " + base64Encode(rle.data(), rle.size()) + "\n\n";
+}
+
+void WebServer::startPreview(uint64_t id, Connection& conn) {
+    int viewers = 0;
+    for (auto& entry : connections_) {
+        if (entry.second.preview) viewers++;
+    }
+    conn.parser.reset();
     
-    buffer[bytes] = '\0';
-    std::string request(buffer);
+    if (!preview_source_ || viewers >= WEB_PREVIEW_MAX_CLIENTS) {
+        conn.out = HttpResponse(503, "text/plain", "Preview unavailable\n").serialize(false);
+        conn.keep_alive = false;
+        writeClient(id, conn);
+        return;
+    }
     
-    // Parse HTTP request
-    std::istringstream iss(request);
-    std::string method, path, version;
-    iss >> method >> path >> version;
+    conn.preview = true;
+    conn.preview_synced = false;
+    conn.keep_alive = false;
+    conn.out = "HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/event-stream\r\n"
+               "Cache-Control: no-cache\r\n"
+               "Access-Control-Allow-Origin: *\r\n"
+               "Connection: close\r\n\r\n";
     
-    // Extract body for POST
-    std::string body;
-    size_t body_pos = request.find("\r\n\r\n");
-    if (body_pos != std::string::npos) {
-        body = request.substr(body_pos + 4);
+    // Latest frame goes out as a keyframe straight away
+    if (preview_last_.pixelCount() > 0) {
+        std::vector<uint8_t> rle;
+        rleEncode(preview_last_.pixels.data(), preview_last_.pixelCount(), rle);
+        conn.out += previewEvent("key", preview_last_.width, preview_last_.height, rle);
+        conn.preview_synced = true;
+    }
+    std::cout << "[WEB] Preview viewer connected (" << (viewers + 1) << " watching)" << std::endl;
+    writeClient(id, conn);
+}
+
+// Runs on the event loop at most every WEB_PREVIEW_INTERVAL_MS. Frames that
+// arrive faster are superseded in the mailbox; the render thread never
+// waits for viewers.
+void WebServer::pumpPreview() {
+    uint64_t now = millis();
+    if (!preview_source_ || now < next_preview_ms_) return;
+    next_preview_ms_ = now + WEB_PREVIEW_INTERVAL_MS;
+    
+    bool watched = false;
+    for (auto& entry : connections_) {
+        if (entry.second.preview) {
+            watched = true;
+            break;
+        }
+    }
+    if (!watched) return;
+    
+    const Framebuffer* frame = preview_source_->take();
+    if (!frame) return;
+    
+    bool resized = frame->width != preview_last_.width || frame->height != preview_last_.height;
+    if (!resized && memcmp(frame->pixels.data(), preview_last_.pixels.data(), frame->byteCount()) == 0) {
+        return;  // Nothing visible changed
+    }
+    
+    // Delta against the previous broadcast; the keyframe is only built if a viewer needs it
+    std::string delta_event, key_event;
+    if (!resized) {
+        std::vector<uint8_t> diff(frame->byteCount());
+        for (size_t i = 0; i < diff.size(); i++) {
+            diff[i] = frame->pixels[i] ^ preview_last_.pixels[i];
+        }
+        std::vector<uint8_t> rle;
+        rleEncode(diff.data(), frame->pixelCount(), rle);
+        delta_event = previewEvent("delta", frame->width, frame->height, rle);
+    }
+    
+    for (auto& entry : connections_) {
+        Connection& conn = entry.second;
+        if (!conn.preview) continue;
+        
+        // A viewer that can't keep up skips frames and resyncs with a keyframe
+        if (conn.out.size() > WEB_PREVIEW_MAX_BACKLOG) {
+            conn.preview_synced = false;
+            continue;
+        }
+        if (conn.preview_synced && !resized) {
+            conn.out += delta_event;
+        } else {
+            if (key_event.empty()) {
+                std::vector<uint8_t> rle;
+                rleEncode(frame->pixels.data(), frame->pixelCount(), rle);
+                key_event = previewEvent("key", frame->width, frame->height, rle);
+            }
+            conn.out += key_event;
+            conn.preview_synced = true;
+        }
     }
     
-    // Handle request
-    std::string response = handleRequest(method, path, body);
+    preview_last_ = *frame;
+}
+
+// ─── Workers ─────────────────────────────────────────────────────────────────
+
+void* WebServer::workerThread(void* arg) {
+    WebServer* server = (WebServer*)arg;
+    static std::atomic<int> worker_count(0);
+    applyThreadPolicy("web", "led-web-" + std::to_string(++worker_count));
     
-    // Send response
-    send(client_fd, response.c_str(), response.length(), 0);
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(server->queue_mutex_);
+            server->queue_cv_.wait(lock, [server] { return !server->running_ || !server->jobs_.empty(); });
+            if (!server->running_) break;
+            job = std::move(server->jobs_.front());
+            server->jobs_.pop_front();
+        }
+        
+        HttpResponse response;
+        try {
+            response = server->handleRequest(job.request);
+        } catch (const std::exception& e) {
+            std::cerr << "[WEB] Handler error: " << e.what() << std::endl;
+            response = HttpResponse(500, "text/plain", "Internal Server Error\n");
+        }
+        
+        bool keep_alive = job.request.keepAlive();
+        Result result{job.conn_id, response.serialize(keep_alive, job.request.method != "HEAD"), keep_alive};
+        {
+            std::lock_guard<std::mutex> lock(server->queue_mutex_);
+            server->results_.push_back(std::move(result));
+        }
+        server->wake();
+    }
+    
+    return nullptr;
 }
 
-std::string WebServer::handleRequest(const std::string& method, const std::string& path, const std::string& body) {
-    if (path == "/" || path == "/index.html") {
-        std::string html = getConfigPage();
-        std::ostringstream response;
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: text/html\r\n";
-        response << "Content-Length: " << html.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << html;
-        return response.str();
-    }
-    
-    if (path == "/api/config" && method == "GET") {
-        std::string json_str = getCurrentConfig();
-        std::ostringstream response;
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: application/json\r\n";
-        response << "Content-Length: " << json_str.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << json_str;
-        return response.str();
+// ─── Routes ──────────────────────────────────────────────────────────────────
+
+HttpResponse WebServer::handleRequest(const HttpRequest& req) {
+    const std::string& method = req.method;
+    const std::string& path = req.path;
+    
+    if (method == "GET" || method == "HEAD") {
+        if (const WebAsset* asset = findWebAsset(path)) {
+            return serveAsset(req, *asset);
+        }
+    }
+    
+    if (path == "/api/metrics" && (method == "GET" || method == "HEAD")) {
+        return HttpResponse(200, "text/plain; version=0.0.4", metrics().render() + threadPolicyMetrics());
+    }
+    
+    if (path == "/api/trace" && (method == "GET" || method == "HEAD")) {
+        return HttpResponse(200, "application/json", traceDump());
+    }
+    
+    if (path == "/api/trace" && method == "POST") {
+        // {"enabled":true} starts a fresh session, {"enabled":false} freezes it for dumping
+        try {
+            bool enabled = json::parse(req.body).value("enabled", false);
+            traceEnable(enabled);
+            std::cout << "[WEB] Tracing " << (enabled ? "enabled" : "disabled") << std::endl;
+            return HttpResponse(200, "application/json",
+                                enabled ? "{\"status\":\"ok\",\"enabled\":true}"
+                                        : "{\"status\":\"ok\",\"enabled\":false}");
+        } catch (const json::exception&) {
+            return HttpResponse(400, "application/json", "{\"status\":\"error\"}");
+        }
+    }
+    
+    if (path == "/api/config" && (method == "GET" || method == "HEAD")) {
+        return HttpResponse(200, "application/json", getCurrentConfig());
     }
     
     if (path == "/api/config" && method == "POST") {
-        bool success = saveConfig(body);
-        std::string json_str = success ? "{\"status\":\"ok\"}" : "{\"status\":\"error\"}";
-        std::ostringstream response;
-        response << "HTTP/1.1 " << (success ? "200 OK" : "400 Bad Request") << "\r\n";
-        response << "Content-Type: application/json\r\n";
-        response << "Content-Length: " << json_str.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << json_str;
-        return response.str();
+        bool success = saveConfig(req.body);
+        return HttpResponse(success ? 200 : 400, "application/json",
+                            success ? "{\"status\":\"ok\"}" : "{\"status\":\"error\"}");
     }
     
     if (path == "/api/testmode" && method == "POST") {
-        // Toggle test mode
+        // Toggle test mode (workers run concurrently, so guard the flag).
+        // A body of {"pattern":"checker"} switches straight to that pattern.
+        static std::mutex test_mode_mutex;
         static bool test_mode_enabled = false;
-        test_mode_enabled = !test_mode_enabled;
+        std::lock_guard<std::mutex> lock(test_mode_mutex);
+        
+        std::string pattern;
+        try {
+            if (!req.body.empty()) {
+                pattern = json::parse(req.body).value("pattern", "");
+            }
+        } catch (const json::exception&) {
+            return HttpResponse(400, "application/json", "{\"status\":\"error\"}");
+        }
+        test_mode_enabled = pattern.empty() ? !test_mode_enabled : (pattern != "none");
         
         // Write test mode state to a file that main.cpp can read
         std::ofstream testfile("/tmp/led-matrix-testmode");
         testfile << (test_mode_enabled ? "1" : "0");
+        if (test_mode_enabled && !pattern.empty()) {
+            testfile << " " << pattern;
+        }
         testfile.close();
         
         std::cout << "[WEB] Test mode " << (test_mode_enabled ? "enabled" : "disabled") << std::endl;
         
-        std::string json_str = test_mode_enabled ? 
+        return HttpResponse(200, "application/json", test_mode_enabled ? 
             "{\"status\":\"ok\",\"enabled\":true}" : 
-            "{\"status\":\"ok\",\"enabled\":false}";
-        std::ostringstream response;
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: application/json\r\n";
-        response << "Content-Length: " << json_str.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << json_str;
-        return response.str();
+            "{\"status\":\"ok\",\"enabled\":false}");
     }
     
     if (path == "/api/reboot" && method == "POST") {
@@ -181,412 +648,38 @@ std::string WebServer::handleRequest(const std::string& method, const std::strin
             system("sudo reboot");
             exit(0);
         }
-        std::string json_str = "{\"status\":\"ok\"}";
-        std::ostringstream response;
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: application/json\r\n";
-        response << "Content-Length: " << json_str.length() << "\r\n";
-        response << "Connection: close\r\n\r\n";
-        response << json_str;
-        return response.str();
+        return HttpResponse(200, "application/json", "{\"status\":\"ok\"}");
     }
     
     // 404
-    std::string not_found = "<!DOCTYPE html><html><body><h1>404 Not Found</h1></body></html>";
-    std::ostringstream response;
-    response << "HTTP/1.1 404 Not Found\r\n";
-    response << "Content-Type: text/html\r\n";
-    response << "Content-Length: " << not_found.length() << "\r\n";
-    response << "Connection: close\r\n\r\n";
-    response << not_found;
-    return response.str();
+    return HttpResponse(404, "text/html", "<!DOCTYPE html><html><body><h1>404 Not Found</h1></body></html>");
 }
 
-std::string WebServer::getConfigPage() {
-    return R"HTMLDOC(<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title id="pageTitle">LED Matrix Config</title>
-    <style>
-        * { margin: 0; padding: 0; box-sizing: border-box; }
-        body {
-            font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif;
-            background: rgb(23, 136, 202);
-            min-height: 100vh;
-            display: flex;
-            flex-direction: column;
-            align-items: center;
-            justify-content: center;
-            padding: 20px;
-        }
-        .logo-container {
-            text-align: center;
-            margin-bottom: 20px;
-        }
-        .logo-container svg {
-            width: 50%;
-            max-width: 450px;
-            height: auto;
-        }
-        .container {
-            background: white;
-            border-radius: 16px;
-            box-shadow: 0 20px 60px rgba(0,0,0,0.3);
-            padding: 40px;
-            max-width: 500px;
-            width: 100%;
-        }
-        h1 {
-            color: #333;
-            margin-bottom: 10px;
-            font-size: 28px;
-        }
-        .subtitle {
-            color: #666;
-            margin-bottom: 30px;
-            font-size: 14px;
-        }
-        .form-group {
-            margin-bottom: 25px;
-        }
-        label {
-            display: block;
-            color: #555;
-            font-weight: 600;
-            margin-bottom: 8px;
-            font-size: 14px;
-        }
-        input, select {
-            width: 100%;
-            padding: 12px 16px;
-            border: 2px solid #e0e0e0;
-            border-radius: 8px;
-            font-size: 15px;
-            transition: all 0.2s;
-        }
-        input:focus, select:focus {
-            outline: none;
-            border-color: #667eea;
-            box-shadow: 0 0 0 3px rgba(102, 126, 234, 0.1);
-        }
-        .toggle-group {
-            display: flex;
-            gap: 10px;
-            margin-top: 8px;
-        }
-        .toggle-btn {
-            flex: 1;
-            padding: 10px;
-            border: 2px solid #e0e0e0;
-            border-radius: 8px;
-            background: white;
-            cursor: pointer;
-            font-weight: 600;
-            transition: all 0.2s;
-        }
-        .toggle-btn:hover {
-            border-color: #667eea;
-        }
-        .toggle-btn.active {
-            background: #667eea;
-            color: white;
-            border-color: #667eea;
-        }
-        #staticFields {
-            margin-top: 15px;
-            padding: 20px;
-            background: #f8f9fa;
-            border-radius: 8px;
-            display: none;
-        }
-        #staticFields.show {
-            display: block;
-        }
-        .btn-primary {
-            width: 100%;
-            padding: 14px;
-            background: linear-gradient(135deg, rgb(23, 136, 202) 0%, rgb(18, 108, 161) 100%);
-            color: white;
-            border: none;
-            border-radius: 8px;
-            font-size: 16px;
-            font-weight: 600;
-            cursor: pointer;
-            transition: all 0.2s;
-        }
-        .btn-primary:hover {
-            transform: translateY(-2px);
-            box-shadow: 0 10px 20px rgba(23, 136, 202, 0.4);
-        }
-        .btn-primary:active {
-            transform: translateY(0);
-        }
-        .btn-reboot {
-            width: 100%;
-            padding: 12px;
-            margin-top: 15px;
-            background: linear-gradient(135deg, rgb(35, 164, 244) 0%, rgb(23, 136, 202) 100%);
-            color: white;
-            border: none;
-            border-radius: 8px;
-            font-size: 15px;
-            font-weight: 600;
-            cursor: pointer;
-            transition: all 0.2s;
-        }
-        .btn-reboot:hover {
-            transform: translateY(-2px);
-            box-shadow: 0 10px 20px rgba(35, 164, 244, 0.4);
-        }
-        .btn-reboot:active {
-            transform: translateY(0);
-        }
-        .status {
-            margin-top: 20px;
-            padding: 12px;
-            border-radius: 8px;
-            text-align: center;
-            font-weight: 600;
-            display: none;
-        }
-        .status.success {
-            background: #d4edda;
-            color: #155724;
-            display: block;
-        }
-        .status.error {
-            background: #f8d7da;
-            color: #721c24;
-            display: block;
-        }
-        .current-ip {
-            background: #e7f3ff;
-            padding: 15px;
-            border-radius: 8px;
-            margin-bottom: 25px;
-            border-left: 4px solid #667eea;
-        }
-        .current-ip strong {
-            color: #667eea;
-        }
-    </style>
-</head>
-<body>
-    <div class="logo-container">
-        <svg version="1.0" xmlns="http://www.w3.org/2000/svg" viewBox="0 0 657.1 240">
-            <path fill="#FFFFFF" d="M435.25,98.27c9.3-10.68,18.49-21.27,27.56-31.76c1.85-2.12,3.99-4.62,7.01-4.79c1.77-0.11,3.61-0.15,5.49-0.12c12.29,0.12,24.05,0.15,35.3,0.09c1.04-0.01,1.19,0.37,0.47,1.13l-40.57,42.53c-0.39,0.41-0.45,1.03-0.14,1.51l45.38,71.37c0.45,0.71,0.27,1.07-0.57,1.07l-43.28-0.01c-0.47,0-0.82-0.2-1.07-0.6l-27.2-45.13c-0.18-0.29-0.59-0.34-0.83-0.1l-8.05,8.26c-0.32,0.32-0.49,0.76-0.49,1.21l-0.02,35.89c0,0.27-0.21,0.48-0.47,0.48l-36.58-0.04c-0.49,0-0.9-0.42-0.9-0.93V62.9c0-0.81,0.4-1.22,1.19-1.22l36.21,0.04c0.32,0,0.58,0.26,0.58,0.58l0.01,35.6C434.28,98.89,434.61,99.01,435.25,98.27z"/>
-            <path fill="#FFFFFF" d="M314.86,141.61c-0.36-0.01-0.64,0.27-0.65,0.62v35.16c0,0.37-0.3,0.67-0.67,0.67l-37.9-0.01c-0.34,0-0.62-0.28-0.62-0.62l0.01-116.34c0-0.15,0.12-0.27,0.28-0.27c20.27-0.16,40.15-0.13,59.65,0.09c6.38,0.07,12.73,0.98,19.05,2.72c16.02,4.42,25.29,14.33,27.84,29.74c1.19,7.24,0.59,14.73-1.82,22.48C371.34,143.69,338.01,142.32,314.86,141.61z M315.43,89.03l-0.05,24.92c0,0.23,0.19,0.42,0.42,0.42l14.88,0.02c8.48,0.01,15.36-5.28,15.37-11.82v-2.07c0.01-6.54-6.85-11.85-15.33-11.87l-14.88-0.02C315.62,88.61,315.43,88.8,315.43,89.03z"/>
-            <path fill="#FFFFFF" d="M571.55,151.6c16.44-0.06,33.01-0.05,49.71,0.05c2.23,0.01,4.55,0.11,6.96,0.26c0.55,0.04,0.83,0.33,0.83,0.87l0.12,24.38c0,0.61-0.31,0.9-0.93,0.9l-96.57,0.01c-0.34,0-0.62-0.28-0.62-0.62l0.01-115.92c0-0.18,0.14-0.32,0.32-0.32c23.03-0.04,47.93-0.05,74.68-0.01c6.67,0.01,13.64,0.13,20.92,0.37c0.42,0.01,0.64,0.23,0.65,0.63c0.32,8.58,0.3,16.92-0.06,25.02c-0.04,0.94-0.53,1.4-1.47,1.4h-55.23c-0.35,0-0.62,0.27-0.62,0.61l0.05,15.69c0,0.47,0.36,0.85,0.83,0.85l46.58-0.09c0.22,0,0.33,0.11,0.33,0.34l0.01,26.62c0,0.87-0.42,1.31-1.26,1.31l-45.93,0.08c-0.4,0-0.6,0.19-0.6,0.57l0.04,15.77C570.29,151.07,570.85,151.61,571.55,151.6z"/>
-            <path fill="#FFFFFF" d="M256.69,107c7.09,31.42-11.98,62.34-43.02,69.99c-5.32,1.31-13.55,1.89-24.68,1.74c-14.12-0.18-28.26-0.18-42.39,0c-0.65,0.01-0.98-0.32-1.66-0.97v-13.57c0.68-0.47,0.92-0.74,1.38-0.82c13.39-2.17,23.58-8.17,30.59-18.01c11.17-15.69,11.09-35.91-0.43-51.21c-7.22-9.57-17.26-15.35-30.16-17.33c-0.48-0.09-0.72-0.36-0.16-0.83V62.15c-0.54-0.51-0.28-0.77,0.23-0.77c18.61-0.11,36.15-0.09,52.63,0.06C226.84,61.68,250.54,79.71,256.69,107z M151.5,68.2c-0.78,1.7,0,3.63,1.92,4.2c3.8,1.14,7.62,2.23,11.12,4.04c24.26,12.58,33.66,42.99,20.45,67.06c-6.39,11.65-18.12,21.44-31.8,24.56c-1.79,0.4-2.34,1.68-1.67,3.82c0.18,0.58,0.72,0.97,1.32,0.96c14.38-0.11,28.97-0.1,43.78,0.06c5.95,0.06,11.21-0.48,15.77-1.62c21.1-5.28,37.35-23.4,39.67-45.4c1.19-11.32-0.88-21.73-6.21-31.23c-7.23-12.89-18.19-21.44-32.91-25.65c-4.48-1.29-9.97-1.9-16.45-1.85c-13.01,0.11-25.33,0.15-36.96,0.1c-2.41-0.01-4.7,0.04-6.86,0.15C152.13,67.44,151.73,67.7,151.5,68.2z"/>
-            <path fill="#FFFFFF" d="M102.1,103.49c-3.37,7.71-4.34,15.57-2.88,23.58c3.53,19.49,18.63,33.44,38.32,36.14c0.42,0.06,0.74,0.43,0.04,0.85v13.73c0.66,0.61,0.36,0.92-0.26,0.91c-17.33-0.07-35.07-0.16-53.24-0.26c-16.8-0.1-30.76-5.97-41.9-17.62c-23.12-24.19-21.74-61.89,3-84.36c13.86-12.57,29.17-15.4,47.85-15.22c15.72,0.16,30.44,0.17,44.16,0.01c0.65-0.01,0.98,0.32,1.6,0.97V76c-0.49,0.62-0.99,1.13-1.62,1.11c-1.59-0.01-3.14,0.18-4.62,0.59C118.03,81.65,107.88,90.25,102.1,103.49z M85.83,67.17C67,66.99,50.68,75.65,40.22,91.08c-9.13,13.49-11.44,31.58-5.65,46.71c8.59,22.37,27.7,35.26,51.75,35.09c17.11-0.12,32.18-0.12,45.18,0c0.64,0.01,0.96-0.31-0.05-0.94v-2.58c1-0.58,0.61-1.08,0.06-1.23c-13.46-3.43-23.7-10.56-30.72-21.38c-18.77-28.95-2.49-67.33,30.66-74.47c0.66-0.15,0.99-0.56,1.23-1.24v-2.9c-0.27-0.6-0.58-0.91-1.18-0.89C116.56,67.35,101.35,67.33,85.83,67.17z"/>
-        </svg>
-    </div>
-    <div class="container">
-        <h1>🌐 Network Config</h1>
-        <div class="subtitle">LED Matrix Controller</div>
-        
-        <div class="current-ip" id="currentIP">
-            <strong>Current IP:</strong> <span id="ipDisplay">Loading...</span>
-        </div>
-        
-        <form id="configForm">
-            <div class="form-group">
-                <label>Hostname</label>
-                <input type="text" id="hostname" placeholder="led-matrix" pattern="[a-zA-Z0-9-]+">
-            </div>
-            
-            <div class="form-group">
-                <label>Network Mode</label>
-                <div class="toggle-group">
-                    <button type="button" class="toggle-btn active" data-mode="dhcp">DHCP</button>
-                    <button type="button" class="toggle-btn" data-mode="static">Static</button>
-                </div>
-            </div>
-            
-            <div id="staticFields">
-                <div class="form-group">
-                    <label>Static IP Address</label>
-                    <input type="text" id="staticIP" placeholder="10.1.1.22" pattern="\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}">
-                </div>
-                <div class="form-group">
-                    <label>Subnet Mask</label>
-                    <input type="text" id="subnet" placeholder="255.255.255.0" pattern="\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}">
-                </div>
-                <div class="form-group">
-                    <label>Gateway</label>
-                    <input type="text" id="gateway" placeholder="10.1.1.1" pattern="\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}">
-                </div>
-            </div>
-            
-            <div class="form-group">
-                <label>UDP Port</label>
-                <input type="number" id="udpPort" placeholder="21324" min="1024" max="65535">
-            </div>
-            
-            <button type="submit" class="btn-primary">💾 Save & Apply</button>
-        </form>
-        
-        <button id="testModeBtn" class="btn-reboot" onclick="toggleTestMode()">🎨 Toggle Test Pattern</button>
-        <button id="rebootBtn" class="btn-reboot" onclick="rebootDevice()">🔄 Reboot Device</button>
-        
-        <div class="status" id="status"></div>
-    </div>
-    
-    <script>
-        const form = document.getElementById('configForm');
-        const toggleBtns = document.querySelectorAll('.toggle-btn');
-        const staticFields = document.getElementById('staticFields');
-        const status = document.getElementById('status');
-        let currentMode = 'dhcp';
-        let testModeActive = false;
-        
-        // Load current config
-        fetch('/api/config')
-            .then(r => r.json())
-            .then(data => {
-                const currentIP = data.currentIP || 'Unknown';
-                const hostname = data.hostname || 'led-matrix';
-                
-                document.getElementById('ipDisplay').textContent = currentIP;
-                document.getElementById('hostname').value = hostname;
-                document.getElementById('udpPort').value = data.udpPort || 21324;
-                
-                // Update page title
-                document.getElementById('pageTitle').textContent = hostname + ' (' + currentIP + ')';
-                
-                if (data.mode === 'static') {
-                    currentMode = 'static';
-                    toggleBtns[1].click();
-                    document.getElementById('staticIP').value = data.staticIP || '';
-                    document.getElementById('subnet').value = data.subnet || '255.255.255.0';
-                    document.getElementById('gateway').value = data.gateway || '';
-                }
-            })
-            .catch(e => console.error('Failed to load config:', e));
-        
-        // Toggle DHCP/Static
-        toggleBtns.forEach(btn => {
-            btn.addEventListener('click', () => {
-                toggleBtns.forEach(b => b.classList.remove('active'));
-                btn.classList.add('active');
-                currentMode = btn.dataset.mode;
-                staticFields.classList.toggle('show', currentMode === 'static');
-            });
-        });
-        
-        // Form submit
-        form.addEventListener('submit', async (e) => {
-            e.preventDefault();
-            
-            const config = {
-                mode: currentMode,
-                hostname: document.getElementById('hostname').value || 'led-matrix',
-                udpPort: parseInt(document.getElementById('udpPort').value) || 21324
-            };
-            
-            if (currentMode === 'static') {
-                config.staticIP = document.getElementById('staticIP').value;
-                config.subnet = document.getElementById('subnet').value;
-                config.gateway = document.getElementById('gateway').value;
-                
-                if (!config.staticIP || !config.subnet || !config.gateway) {
-                    showStatus('Please fill all static IP fields', 'error');
-                    return;
-                }
-            }
-            
-            try {
-                if (currentMode === 'static') {
-                    const newIP = config.staticIP;
-                    showStatus('⏳ Applying static IP ' + newIP + '...', 'success');
-                } else {
-                    showStatus('⏳ Switching to DHCP...', 'success');
-                }
-                
-                const response = await fetch('/api/config', {
-                    method: 'POST',
-                    headers: { 'Content-Type': 'application/json' },
-                    body: JSON.stringify(config)
-                });
-                
-                const result = await response.json();
-                
-                if (result.status === 'ok') {
-                    if (currentMode === 'static') {
-                        const newIP = config.staticIP;
-                        showStatus('✓ Static IP applied! Redirecting to http://' + newIP + ':8080', 'success');
-                        setTimeout(() => {
-                            window.location.href = 'http://' + newIP + ':8080';
-                        }, 2000);
-                    } else {
-                        showStatus('✓ DHCP enabled! Page will reload in 5 seconds...', 'success');
-                        setTimeout(() => {
-                            window.location.reload();
-                        }, 5000);
-                    }
-                } else {
-                    showStatus('Failed to save config', 'error');
-                }
-            } catch (e) {
-                if (currentMode === 'static') {
-                    const newIP = config.staticIP;
-                    showStatus('Network changed! Redirecting to http://' + newIP + ':8080', 'success');
-                    setTimeout(() => {
-                        window.location.href = 'http://' + newIP + ':8080';
-                    }, 2000);
-                } else {
-                    showStatus('Network error: ' + e.message, 'error');
-                }
-            }
-        });
-        
-        function showStatus(message, type) {
-            status.textContent = message;
-            status.className = 'status ' + type;
-            setTimeout(() => {
-                status.className = 'status';
-            }, 5000);
-        }
-        
-        async function toggleTestMode() {
-            try {
-                const response = await fetch('/api/testmode', { method: 'POST' });
-                const result = await response.json();
-                testModeActive = result.enabled;
-                const btn = document.getElementById('testModeBtn');
-                btn.textContent = testModeActive ? '⏹️ Stop Test Pattern' : '🎨 Toggle Test Pattern';
-                showStatus(testModeActive ? '✓ Test pattern enabled' : '✓ Test pattern disabled', 'success');
-            } catch (e) {
-                showStatus('Failed to toggle test mode', 'error');
-            }
-        }
-        
-        async function rebootDevice() {
-            if (!confirm('Reboot the LED Matrix controller? Display will be offline for ~30 seconds.')) {
-                return;
-            }
-            
-            try {
-                showStatus('🔄 Rebooting...', 'success');
-                await fetch('/api/reboot', { method: 'POST' });
-                setTimeout(() => {
-                    showStatus('⏳ Device rebooting... Page will reload in 45 seconds', 'success');
-                    setTimeout(() => {
-                        window.location.reload();
-                    }, 45000);
-                }, 500);
-            } catch (e) {
-                showStatus('Reboot command sent (connection closed)', 'success');
-                setTimeout(() => {
-                    window.location.reload();
-                }, 45000);
-            }
-        }
-    </script>
-</body>
-</html>)HTMLDOC";
+// Static UI files are embedded pre-compressed; repeat loads revalidate to a 304
+HttpResponse WebServer::serveAsset(const HttpRequest& req, const WebAsset& asset) {
+    bool gzip = req.header("accept-encoding").find("gzip") != std::string::npos;
+    const char* etag = gzip ? asset.etag_gzip : asset.etag;
+    
+    HttpResponse response(200, asset.content_type);
+    response.headers.push_back({"ETag", etag});
+    response.headers.push_back({"Cache-Control", "no-cache"});
+    response.headers.push_back({"Vary", "Accept-Encoding"});
+    
+    std::string if_none_match = req.header("if-none-match");
+    if (!if_none_match.empty() &&
+        (if_none_match == "*" || if_none_match.find(etag) != std::string::npos)) {
+        response.status = 304;
+        response.content_type.clear();
+        return response;
+    }
+    
+    if (gzip) {
+        response.headers.push_back({"Content-Encoding", "gzip"});
+        response.body.assign((const char*)asset.gzip_data, asset.gzip_size);
+    } else {
+        response.body.assign((const char*)asset.data, asset.size);
+    }
+    return response;
 }
 
 std::string WebServer::getCurrentConfig() {
@@ -643,6 +736,7 @@ std::string WebServer::getCurrentConfig() {
 }
 
 bool WebServer::saveConfig(const std::string& json_str) {
+    TRACE_SPAN("saveConfig");
     try {
         json config = json::parse(json_str);
         
@@ -1,31 +1,112 @@
 // web_server.h - Simple HTTP server for network configuration
+//
+// One poll() loop owns every socket (non-blocking, HTTP/1.1 keep-alive,
+// per-connection timeouts); complete requests are handed to a small, bounded
+// pool of worker threads so a slow handler never stalls other clients.
+// /api/preview clients stay connected and receive the live frame as a
+// Server-Sent Events stream, written by the event loop itself.
 
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
-#include <functional>
+#include <vector>
+#include <pthread.h>
+#include "http_parser.h"
+#include "framebuffer.h"
+
+class FrameMailbox;
+
+#define WEB_WORKER_THREADS       2
+#define WEB_MAX_QUEUED_REQUESTS  16
+#define WEB_MAX_CONNECTIONS      32
+#define WEB_KEEPALIVE_TIMEOUT_S  5     // Idle time allowed between requests
+#define WEB_REQUEST_TIMEOUT_S    10    // Time allowed to receive one request
+#define WEB_PREVIEW_INTERVAL_MS  100   // Preview frame rate cap (10 fps)
+#define WEB_PREVIEW_MAX_CLIENTS  8
+#define WEB_PREVIEW_MAX_BACKLOG  (64 * 1024)  // Unsent bytes before a viewer skips frames
 
 class WebServer {
 public:
     WebServer(int port = 8080);
     ~WebServer();
-    
+
     void start();
     void stop();
     
+    // Source of presented frames for /api/preview (set before start())
+    void setPreviewSource(FrameMailbox* mailbox) { preview_source_ = mailbox; }
+
 private:
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        HttpParser parser;
+        bool busy;             // Request is with a worker
+        bool keep_alive;
+        bool read_closed;      // Peer shut down its side; answer what it sent, then close
+        bool continue_sent;
+        bool preview;          // Long-lived /api/preview event stream
+        bool preview_synced;   // Viewer holds the last broadcast frame (deltas apply)
+        uint64_t deadline_ms;  // Closed if nothing happens before this
+    };
+
+    struct Job {
+        uint64_t conn_id;
+        HttpRequest request;
+    };
+
+    struct Result {
+        uint64_t conn_id;
+        std::string bytes;
+        bool keep_alive;
+    };
+
     int port_;
     int server_fd_;
-    bool running_;
+    int wake_pipe_[2];
+    std::atomic<bool> running_;
+    pthread_t server_thread_;
+    std::vector<pthread_t> worker_threads_;
+
+    std::map<uint64_t, Connection> connections_;  // Server thread only
+    uint64_t next_conn_id_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<Job> jobs_;
+    std::deque<Result> results_;
     
-    void handleClient(int client_fd);
-    std::string handleRequest(const std::string& method, const std::string& path, const std::string& body);
-    std::string getConfigPage();
+    FrameMailbox* preview_source_;
+    Framebuffer preview_last_;  // Last frame broadcast to viewers
+    uint64_t next_preview_ms_;
+
+    void eventLoop();
+    void acceptClients();
+    void readClient(uint64_t id, Connection& conn);
+    void writeClient(uint64_t id, Connection& conn);
+    void processInput(uint64_t id, Connection& conn);
+    void rejectRequest(uint64_t id, Connection& conn, int status);
+    void collectResults();
+    void wake();
+    void startPreview(uint64_t id, Connection& conn);
+    void pumpPreview();
+
+    HttpResponse handleRequest(const HttpRequest& req);
+    HttpResponse serveAsset(const HttpRequest& req, const struct WebAsset& asset);
     std::string getCurrentConfig();
     bool saveConfig(const std::string& json);
-    
+
     static void* serverThread(void* arg);
+    static void* workerThread(void* arg);
+    static uint64_t millis();
 };
 
 #endif // WEB_SERVER_H